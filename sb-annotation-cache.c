@@ -0,0 +1,226 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-annotation-cache.h"
+
+/* The finished loads of the recently annotated files, whether they were
+ * shown or prefetched. A load only gets handed out while neither its file
+ * nor the history of the repository changed. The churn of a file is kept
+ * in the same place, under its own key.
+ *
+ * The entries are kept in a queue with the most recently used one at the
+ * head; the tail gets dropped when the cache is full.
+ */
+
+#define MAX_ENTRIES 32
+
+static GQueue    * entries = NULL; /* of SbHistoryLoader and SbChurn */
+static GHashTable* links   = NULL; /* "flags:revision:path" or "churn:path" => link in entries */
+
+static gchar*
+cache_key (gchar const* file_path,
+	   gchar const* revision,
+	   guint        flags)
+{
+	return g_strdup_printf ("%x:%s:%s", flags, revision ? revision : "", file_path);
+}
+
+static gchar*
+cache_churn_key (gchar const* file_path)
+{
+	return g_strdup_printf ("churn:%s", file_path);
+}
+
+static gchar*
+cache_entry_key (gpointer entry)
+{
+	if (SB_IS_CHURN (entry)) {
+		return cache_churn_key (sb_churn_get_file_path (entry));
+	}
+
+	return cache_key (sb_history_loader_get_file_path (entry),
+			  sb_history_loader_get_revision (entry),
+			  sb_history_loader_get_flags (entry));
+}
+
+static gboolean
+cache_entry_is_current (gpointer entry)
+{
+	if (SB_IS_CHURN (entry)) {
+		return sb_churn_is_current (entry);
+	}
+
+	return sb_history_loader_is_current (entry);
+}
+
+static void
+cache_ensure (void)
+{
+	if (G_LIKELY (entries)) {
+		return;
+	}
+
+	entries = g_queue_new ();
+	links   = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+}
+
+static void
+cache_remove (gchar const* key,
+	      GList      * link)
+{
+	g_object_unref (link->data);
+	g_queue_delete_link (entries, link);
+	g_hash_table_remove (links, key);
+}
+
+/* takes the key */
+static GList*
+cache_find (gchar* key)
+{
+	GList* link;
+
+	cache_ensure ();
+
+	link = g_hash_table_lookup (links, key);
+	if (link && !cache_entry_is_current (link->data)) {
+		cache_remove (key, link);
+		link = NULL;
+	}
+	g_free (key);
+
+	return link;
+}
+
+static void
+cache_use (GList* link)
+{
+	g_queue_unlink         (entries, link);
+	g_queue_push_head_link (entries, link);
+}
+
+static void
+cache_add (gpointer entry)
+{
+	gchar* key;
+	GList* link;
+
+	cache_ensure ();
+
+	key = cache_entry_key (entry);
+	link = g_hash_table_lookup (links, key);
+	if (link) {
+		cache_remove (key, link);
+	}
+
+	g_queue_push_head (entries, g_object_ref (entry));
+	g_hash_table_insert (links, key, entries->head);
+
+	if (entries->length > MAX_ENTRIES) {
+		key = cache_entry_key (g_queue_peek_tail (entries));
+		cache_remove (key, entries->tail);
+		g_free (key);
+	}
+}
+
+/* the caller doesn't own the returned loader */
+SbHistoryLoader*
+sb_annotation_cache_lookup (gchar const* file_path,
+			    guint        flags)
+{
+	return sb_annotation_cache_lookup_revision (file_path, NULL, flags);
+}
+
+/* the blame of the file as it was in @revision (NULL for the working
+ * copy); the caller doesn't own the returned loader */
+SbHistoryLoader*
+sb_annotation_cache_lookup_revision (gchar const* file_path,
+				     gchar const* revision,
+				     guint        flags)
+{
+	GList* link;
+
+	g_return_val_if_fail (file_path, NULL);
+
+	link = cache_find (cache_key (file_path, revision, flags));
+	if (!link) {
+		return NULL;
+	}
+
+	cache_use (link);
+
+	return link->data;
+}
+
+/* like sb_annotation_cache_lookup() without counting as a use */
+gboolean
+sb_annotation_cache_contains (gchar const* file_path,
+			      guint        flags)
+{
+	g_return_val_if_fail (file_path, FALSE);
+
+	return cache_find (cache_key (file_path, NULL, flags)) != NULL;
+}
+
+void
+sb_annotation_cache_insert (SbHistoryLoader* loader)
+{
+	g_return_if_fail (SB_IS_HISTORY_LOADER (loader));
+	g_return_if_fail (sb_history_loader_is_done (loader));
+
+	if (sb_history_loader_has_failed (loader) ||
+	    sb_history_loader_get_contents (loader, NULL))
+	{
+		/* the next load gets another try; an edited text is gone
+		 * with the next edit */
+		return;
+	}
+
+	cache_add (loader);
+}
+
+/* the caller doesn't own the returned churn */
+SbChurn*
+sb_annotation_cache_lookup_churn (gchar const* file_path)
+{
+	GList* link;
+
+	g_return_val_if_fail (file_path, NULL);
+
+	link = cache_find (cache_churn_key (file_path));
+	if (!link) {
+		return NULL;
+	}
+
+	cache_use (link);
+
+	return link->data;
+}
+
+void
+sb_annotation_cache_insert_churn (SbChurn* churn)
+{
+	g_return_if_fail (SB_IS_CHURN (churn));
+	g_return_if_fail (sb_churn_is_done (churn));
+
+	cache_add (churn);
+}
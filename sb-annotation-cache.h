@@ -0,0 +1,46 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_ANNOTATION_CACHE_H
+#define SB_ANNOTATION_CACHE_H
+
+#include "sb-churn.h"
+#include "sb-history-loader.h"
+
+G_BEGIN_DECLS
+
+SbHistoryLoader* sb_annotation_cache_lookup   (gchar const    * file_path,
+					       guint            flags);
+gboolean         sb_annotation_cache_contains (gchar const    * file_path,
+					       guint            flags);
+void             sb_annotation_cache_insert   (SbHistoryLoader* loader);
+SbHistoryLoader* sb_annotation_cache_lookup_revision (gchar const* file_path,
+						      gchar const* revision,
+						      guint        flags);
+
+SbChurn*         sb_annotation_cache_lookup_churn (gchar const* file_path);
+void             sb_annotation_cache_insert_churn (SbChurn    * churn);
+
+G_END_DECLS
+
+#endif /* !SB_ANNOTATION_CACHE_H */
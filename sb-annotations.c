@@ -23,21 +23,61 @@
 
 #include "sb-annotations.h"
 
+#include "sb-marshallers.h"
 #include "sb-reference-label.h"
 
+#include <time.h>
+
+// FIXME: keep in sync with the width of the annotations
+#define LABEL_WIDTH 100
+
 struct _SbAnnotationsPrivate {
 	GList      * references;
 	GtkTextView* text_view;
+	SbColorMap * colors;
+
+	/* SbRevision => RevisionCache; shared by all hunks of a revision */
+	GHashTable * revisions;
+
+	/* not ours; maps the lines of the references through the edits */
+	SbLineMap  * line_map;
+	guint        layout_idle;
 };
 
+/* built when first needed: most labels are never hovered */
+typedef struct {
+	PangoLayout* layout;
+	gchar      * tooltip;
+	gboolean     complete;      /* the tooltip has the full message */
+} RevisionCache;
+
 enum {
 	PROP_0,
 	PROP_REFERENCES,
 	PROP_TEXT_VIEW
 };
 
+enum {
+	REFERENCE_CLICKED,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
 G_DEFINE_TYPE (SbAnnotations, sb_annotations, GTK_TYPE_LAYOUT);
 
+static void
+revision_cache_free (gpointer data)
+{
+	RevisionCache* cache = data;
+
+	if (cache->layout) {
+		g_object_unref (cache->layout);
+	}
+	g_free (cache->tooltip);
+	g_slice_free (RevisionCache, cache);
+}
+
 static void
 sb_annotations_init (SbAnnotations* self)
 {
@@ -48,6 +88,9 @@ sb_annotations_init (SbAnnotations* self)
 						      SbAnnotationsPrivate);
 
 	gtk_widget_set_size_request (result, 100, 100);
+
+	self->_private->revisions = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+							   NULL, revision_cache_free);
 }
 
 static void
@@ -57,10 +100,25 @@ annotations_dispose (GObject* object)
 
 	sb_annotations_set_references (self, NULL);
 	sb_annotations_set_text_view  (self, NULL); // FIXME: should go into destroy()
+	sb_annotations_set_color_map  (self, NULL);
+	if (self->_private->layout_idle) {
+		g_source_remove (self->_private->layout_idle);
+		self->_private->layout_idle = 0;
+	}
 
 	G_OBJECT_CLASS (sb_annotations_parent_class)->dispose (object);
 }
 
+static void
+annotations_finalize (GObject* object)
+{
+	SbAnnotations* self = SB_ANNOTATIONS (object);
+
+	g_hash_table_destroy (self->_private->revisions);
+
+	G_OBJECT_CLASS (sb_annotations_parent_class)->finalize (object);
+}
+
 static void
 annotations_set_property (GObject     * object,
 			  guint         prop_id,
@@ -82,6 +140,18 @@ annotations_set_property (GObject     * object,
 	}
 }
 
+static gint
+annotations_map_line (SbAnnotations* self,
+		      guint          line)
+{
+	if (self->_private->line_map) {
+		line = sb_line_map_get_line (self->_private->line_map, line);
+	}
+
+	/* the references count from 1, the buffer from 0 */
+	return line - 1;
+}
+
 static void
 annotations_layout (SbAnnotations* self)
 {
@@ -95,7 +165,7 @@ annotations_layout (SbAnnotations* self)
 		gint         height = 0;
 		gtk_text_buffer_get_iter_at_line (gtk_text_view_get_buffer (self->_private->text_view),
 						  &iter,
-						  sb_reference_get_current_start (sb_reference_label_get_reference (iterator->data)) - 1);
+						  annotations_map_line (self, sb_reference_get_current_start (sb_reference_label_get_reference (iterator->data))));
 		gtk_text_view_get_line_yrange    (self->_private->text_view,
 						  &iter,
 						  &offset,
@@ -106,13 +176,13 @@ annotations_layout (SbAnnotations* self)
 				 offset);
 		gtk_text_buffer_get_iter_at_line (gtk_text_view_get_buffer (self->_private->text_view),
 						  &iter,
-						  sb_reference_get_current_end (sb_reference_label_get_reference (iterator->data)) - 1);
+						  annotations_map_line (self, sb_reference_get_current_end (sb_reference_label_get_reference (iterator->data))));
 		gtk_text_view_get_line_yrange    (self->_private->text_view,
 						  &iter,
 						  &offset2,
 						  &height);
 		gtk_widget_set_size_request (iterator->data,
-						     -1,
+						     LABEL_WIDTH,
 						     MAX (-1, offset2 + height - offset));
 	}
 
@@ -127,6 +197,9 @@ annotations_style_set (GtkWidget* widget,
 		GTK_WIDGET_CLASS (sb_annotations_parent_class)->style_set (widget, old_style);
 	}
 
+	/* the layouts have the old font */
+	g_hash_table_remove_all (SB_ANNOTATIONS (widget)->_private->revisions);
+
 	annotations_layout (SB_ANNOTATIONS (widget));
 }
 
@@ -137,6 +210,7 @@ sb_annotations_class_init (SbAnnotationsClass* self_class)
 	GtkWidgetClass* widget_class = GTK_WIDGET_CLASS (self_class);
 
 	object_class->dispose      = annotations_dispose;
+	object_class->finalize     = annotations_finalize;
 	object_class->set_property = annotations_set_property;
 
 	widget_class->style_set    = annotations_style_set;
@@ -148,6 +222,15 @@ sb_annotations_class_init (SbAnnotationsClass* self_class)
 					 g_param_spec_object ("text-view", "text-view", "text-view",
 							      GTK_TYPE_TEXT_VIEW, 0));
 
+	signals[REFERENCE_CLICKED] = g_signal_new ("reference-clicked",
+						   SB_TYPE_ANNOTATIONS,
+						   G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbAnnotationsClass, reference_clicked),
+						   NULL, NULL,
+						   sb_cclosure_marshal_VOID__OBJECT_UINT,
+						   G_TYPE_NONE, 2,
+						   SB_TYPE_REFERENCE,
+						   G_TYPE_UINT);
+
 	g_type_class_add_private (self_class, sizeof (SbAnnotationsClass));
 }
 
@@ -157,18 +240,174 @@ sb_annotations_new (void)
 	return g_object_new (SB_TYPE_ANNOTATIONS, NULL);
 }
 
+static void
+update_colors (SbAnnotations* self)
+{
+	GList* children;
+	GList* iter;
+
+	if (!self->_private->colors) {
+		return;
+	}
+
+	children = gtk_container_get_children (GTK_CONTAINER (self));
+	for (iter = children; iter; iter = iter->next) {
+		SbReference* reference = sb_reference_label_get_reference (iter->data);
+
+		sb_reference_label_set_color (iter->data,
+					      sb_color_map_lookup (self->_private->colors,
+								   sb_revision_get_id (sb_reference_get_revision (reference))));
+	}
+	g_list_free (children);
+}
+
+static gboolean
+label_button_press_cb (GtkWidget     * label,
+		       GdkEventButton* event,
+		       SbAnnotations * self)
+{
+	if (event->button != 1 || event->type != GDK_BUTTON_PRESS) {
+		return FALSE;
+	}
+
+	g_signal_emit (self, signals[REFERENCE_CLICKED], 0,
+		       sb_reference_label_get_reference (SB_REFERENCE_LABEL (label)),
+		       event->state & gtk_accelerator_get_default_mod_mask ());
+
+	return TRUE;
+}
+
+static RevisionCache*
+annotations_get_cache (SbAnnotations* self,
+		       SbRevision   * revision)
+{
+	RevisionCache* cache = g_hash_table_lookup (self->_private->revisions, revision);
+
+	if (!cache) {
+		cache = g_slice_new0 (RevisionCache);
+		g_hash_table_insert (self->_private->revisions, revision, cache);
+	}
+
+	return cache;
+}
+
+static gchar const*
+annotations_get_tooltip (SbAnnotations* self,
+			 SbRevision   * revision)
+{
+	RevisionCache* cache = annotations_get_cache (self, revision);
+	GString      * tooltip;
+
+	/* the details of the revision arrive after the labels */
+	if (cache->tooltip && (cache->complete || !sb_revision_has_details (revision))) {
+		return cache->tooltip;
+	}
+
+	tooltip = g_string_new ("");
+	if (sb_revision_get_author (revision)) {
+		time_t    time = sb_revision_get_author_time (revision);
+		struct tm tm;
+		gchar     date[64] = "";
+
+		strftime (date, sizeof (date), "%Y-%m-%d %H:%M", localtime_r (&time, &tm));
+		g_string_append_printf (tooltip, "\n%s, %s",
+					sb_revision_get_author (revision),
+					date);
+	}
+	g_string_append_printf (tooltip, "\n\n%s",
+				sb_revision_has_details (revision) ?
+				sb_revision_get_message (revision) :
+				sb_revision_get_summary (revision));
+
+	g_free (cache->tooltip);
+	cache->tooltip  = g_string_free (tooltip, FALSE);
+	cache->complete = sb_revision_has_details (revision);
+
+	return cache->tooltip;
+}
+
+static gboolean
+label_query_tooltip_cb (GtkWidget    * label,
+			gint           x,
+			gint           y,
+			gboolean       keyboard_mode,
+			GtkTooltip   * tooltip,
+			SbAnnotations* self)
+{
+	SbReference* reference = sb_reference_label_get_reference (SB_REFERENCE_LABEL (label));
+	SbRevision * revision  = sb_reference_get_revision (reference);
+	gchar      * text;
+
+	/* the filename differs between the hunks of renamed files */
+	text = g_strdup_printf ("%.7s:%s%s",
+				sb_revision_get_name (revision),
+				sb_reference_get_filename (reference),
+				annotations_get_tooltip (self, revision));
+	gtk_tooltip_set_text (tooltip, text);
+	g_free (text);
+
+	return TRUE;
+}
+
+static guint
+reference_hash (gconstpointer key)
+{
+	return sb_reference_get_current_start (key) * 31 + sb_reference_get_current_end (key);
+}
+
+/* whether both say the same about the same lines */
+static gboolean
+reference_equal (gconstpointer a,
+		 gconstpointer b)
+{
+	return sb_reference_get_current_start (a) == sb_reference_get_current_start (b) &&
+	       sb_reference_get_current_end (a)   == sb_reference_get_current_end (b) &&
+	       sb_reference_get_revision (a)      == sb_reference_get_revision (b) &&
+	       !g_strcmp0 (sb_reference_get_filename (a), sb_reference_get_filename (b));
+}
+
+/* keeps the labels of the hunks which didn't change (e.g. after a refined
+ * blame or a reload) */
 static inline void
 update_labels (SbAnnotations* self)
 {
-	GList* children = gtk_container_get_children (GTK_CONTAINER (self));
-	g_list_foreach (children, (GFunc)gtk_object_destroy, NULL);
-	g_list_free    (children);
+	GList     * children = gtk_container_get_children (GTK_CONTAINER (self));
+	GHashTable* labels   = g_hash_table_new (reference_hash, reference_equal);
+	GList     * iter;
+
+	for (iter = children; iter; iter = iter->next) {
+		g_hash_table_insert (labels, sb_reference_label_get_reference (iter->data), iter->data);
+	}
+
+	for (iter = self->_private->references; iter; iter = iter->next) {
+		GtkWidget* label = g_hash_table_lookup (labels, iter->data);
+
+		if (label) {
+			g_hash_table_remove (labels, iter->data);
+			continue;
+		}
 
-	for (children = self->_private->references; children; children = children->next) {
-		GtkWidget* label = sb_reference_label_new (children->data);
+		label = sb_reference_label_new (iter->data);
+		g_signal_connect (label, "button-press-event",
+				  G_CALLBACK (label_button_press_cb), self);
+		gtk_widget_set_has_tooltip (label, TRUE);
+		g_signal_connect (label, "query-tooltip",
+				  G_CALLBACK (label_query_tooltip_cb), self);
 		gtk_widget_show (label);
 		gtk_container_add (GTK_CONTAINER (self), label);
 	}
+
+	/* the ones left over */
+	for (iter = children; iter; iter = iter->next) {
+		if (g_hash_table_lookup (labels, sb_reference_label_get_reference (iter->data)) == iter->data) {
+			gtk_object_destroy (iter->data);
+		}
+	}
+
+	g_hash_table_destroy (labels);
+	g_list_free (children);
+
+	update_colors (self);
 	annotations_layout (self);
 }
 
@@ -178,6 +417,9 @@ sb_annotations_set_references (SbAnnotations* self,
 {
 	g_return_if_fail (SB_IS_ANNOTATIONS (self));
 
+	/* the references keep the revisions (and thus the keys) alive */
+	g_hash_table_remove_all (self->_private->revisions);
+
 	if (self->_private->references) {
 		g_list_foreach (self->_private->references, (GFunc)g_object_unref, NULL);
 		g_list_free    (self->_private->references);
@@ -229,3 +471,82 @@ sb_annotations_set_text_view (SbAnnotations* self,
 	g_object_notify (G_OBJECT (self), "text-view");
 }
 
+void
+sb_annotations_set_color_map (SbAnnotations* self,
+			      SbColorMap   * colors)
+{
+	g_return_if_fail (SB_IS_ANNOTATIONS (self));
+	g_return_if_fail (!colors || SB_IS_COLOR_MAP (colors));
+
+	if (colors == self->_private->colors) {
+		return;
+	}
+
+	if (self->_private->colors) {
+		g_signal_handlers_disconnect_by_func (self->_private->colors, update_colors, self);
+		g_object_unref (self->_private->colors);
+		self->_private->colors = NULL;
+	}
+
+	if (colors) {
+		self->_private->colors = g_object_ref (colors);
+		g_signal_connect_swapped (self->_private->colors, "changed",
+					  G_CALLBACK (update_colors), self);
+	}
+
+	update_colors (self);
+}
+
+PangoLayout*
+sb_annotations_get_layout (SbAnnotations* self,
+			   SbRevision   * revision)
+{
+	RevisionCache* cache;
+
+	g_return_val_if_fail (SB_IS_ANNOTATIONS (self), NULL);
+	g_return_val_if_fail (SB_IS_REVISION (revision), NULL);
+
+	cache = annotations_get_cache (self, revision);
+	if (!cache->layout) {
+		cache->layout = gtk_widget_create_pango_layout (GTK_WIDGET (self),
+								sb_revision_get_name (revision));
+	}
+
+	return cache->layout;
+}
+
+void
+sb_annotations_set_line_map (SbAnnotations* self,
+			     SbLineMap    * line_map)
+{
+	g_return_if_fail (SB_IS_ANNOTATIONS (self));
+
+	self->_private->line_map = line_map;
+
+	sb_annotations_queue_layout (self);
+}
+
+static gboolean
+annotations_layout_idle (gpointer data)
+{
+	SbAnnotations* self = SB_ANNOTATIONS (data);
+
+	self->_private->layout_idle = 0;
+	if (self->_private->text_view) {
+		annotations_layout (self);
+	}
+
+	return FALSE;
+}
+
+void
+sb_annotations_queue_layout (SbAnnotations* self)
+{
+	g_return_if_fail (SB_IS_ANNOTATIONS (self));
+
+	/* after the text view revalidated the edited lines */
+	if (!self->_private->layout_idle) {
+		self->_private->layout_idle = g_idle_add_full (G_PRIORITY_HIGH_IDLE + 15,
+							       annotations_layout_idle, self, NULL);
+	}
+}
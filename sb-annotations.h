@@ -24,7 +24,9 @@
 #ifndef SB_ANNOTATIONS_H
 #define SB_ANNOTATIONS_H
 
-#include <gtk/gtk.h>
+#include "sb-color-map.h"
+#include "sb-line-map.h"
+#include "sb-reference.h"
 
 G_BEGIN_DECLS
 
@@ -36,11 +38,18 @@ typedef struct _SbAnnotationsClass   SbAnnotationsClass;
 #define SB_ANNOTATIONS(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_ANNOTATIONS, SbAnnotations))
 #define SB_IS_ANNOTATIONS(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_ANNOTATIONS))
 
-GtkWidget* sb_annotations_new            (void);
-void       sb_annotations_set_references (SbAnnotations* self,
-					  GList        * references);
-void       sb_annotations_set_text_view  (SbAnnotations* self,
-					  GtkTextView  * text_view);
+GtkWidget*   sb_annotations_new            (void);
+void         sb_annotations_set_references (SbAnnotations* self,
+					    GList        * references);
+void         sb_annotations_set_text_view  (SbAnnotations* self,
+					    GtkTextView  * text_view);
+void         sb_annotations_set_color_map  (SbAnnotations* self,
+					    SbColorMap   * colors);
+PangoLayout* sb_annotations_get_layout     (SbAnnotations* self,
+					    SbRevision   * revision);
+void         sb_annotations_set_line_map   (SbAnnotations* self,
+					    SbLineMap    * line_map);
+void         sb_annotations_queue_layout   (SbAnnotations* self);
 
 struct _SbAnnotations {
 	GtkLayout             base_instance;
@@ -49,6 +58,11 @@ struct _SbAnnotations {
 
 struct _SbAnnotationsClass {
 	GtkLayoutClass        base_class;
+
+	/* signals */
+	void (*reference_clicked) (SbAnnotations* self,
+				   SbReference  * reference,
+				   guint          modifiers);
 };
 
 G_END_DECLS
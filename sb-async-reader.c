@@ -0,0 +1,378 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-async-reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Reads a (pipe) file descriptor without blocking and hands out whole
+ * batches of lines.
+ *
+ * The reader only ever buffers what a single read() returns plus an
+ * incomplete last line. A consumer that can't keep up calls
+ * sb_async_reader_pause(); the reader then stops polling the descriptor
+ * and the writer blocks on the full pipe until sb_async_reader_resume().
+ *
+ * Lines end with a newline unless sb_async_reader_set_separator() says
+ * otherwise, e.g. NUL for the -z output of git.
+ */
+
+#define READ_SIZE          (64 * 1024)
+#define READS_PER_DISPATCH 4 /* don't starve the rest of the main loop */
+
+struct _SbAsyncReaderPrivate {
+	gint        fd;
+	GIOChannel* channel;
+	guint       watch;
+
+	gchar     * buffer;
+	gsize       size;
+	gsize       fill;
+	gchar       separator;
+
+	/* reused for every batch */
+	GPtrArray * lines;
+	GArray    * lengths;
+
+	guint64     n_bytes;
+	guint64     n_lines;
+
+	guint       paused : 1;
+	guint       done : 1;
+};
+
+enum {
+	READ_LINES,
+	DONE,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+G_DEFINE_TYPE (SbAsyncReader, sb_async_reader, G_TYPE_OBJECT);
+
+static void
+sb_async_reader_init (SbAsyncReader* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_ASYNC_READER,
+						      SbAsyncReaderPrivate);
+
+	self->_private->fd        = -1;
+	self->_private->separator = '\n';
+	self->_private->size      = READ_SIZE;
+	self->_private->buffer    = g_malloc (self->_private->size);
+	self->_private->lines     = g_ptr_array_sized_new (1024);
+	self->_private->lengths   = g_array_sized_new (FALSE, FALSE, sizeof (gsize), 1024);
+}
+
+static inline void
+reader_unwatch (SbAsyncReader* self)
+{
+	if (self->_private->watch) {
+		g_source_remove (self->_private->watch);
+		self->_private->watch = 0;
+	}
+}
+
+static inline void
+reader_close (SbAsyncReader* self)
+{
+	reader_unwatch (self);
+
+	if (self->_private->channel) {
+		g_io_channel_unref (self->_private->channel);
+		self->_private->channel = NULL;
+	}
+
+	if (self->_private->fd >= 0) {
+		close (self->_private->fd);
+		self->_private->fd = -1;
+	}
+}
+
+static void
+reader_finalize (GObject* object)
+{
+	SbAsyncReader* self = SB_ASYNC_READER (object);
+
+	reader_close (self);
+
+	g_free         (self->_private->buffer);
+	g_ptr_array_free (self->_private->lines, TRUE);
+	g_array_free   (self->_private->lengths, TRUE);
+
+	G_OBJECT_CLASS (sb_async_reader_parent_class)->finalize (object);
+}
+
+static void
+sb_async_reader_class_init (SbAsyncReaderClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = reader_finalize;
+
+	signals[READ_LINES] = g_signal_new ("read-lines",
+					    SB_TYPE_ASYNC_READER,
+					    G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbAsyncReaderClass, read_lines),
+					    NULL, NULL,
+					    g_cclosure_marshal_VOID__POINTER,
+					    G_TYPE_NONE, 1,
+					    G_TYPE_POINTER);
+	signals[DONE] = g_signal_new       ("done",
+					    SB_TYPE_ASYNC_READER,
+					    G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbAsyncReaderClass, done),
+					    NULL, NULL,
+					    g_cclosure_marshal_VOID__VOID,
+					    G_TYPE_NONE, 0);
+
+	g_type_class_add_private (self_class, sizeof (SbAsyncReaderPrivate));
+}
+
+static void
+reader_emit_lines (SbAsyncReader* self)
+{
+	SbLineBatch batch;
+
+	if (!self->_private->lines->len) {
+		return;
+	}
+
+	batch.lines   = (gchar**)self->_private->lines->pdata;
+	batch.lengths = (gsize*)self->_private->lengths->data;
+	batch.n_lines = self->_private->lines->len;
+
+	self->_private->n_lines += batch.n_lines;
+
+	g_signal_emit (self, signals[READ_LINES], 0, &batch);
+
+	g_ptr_array_set_size (self->_private->lines, 0);
+	g_array_set_size     (self->_private->lengths, 0);
+}
+
+static inline void
+reader_add_line (SbAsyncReader* self,
+		 gchar        * line,
+		 gsize          length)
+{
+	line[length] = '\0';
+	g_ptr_array_add     (self->_private->lines, line);
+	g_array_append_val  (self->_private->lengths, length);
+}
+
+/* splits the buffer and keeps the incomplete last line for the next read */
+static void
+reader_split (SbAsyncReader* self)
+{
+	gchar* start = self->_private->buffer;
+	gchar* end   = self->_private->buffer + self->_private->fill;
+	gchar* newline;
+
+	while (start < end && (newline = memchr (start, self->_private->separator, end - start))) {
+		reader_add_line (self, start, newline - start);
+		start = newline + 1;
+	}
+
+	reader_emit_lines (self);
+
+	self->_private->fill = end - start;
+	if (self->_private->fill && start != self->_private->buffer) {
+		memmove (self->_private->buffer, start, self->_private->fill);
+	}
+}
+
+static void
+reader_finish (SbAsyncReader* self)
+{
+	if (self->_private->fill) {
+		/* the last line didn't end with a newline; there's always room
+		 * for the terminator because the buffer grows before it's full */
+		reader_add_line (self, self->_private->buffer, self->_private->fill);
+		self->_private->fill = 0;
+		reader_emit_lines (self);
+	}
+
+	self->_private->done = TRUE;
+	reader_close (self);
+
+	g_signal_emit (self, signals[DONE], 0);
+}
+
+static gboolean
+reader_io_cb (GIOChannel  * channel,
+	      GIOCondition  condition,
+	      gpointer      data)
+{
+	SbAsyncReader* self = SB_ASYNC_READER (data);
+	gboolean       result = TRUE;
+	guint          i;
+
+	g_object_ref (self);
+
+	for (i = 0; i < READS_PER_DISPATCH && !self->_private->paused && !self->_private->done; i++) {
+		gssize bytes;
+
+		/* keep one byte for the terminator of an unfinished last line */
+		if (self->_private->size - self->_private->fill <= 1) {
+			/* a single line longer than the buffer */
+			self->_private->size  *= 2;
+			self->_private->buffer = g_realloc (self->_private->buffer,
+							    self->_private->size);
+		}
+
+		bytes = read (self->_private->fd,
+			      self->_private->buffer + self->_private->fill,
+			      self->_private->size - self->_private->fill - 1);
+
+		if (bytes > 0) {
+			self->_private->n_bytes += bytes;
+			self->_private->fill    += bytes;
+			reader_split (self);
+		} else if (bytes == 0) {
+			reader_finish (self);
+		} else if (errno == EINTR) {
+			continue;
+		} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+			break;
+		} else {
+			g_warning ("error reading from file descriptor %d: %s",
+				   self->_private->fd,
+				   g_strerror (errno));
+			reader_finish (self);
+		}
+	}
+
+	if (self->_private->paused || self->_private->done) {
+		/* the source is gone already (or is going to be removed right now) */
+		self->_private->watch = 0;
+		result = FALSE;
+	}
+
+	g_object_unref (self);
+
+	return result;
+}
+
+static void
+reader_watch (SbAsyncReader* self)
+{
+	if (self->_private->watch || self->_private->done || self->_private->paused) {
+		return;
+	}
+
+	self->_private->watch = g_io_add_watch (self->_private->channel,
+						G_IO_IN | G_IO_HUP | G_IO_ERR,
+						reader_io_cb,
+						self);
+}
+
+SbAsyncReader*
+sb_async_reader_new (gint fd)
+{
+	SbAsyncReader* self;
+
+	g_return_val_if_fail (fd >= 0, NULL);
+
+	self = g_object_new (SB_TYPE_ASYNC_READER, NULL);
+
+	fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+
+	self->_private->fd      = fd;
+	self->_private->channel = g_io_channel_unix_new (fd);
+	reader_watch (self);
+
+	return self;
+}
+
+gboolean
+sb_async_reader_is_done (SbAsyncReader const* self)
+{
+	g_return_val_if_fail (SB_IS_ASYNC_READER (self), FALSE);
+
+	return self->_private->done;
+}
+
+/* before the first read, i.e. right after the job got started */
+void
+sb_async_reader_set_separator (SbAsyncReader* self,
+			       gchar          separator)
+{
+	g_return_if_fail (SB_IS_ASYNC_READER (self));
+	g_return_if_fail (!self->_private->n_bytes);
+
+	self->_private->separator = separator;
+}
+
+gboolean
+sb_async_reader_is_paused (SbAsyncReader const* self)
+{
+	g_return_val_if_fail (SB_IS_ASYNC_READER (self), FALSE);
+
+	return self->_private->paused;
+}
+
+void
+sb_async_reader_pause (SbAsyncReader* self)
+{
+	g_return_if_fail (SB_IS_ASYNC_READER (self));
+
+	if (self->_private->paused) {
+		return;
+	}
+
+	self->_private->paused = TRUE;
+	reader_unwatch (self);
+}
+
+void
+sb_async_reader_resume (SbAsyncReader* self)
+{
+	g_return_if_fail (SB_IS_ASYNC_READER (self));
+
+	if (!self->_private->paused) {
+		return;
+	}
+
+	self->_private->paused = FALSE;
+	reader_watch (self);
+}
+
+guint64
+sb_async_reader_get_n_bytes (SbAsyncReader const* self)
+{
+	g_return_val_if_fail (SB_IS_ASYNC_READER (self), 0);
+
+	return self->_private->n_bytes;
+}
+
+guint64
+sb_async_reader_get_n_lines (SbAsyncReader const* self)
+{
+	g_return_val_if_fail (SB_IS_ASYNC_READER (self), 0);
+
+	return self->_private->n_lines;
+}
+
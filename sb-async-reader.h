@@ -0,0 +1,78 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_ASYNC_READER_H
+#define SB_ASYNC_READER_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef struct _SbAsyncReader        SbAsyncReader;
+typedef struct _SbAsyncReaderPrivate SbAsyncReaderPrivate;
+typedef struct _SbAsyncReaderClass   SbAsyncReaderClass;
+typedef struct _SbLineBatch          SbLineBatch;
+
+#define SB_TYPE_ASYNC_READER         (sb_async_reader_get_type ())
+#define SB_ASYNC_READER(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_ASYNC_READER, SbAsyncReader))
+#define SB_ASYNC_READER_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_ASYNC_READER, SbAsyncReaderClass))
+#define SB_IS_ASYNC_READER(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_ASYNC_READER))
+#define SB_IS_ASYNC_READER_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_ASYNC_READER))
+#define SB_ASYNC_READER_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_ASYNC_READER, SbAsyncReaderClass))
+
+GType          sb_async_reader_get_type      (void);
+SbAsyncReader* sb_async_reader_new           (gint                 fd);
+void           sb_async_reader_set_separator (SbAsyncReader      * self,
+					      gchar                separator);
+gboolean       sb_async_reader_is_done       (SbAsyncReader const* self);
+gboolean       sb_async_reader_is_paused     (SbAsyncReader const* self);
+void           sb_async_reader_pause         (SbAsyncReader      * self);
+void           sb_async_reader_resume        (SbAsyncReader      * self);
+guint64        sb_async_reader_get_n_bytes   (SbAsyncReader const* self);
+guint64        sb_async_reader_get_n_lines   (SbAsyncReader const* self);
+
+struct _SbLineBatch {
+	/* the lines are NUL terminated and don't contain the separator; they're
+	 * only valid during the emission of "read-lines" */
+	gchar**      lines;
+	gsize      * lengths;
+	guint        n_lines;
+};
+
+struct _SbAsyncReader {
+	GObject               base_instance;
+	SbAsyncReaderPrivate* _private;
+};
+
+struct _SbAsyncReaderClass {
+	GObjectClass          base_class;
+
+	/* signals */
+	void (*read_lines) (SbAsyncReader    * self,
+			    SbLineBatch const* batch);
+	void (*done)       (SbAsyncReader    * self);
+};
+
+G_END_DECLS
+
+#endif /* !SB_ASYNC_READER_H */
@@ -0,0 +1,378 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-cat-file.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sb-git.h"
+
+/* A long-lived "git cat-file --batch" co-process.
+ *
+ * Requests are queued and written to the process in one go, the answers
+ * come back in the same order. That way, the metadata of hundreds of
+ * commits costs one write and one read instead of one process each.
+ */
+
+typedef struct {
+	gchar           * name;
+	SbCatFileCallback callback;
+	gpointer          user_data;
+} Request;
+
+struct _SbCatFilePrivate {
+	gchar      * toplevel;
+	SbJob      * job;
+
+	GIOChannel * in_channel;
+	guint        in_watch;
+	GString    * input;    /* queued but not yet written */
+	GQueue     * requests; /* waiting for an answer, in order */
+
+	/* the answer currently being read */
+	gboolean     in_contents;
+	gchar      * object;
+	gchar      * type;
+	gsize        size;
+	GString    * contents;
+};
+
+G_DEFINE_TYPE (SbCatFile, sb_cat_file, G_TYPE_OBJECT);
+
+static void
+sb_cat_file_init (SbCatFile* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_CAT_FILE,
+						      SbCatFilePrivate);
+
+	self->_private->input    = g_string_new ("");
+	self->_private->requests = g_queue_new ();
+	self->_private->contents = g_string_new ("");
+}
+
+static void
+request_finish (Request    * request,
+		gchar const* object,
+		gchar const* type,
+		gchar const* contents,
+		gsize        length)
+{
+	if (request->callback) {
+		request->callback (request->name,
+				   object,
+				   type,
+				   contents,
+				   length,
+				   request->user_data);
+	}
+
+	g_free (request->name);
+	g_slice_free (Request, request);
+}
+
+static void
+cat_file_reset_answer (SbCatFile* self)
+{
+	self->_private->in_contents = FALSE;
+	g_free (self->_private->object);
+	self->_private->object = NULL;
+	g_free (self->_private->type);
+	self->_private->type = NULL;
+	g_string_truncate (self->_private->contents, 0);
+}
+
+static void
+cat_file_stop (SbCatFile* self)
+{
+	if (self->_private->in_watch) {
+		g_source_remove (self->_private->in_watch);
+		self->_private->in_watch = 0;
+	}
+
+	if (self->_private->in_channel) {
+		g_io_channel_unref (self->_private->in_channel);
+		self->_private->in_channel = NULL;
+	}
+
+	if (self->_private->job) {
+		g_signal_handlers_disconnect_matched (self->_private->job, G_SIGNAL_MATCH_DATA,
+						      0, 0, NULL, NULL, self);
+		g_signal_handlers_disconnect_matched (sb_job_get_reader (self->_private->job), G_SIGNAL_MATCH_DATA,
+						      0, 0, NULL, NULL, self);
+		sb_job_cancel (self->_private->job);
+		g_object_unref (self->_private->job);
+		self->_private->job = NULL;
+	}
+
+	/* whatever was still pending won't be answered anymore */
+	g_string_truncate (self->_private->input, 0);
+	cat_file_reset_answer (self);
+	while (!g_queue_is_empty (self->_private->requests)) {
+		request_finish (g_queue_pop_head (self->_private->requests),
+				NULL, NULL, NULL, 0);
+	}
+}
+
+static void
+cat_file_finalize (GObject* object)
+{
+	SbCatFile* self = SB_CAT_FILE (object);
+
+	cat_file_stop (self);
+
+	g_queue_free    (self->_private->requests);
+	g_string_free   (self->_private->input, TRUE);
+	g_string_free   (self->_private->contents, TRUE);
+	g_free          (self->_private->toplevel);
+
+	G_OBJECT_CLASS (sb_cat_file_parent_class)->finalize (object);
+}
+
+static void
+sb_cat_file_class_init (SbCatFileClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = cat_file_finalize;
+
+	g_type_class_add_private (self_class, sizeof (SbCatFilePrivate));
+}
+
+SbCatFile*
+sb_cat_file_new (gchar const* toplevel)
+{
+	SbCatFile* self;
+
+	g_return_val_if_fail (toplevel, NULL);
+
+	self = g_object_new (SB_TYPE_CAT_FILE, NULL);
+	self->_private->toplevel = g_strdup (toplevel);
+
+	return self;
+}
+
+/* "<object> <type> <size>" or "<name> missing" */
+static void
+cat_file_parse_header (SbCatFile  * self,
+		       gchar      * line)
+{
+	gchar* size = strrchr (line, ' ');
+	gchar* type;
+
+	if (!size || !strcmp (size, " missing") || !strcmp (size, " ambiguous")) {
+		request_finish (g_queue_pop_head (self->_private->requests),
+				NULL, NULL, NULL, 0);
+		return;
+	}
+
+	*size++ = '\0';
+	type = strrchr (line, ' ');
+	if (!type) {
+		g_warning ("unexpected answer from git cat-file: %s", line);
+		request_finish (g_queue_pop_head (self->_private->requests),
+				NULL, NULL, NULL, 0);
+		return;
+	}
+	*type++ = '\0';
+
+	self->_private->object      = g_strdup (line);
+	self->_private->type        = g_strdup (type);
+	self->_private->size        = g_ascii_strtoull (size, NULL, 10);
+	self->_private->in_contents = TRUE;
+}
+
+static void
+cat_file_read_lines_cb (SbAsyncReader    * reader,
+			SbLineBatch const* batch,
+			SbCatFile        * self)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_lines; i++) {
+		if (G_UNLIKELY (g_queue_is_empty (self->_private->requests))) {
+			g_warning ("unexpected output from git cat-file: %s", batch->lines[i]);
+			continue;
+		}
+
+		if (!self->_private->in_contents) {
+			cat_file_parse_header (self, batch->lines[i]);
+			continue;
+		}
+
+		g_string_append_len (self->_private->contents,
+				     batch->lines[i],
+				     batch->lengths[i]);
+		g_string_append_c   (self->_private->contents, '\n');
+
+		/* the contents are followed by a newline of their own */
+		if (self->_private->contents->len > self->_private->size) {
+			g_string_truncate (self->_private->contents, self->_private->size);
+			request_finish (g_queue_pop_head (self->_private->requests),
+					self->_private->object,
+					self->_private->type,
+					self->_private->contents->str,
+					self->_private->contents->len);
+			cat_file_reset_answer (self);
+		}
+	}
+}
+
+static void
+cat_file_job_done_cb (SbJob    * job,
+		      SbCatFile* self)
+{
+	/* the process went away (it's started again with the next request) */
+	cat_file_stop (self);
+}
+
+static gboolean
+cat_file_write (SbCatFile* self)
+{
+	while (self->_private->input->len) {
+		gssize written = write (sb_job_get_stdin (self->_private->job),
+					self->_private->input->str,
+					self->_private->input->len);
+
+		if (written > 0) {
+			g_string_erase (self->_private->input, 0, written);
+		} else if (written < 0 && errno == EINTR) {
+			continue;
+		} else if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			/* the pipe is full, wait for git to read */
+			return FALSE;
+		} else {
+			/* the process died; its "done" handler fails the requests */
+			g_string_truncate (self->_private->input, 0);
+		}
+	}
+
+	return TRUE;
+}
+
+static gboolean
+cat_file_writable_cb (GIOChannel  * channel,
+		      GIOCondition  condition,
+		      gpointer      data)
+{
+	SbCatFile* self = SB_CAT_FILE (data);
+
+	if (cat_file_write (self)) {
+		self->_private->in_watch = 0;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+cat_file_ensure_running (SbCatFile* self)
+{
+	GError* error = NULL;
+	gint    fd;
+
+	if (G_LIKELY (self->_private->job)) {
+		return TRUE;
+	}
+
+	self->_private->job = sb_git_job_new (self->_private->toplevel,
+					      SB_JOB_PIPE_STDIN,
+					      "cat-file", "--batch",
+					      NULL);
+	sb_job_set_priority (self->_private->job, SB_JOB_PRIORITY_DETAILS);
+
+	if (!sb_job_start (self->_private->job, &error)) {
+		g_warning ("couldn't start git cat-file: %s", error->message);
+		g_error_free (error);
+		g_object_unref (self->_private->job);
+		self->_private->job = NULL;
+		return FALSE;
+	}
+
+	g_signal_connect (sb_job_get_reader (self->_private->job), "read-lines",
+			  G_CALLBACK (cat_file_read_lines_cb), self);
+	g_signal_connect (self->_private->job, "done",
+			  G_CALLBACK (cat_file_job_done_cb), self);
+
+	fd = sb_job_get_stdin (self->_private->job);
+	fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) | O_NONBLOCK);
+	self->_private->in_channel = g_io_channel_unix_new (fd);
+
+	return TRUE;
+}
+
+void
+sb_cat_file_request (SbCatFile        * self,
+		     gchar const      * name,
+		     SbCatFileCallback  callback,
+		     gpointer           user_data)
+{
+	Request* request;
+
+	g_return_if_fail (SB_IS_CAT_FILE (self));
+	g_return_if_fail (name && !strchr (name, '\n'));
+
+	request = g_slice_new (Request);
+	request->name      = g_strdup (name);
+	request->callback  = callback;
+	request->user_data = user_data;
+
+	if (!cat_file_ensure_running (self)) {
+		request_finish (request, NULL, NULL, NULL, 0);
+		return;
+	}
+
+	g_queue_push_tail (self->_private->requests, request);
+	g_string_append   (self->_private->input, name);
+	g_string_append_c (self->_private->input, '\n');
+
+	/* requests issued in one go end up in a single write() */
+	if (!self->_private->in_watch) {
+		self->_private->in_watch = g_io_add_watch (self->_private->in_channel,
+							   G_IO_OUT,
+							   cat_file_writable_cb,
+							   self);
+	}
+}
+
+void
+sb_cat_file_cancel (SbCatFile* self,
+		    gpointer   user_data)
+{
+	GList* iter;
+
+	g_return_if_fail (SB_IS_CAT_FILE (self));
+
+	/* the answers still have to be read, just don't report them */
+	for (iter = self->_private->requests->head; iter; iter = iter->next) {
+		Request* request = iter->data;
+
+		if (request->user_data == user_data) {
+			request->callback = NULL;
+		}
+	}
+}
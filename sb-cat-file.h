@@ -0,0 +1,70 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_CAT_FILE_H
+#define SB_CAT_FILE_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef struct _SbCatFile        SbCatFile;
+typedef struct _SbCatFilePrivate SbCatFilePrivate;
+typedef struct _SbCatFileClass   SbCatFileClass;
+
+#define SB_TYPE_CAT_FILE         (sb_cat_file_get_type ())
+#define SB_CAT_FILE(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_CAT_FILE, SbCatFile))
+#define SB_CAT_FILE_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_CAT_FILE, SbCatFileClass))
+#define SB_IS_CAT_FILE(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_CAT_FILE))
+#define SB_IS_CAT_FILE_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_CAT_FILE))
+#define SB_CAT_FILE_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_CAT_FILE, SbCatFileClass))
+
+/* type is NULL if the object doesn't exist */
+typedef void (*SbCatFileCallback) (gchar const* name,
+				   gchar const* object,
+				   gchar const* type,
+				   gchar const* contents,
+				   gsize        length,
+				   gpointer     user_data);
+
+GType      sb_cat_file_get_type (void);
+SbCatFile* sb_cat_file_new      (gchar const      * toplevel);
+void       sb_cat_file_request  (SbCatFile        * self,
+				 gchar const      * name,
+				 SbCatFileCallback  callback,
+				 gpointer           user_data);
+void       sb_cat_file_cancel   (SbCatFile        * self,
+				 gpointer           user_data);
+
+struct _SbCatFile {
+	GObject           base_instance;
+	SbCatFilePrivate* _private;
+};
+
+struct _SbCatFileClass {
+	GObjectClass      base_class;
+};
+
+G_END_DECLS
+
+#endif /* !SB_CAT_FILE_H */
@@ -0,0 +1,377 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-churn.h"
+
+#include "sb-git.h"
+#include "sb-history-loader.h"
+#include "sb-hunk.h"
+#include "sb-repository.h"
+
+/* How often each line of a file changed, from one pass over its history.
+ *
+ * "git log -p -U0" lists the commits touching the file, the newest
+ * first. Each line of the file keeps the position it had in the version
+ * being looked at. A hunk that changed the line counts once and moves
+ * the line to the same offset in the hunk's old side, or ends the line
+ * when that side is shorter (the line was added then). A hunk before the
+ * line only shifts it. Lines and hunks are both sorted by position, so a
+ * commit costs one merge of the two lists. The pass stops when no line
+ * is left to follow.
+ *
+ * Merges count as one change against their first parent, the way
+ * --first-parent walks the history.
+ */
+
+typedef struct {
+	guint line;  /* in the file, from 0 */
+	guint pos;   /* in the version being looked at, from 1 */
+} Line;
+
+struct _SbChurnPrivate {
+	gchar       * file_path;
+	SbRepository* repository;
+	gchar       * head;       /* what the counts were made from */
+
+	guint       * counts;
+	guint         n_lines;
+	guint         max;
+
+	GArray      * live;       /* of Line, by pos */
+	GArray      * hunks;      /* of SbHunk, of the current commit */
+	SbJob       * job;
+	gboolean      done;
+};
+
+enum {
+	DONE,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+G_DEFINE_TYPE (SbChurn, sb_churn, G_TYPE_OBJECT);
+
+static void
+sb_churn_init (SbChurn* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_CHURN,
+						      SbChurnPrivate);
+
+	self->_private->live  = g_array_new (FALSE, FALSE, sizeof (Line));
+	self->_private->hunks = g_array_new (FALSE, FALSE, sizeof (SbHunk));
+}
+
+static void
+churn_disconnect (SbChurn* self)
+{
+	if (!self->_private->job) {
+		return;
+	}
+
+	g_signal_handlers_disconnect_matched (sb_job_get_reader (self->_private->job), G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	g_signal_handlers_disconnect_matched (self->_private->job, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	g_object_unref (self->_private->job);
+	self->_private->job = NULL;
+}
+
+static void
+churn_finalize (GObject* object)
+{
+	SbChurn* self = SB_CHURN (object);
+
+	sb_churn_cancel (self);
+
+	g_array_free (self->_private->live,  TRUE);
+	g_array_free (self->_private->hunks, TRUE);
+	g_free (self->_private->counts);
+	g_free (self->_private->head);
+	g_free (self->_private->file_path);
+	if (self->_private->repository) {
+		g_object_unref (self->_private->repository);
+	}
+
+	G_OBJECT_CLASS (sb_churn_parent_class)->finalize (object);
+}
+
+static void
+sb_churn_class_init (SbChurnClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = churn_finalize;
+
+	signals[DONE] = g_signal_new ("done",
+				      SB_TYPE_CHURN,
+				      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbChurnClass, done),
+				      NULL, NULL,
+				      g_cclosure_marshal_VOID__VOID,
+				      G_TYPE_NONE, 0);
+
+	g_type_class_add_private (self_class, sizeof (SbChurnPrivate));
+}
+
+SbChurn*
+sb_churn_new (gchar const* file_path)
+{
+	SbChurn* self;
+	gchar  * folder;
+
+	g_return_val_if_fail (file_path && g_path_is_absolute (file_path), NULL);
+
+	self = g_object_new (SB_TYPE_CHURN, NULL);
+	self->_private->file_path = g_strdup (file_path);
+
+	folder = g_path_get_dirname (file_path);
+	self->_private->repository = sb_repository_lookup (folder);
+	if (self->_private->repository) {
+		g_object_ref (self->_private->repository);
+	}
+	g_free (folder);
+
+	return self;
+}
+
+static void
+churn_apply_hunks (SbChurn* self)
+{
+	GArray* live  = self->_private->live;
+	GArray* hunks = self->_private->hunks;
+	gint    delta = 0;  /* new minus old lines of the hunks passed */
+	guint   kept  = 0;
+	guint   h     = 0;
+	guint   i;
+
+	if (!hunks->len) {
+		return;
+	}
+
+	for (i = 0; i < live->len; i++) {
+		Line    line = g_array_index (live, Line, i);
+		SbHunk* hunk;
+
+		for (; h < hunks->len && sb_hunk_get_last (&g_array_index (hunks, SbHunk, h)) < line.pos; h++) {
+			hunk   = &g_array_index (hunks, SbHunk, h);
+			delta += (gint)hunk->new_count - (gint)hunk->old_count;
+		}
+
+		hunk = h < hunks->len ? &g_array_index (hunks, SbHunk, h) : NULL;
+		if (hunk && hunk->new_count && hunk->new_start <= line.pos) {
+			guint offset = line.pos - hunk->new_start;
+
+			self->_private->counts[line.line]++;
+			self->_private->max = MAX (self->_private->max, self->_private->counts[line.line]);
+
+			if (offset >= hunk->old_count) {
+				/* added here: nothing older to follow */
+				continue;
+			}
+			line.pos = hunk->old_start + offset;
+		} else {
+			line.pos -= delta;
+		}
+
+		g_array_index (live, Line, kept++) = line;
+	}
+
+	g_array_set_size (live,  kept);
+	g_array_set_size (hunks, 0);
+
+	if (!kept && self->_private->job) {
+		/* the rest of the history is about lines that are gone */
+		sb_job_cancel (self->_private->job);
+	}
+}
+
+static void
+churn_read_lines_cb (SbAsyncReader    * reader,
+		     SbLineBatch const* batch,
+		     SbChurn          * self)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_lines; i++) {
+		gchar const* line = batch->lines[i];
+		SbHunk       hunk;
+
+		if (!self->_private->live->len) {
+			return;
+		}
+
+		/* the content lines start with ' ', '+', '-' or '\\' */
+		if (g_str_has_prefix (line, "commit ")) {
+			churn_apply_hunks (self);
+		} else if (sb_hunk_parse (line, &hunk)) {
+			g_array_append_val (self->_private->hunks, hunk);
+		}
+	}
+}
+
+static void
+churn_job_done_cb (SbChurn* self,
+		   SbJob  * job)
+{
+	if (self->_private->live->len) {
+		/* the oldest commit */
+		churn_apply_hunks (self);
+	}
+
+	churn_disconnect (self);
+	g_array_set_size (self->_private->live, 0);
+	self->_private->done = TRUE;
+
+	g_signal_emit (self, signals[DONE], 0);
+}
+
+/* see sb_history_loader_count_lines() */
+static guint
+churn_count_lines (SbChurn const* self)
+{
+	GMappedFile* file = g_mapped_file_new (self->_private->file_path, FALSE, NULL);
+	guint        result;
+
+	if (!file) {
+		return 0;
+	}
+
+	result = sb_history_loader_count_lines (g_mapped_file_get_contents (file),
+						g_mapped_file_get_length (file));
+	g_mapped_file_free (file);
+
+	return result;
+}
+
+gboolean
+sb_churn_start (SbChurn* self,
+		GError** error)
+{
+	gchar const* toplevel;
+	gchar const* path;
+	guint        i;
+
+	g_return_val_if_fail (SB_IS_CHURN (self), FALSE);
+	g_return_val_if_fail (!self->_private->job && !self->_private->done, FALSE);
+
+	if (!self->_private->repository) {
+		g_set_error (error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED,
+			     "%s is not in a git repository", self->_private->file_path);
+		return FALSE;
+	}
+
+	toplevel = sb_repository_get_toplevel (self->_private->repository);
+	path     = sb_repository_get_relative_path (self->_private->repository, self->_private->file_path);
+	self->_private->head = g_strdup (sb_repository_get_head (self->_private->repository));
+
+	// FIXME: map the lines of the working copy to the ones of HEAD
+	self->_private->n_lines = churn_count_lines (self);
+	self->_private->counts  = g_new0 (guint, self->_private->n_lines);
+	g_array_set_size (self->_private->live, self->_private->n_lines);
+	for (i = 0; i < self->_private->n_lines; i++) {
+		Line* line = &g_array_index (self->_private->live, Line, i);
+
+		line->line = i;
+		line->pos  = i + 1;
+	}
+
+	// FIXME: follow renames; --follow doesn't go with the line positions of merges
+	self->_private->job = sb_git_job_new (toplevel, 0,
+					      "log", "--first-parent", "-m", "-p", "-U0",
+					      "--no-color", "--no-ext-diff", "--format=commit %H",
+					      "--", path,
+					      NULL);
+	sb_job_set_priority (self->_private->job, SB_JOB_PRIORITY_PREFETCH);
+
+	if (!sb_job_start (self->_private->job, error)) {
+		g_object_unref (self->_private->job);
+		self->_private->job = NULL;
+		return FALSE;
+	}
+
+	g_signal_connect (sb_job_get_reader (self->_private->job), "read-lines",
+			  G_CALLBACK (churn_read_lines_cb), self);
+	g_signal_connect_swapped (self->_private->job, "done",
+				  G_CALLBACK (churn_job_done_cb), self);
+
+	return TRUE;
+}
+
+void
+sb_churn_cancel (SbChurn* self)
+{
+	g_return_if_fail (SB_IS_CHURN (self));
+
+	if (self->_private->job) {
+		sb_job_cancel (self->_private->job);
+		churn_disconnect (self);
+	}
+}
+
+gboolean
+sb_churn_is_done (SbChurn const* self)
+{
+	g_return_val_if_fail (SB_IS_CHURN (self), FALSE);
+
+	return self->_private->done;
+}
+
+/* the counts only depend on the history */
+gboolean
+sb_churn_is_current (SbChurn const* self)
+{
+	g_return_val_if_fail (SB_IS_CHURN (self), FALSE);
+
+	return self->_private->repository &&
+	       !g_strcmp0 (sb_repository_get_head (self->_private->repository), self->_private->head);
+}
+
+gchar const*
+sb_churn_get_file_path (SbChurn const* self)
+{
+	g_return_val_if_fail (SB_IS_CHURN (self), NULL);
+
+	return self->_private->file_path;
+}
+
+/* the number of changes per line, from 0 */
+guint const*
+sb_churn_get_counts (SbChurn const* self,
+		     guint        * n_lines)
+{
+	g_return_val_if_fail (SB_IS_CHURN (self), NULL);
+	g_return_val_if_fail (n_lines, NULL);
+
+	*n_lines = self->_private->n_lines;
+
+	return self->_private->counts;
+}
+
+guint
+sb_churn_get_max (SbChurn const* self)
+{
+	g_return_val_if_fail (SB_IS_CHURN (self), 0);
+
+	return self->_private->max;
+}
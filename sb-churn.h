@@ -0,0 +1,68 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_CHURN_H
+#define SB_CHURN_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef struct _SbChurn        SbChurn;
+typedef struct _SbChurnPrivate SbChurnPrivate;
+typedef struct _SbChurnClass   SbChurnClass;
+
+#define SB_TYPE_CHURN         (sb_churn_get_type ())
+#define SB_CHURN(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_CHURN, SbChurn))
+#define SB_CHURN_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_CHURN, SbChurnClass))
+#define SB_IS_CHURN(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_CHURN))
+#define SB_IS_CHURN_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_CHURN))
+#define SB_CHURN_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_CHURN, SbChurnClass))
+
+GType        sb_churn_get_type      (void);
+SbChurn*     sb_churn_new           (gchar const  * file_path);
+gboolean     sb_churn_start         (SbChurn      * self,
+				     GError      ** error);
+void         sb_churn_cancel        (SbChurn      * self);
+gboolean     sb_churn_is_done       (SbChurn const* self);
+gboolean     sb_churn_is_current    (SbChurn const* self);
+gchar const* sb_churn_get_file_path (SbChurn const* self);
+guint const* sb_churn_get_counts    (SbChurn const* self,
+				     guint        * n_lines);
+guint        sb_churn_get_max       (SbChurn const* self);
+
+struct _SbChurn {
+	GObject         base_instance;
+	SbChurnPrivate* _private;
+};
+
+struct _SbChurnClass {
+	GObjectClass    base_class;
+
+	/* signals */
+	void (*done) (SbChurn* self);
+};
+
+G_END_DECLS
+
+#endif /* !SB_CHURN_H */
@@ -0,0 +1,263 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-color-map.h"
+
+/* The background colors of the annotations, computed once per revision
+ * whenever a file got blamed (or the mode changed) and then looked up by
+ * revision id. Every revision also gets its relative age within the
+ * file, from 0.0 (oldest) to 1.0 (newest).
+ */
+
+struct _SbColorMapPrivate {
+	SbColorMode      mode;
+
+	/* the input of the last update, so the mode can change without
+	 * going back to the table */
+	GArray         * ids;
+	GArray         * times;  /* gint64 */
+	GArray         * hashes; /* guint */
+
+	/* indexed by revision id */
+	GArray         * colors; /* GdkColor */
+	GArray         * ages;   /* gfloat */
+};
+
+enum {
+	CHANGED,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+static GdkColor const tango_colors[] = {
+	{0, 0xfcfc, 0xe9e9, 0x4f4f}, // butter
+	{0, 0xfcfc, 0xafaf, 0x3e3e}, // orange
+	{0, 0xe9e9, 0xb9b9, 0x6e6e}, // chocolate
+	{0, 0x8a8a, 0xe2e2, 0x3434}, // chameleon
+	{0, 0x7272, 0x9f9f, 0xcfcf}, // sky blue
+	{0, 0xadad, 0x7f7f, 0xa8a8}, // plum
+	{0, 0xefef, 0x2929, 0x2929}, // scarlet red
+	{0, 0xeeee, 0xeeee, 0xecec}  // aluminium
+};
+
+/* the ages are rounded to a few steps, so there's a bounded number of
+ * different colors (e.g. for text tags) */
+#define AGE_STEPS 16
+
+/* from old to new */
+static GdkColor const age_colors[] = {
+	{0, 0xeeee, 0xeeee, 0xecec}, // aluminium
+	{0, 0xfcfc, 0xe9e9, 0x4f4f}, // butter
+	{0, 0xfcfc, 0xafaf, 0x3e3e}  // orange
+};
+
+static GdkColor const unknown_color = {0, 0xeeee, 0xeeee, 0xeeee};
+
+G_DEFINE_TYPE (SbColorMap, sb_color_map, G_TYPE_OBJECT);
+
+static void
+sb_color_map_init (SbColorMap* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_COLOR_MAP,
+						      SbColorMapPrivate);
+
+	self->_private->ids    = g_array_new (FALSE, FALSE, sizeof (guint));
+	self->_private->times  = g_array_new (FALSE, FALSE, sizeof (gint64));
+	self->_private->hashes = g_array_new (FALSE, FALSE, sizeof (guint));
+	self->_private->colors = g_array_new (FALSE, FALSE, sizeof (GdkColor));
+	self->_private->ages   = g_array_new (FALSE, FALSE, sizeof (gfloat));
+}
+
+static void
+color_map_finalize (GObject* object)
+{
+	SbColorMap* self = SB_COLOR_MAP (object);
+
+	g_array_free (self->_private->ids, TRUE);
+	g_array_free (self->_private->times, TRUE);
+	g_array_free (self->_private->hashes, TRUE);
+	g_array_free (self->_private->colors, TRUE);
+	g_array_free (self->_private->ages, TRUE);
+
+	G_OBJECT_CLASS (sb_color_map_parent_class)->finalize (object);
+}
+
+static void
+sb_color_map_class_init (SbColorMapClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = color_map_finalize;
+
+	signals[CHANGED] = g_signal_new ("changed",
+					 SB_TYPE_COLOR_MAP,
+					 G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbColorMapClass, changed),
+					 NULL, NULL,
+					 g_cclosure_marshal_VOID__VOID,
+					 G_TYPE_NONE, 0);
+
+	g_type_class_add_private (self_class, sizeof (SbColorMapPrivate));
+}
+
+SbColorMap*
+sb_color_map_new (void)
+{
+	return g_object_new (SB_TYPE_COLOR_MAP, NULL);
+}
+
+SbColorMode
+sb_color_map_get_mode (SbColorMap const* self)
+{
+	g_return_val_if_fail (SB_IS_COLOR_MAP (self), SB_COLOR_BY_REVISION);
+
+	return self->_private->mode;
+}
+
+static void
+color_map_interpolate (gfloat    age,
+		       GdkColor* color)
+{
+	gfloat          position = age * (G_N_ELEMENTS (age_colors) - 1);
+	guint           index    = MIN ((guint)position, G_N_ELEMENTS (age_colors) - 2);
+	gfloat          fraction = position - index;
+	GdkColor const* from     = &age_colors[index];
+	GdkColor const* to       = &age_colors[index + 1];
+
+	color->pixel = 0;
+	color->red   = from->red   + (to->red   - from->red)   * fraction;
+	color->green = from->green + (to->green - from->green) * fraction;
+	color->blue  = from->blue  + (to->blue  - from->blue)  * fraction;
+}
+
+static void
+color_map_compute (SbColorMap* self)
+{
+	guint const * ids    = (guint const*)self->_private->ids->data;
+	gint64 const* times  = (gint64 const*)self->_private->times->data;
+	guint const * hashes = (guint const*)self->_private->hashes->data;
+	guint         n_ids  = self->_private->ids->len;
+	gint64        oldest = G_MAXINT64;
+	gint64        newest = 0;
+	guint         i;
+
+	/* one pass for the range, one for the colors */
+	for (i = 0; i < n_ids; i++) {
+		oldest = MIN (oldest, times[i]);
+		newest = MAX (newest, times[i]);
+	}
+
+	for (i = 0; i < n_ids; i++) {
+		gfloat    age   = newest > oldest ? (gfloat)(times[i] - oldest) / (newest - oldest) : 1.0;
+		GdkColor* color = &g_array_index (self->_private->colors, GdkColor, ids[i]);
+
+		g_array_index (self->_private->ages, gfloat, ids[i]) = age;
+
+		if (self->_private->mode == SB_COLOR_BY_AGE) {
+			color_map_interpolate ((gint)(age * (AGE_STEPS - 1) + 0.5) / (gfloat)(AGE_STEPS - 1),
+					       color);
+		} else {
+			*color = tango_colors[hashes[i] & 0x7];
+		}
+	}
+
+	g_signal_emit (self, signals[CHANGED], 0);
+}
+
+void
+sb_color_map_set_mode (SbColorMap * self,
+		       SbColorMode  mode)
+{
+	g_return_if_fail (SB_IS_COLOR_MAP (self));
+
+	if (self->_private->mode == mode) {
+		return;
+	}
+
+	self->_private->mode = mode;
+	color_map_compute (self);
+}
+
+void
+sb_color_map_update (SbColorMap     * self,
+		     SbRevisionTable* revisions,
+		     guint const    * ids,
+		     guint            n_ids)
+{
+	gint64 const* times;
+	guint         length;
+	guint         i;
+
+	g_return_if_fail (SB_IS_COLOR_MAP (self));
+	g_return_if_fail (revisions);
+	g_return_if_fail (ids || !n_ids);
+
+	g_array_set_size (self->_private->ids, n_ids);
+	g_array_set_size (self->_private->times, n_ids);
+	g_array_set_size (self->_private->hashes, n_ids);
+
+	times = sb_revision_table_get_author_times (revisions);
+	for (i = 0; i < n_ids; i++) {
+		g_array_index (self->_private->ids,    guint,  i) = ids[i];
+		g_array_index (self->_private->times,  gint64, i) = times[ids[i]];
+		g_array_index (self->_private->hashes, guint,  i) = g_str_hash (sb_revision_table_get_name (revisions, ids[i]));
+	}
+
+	/* forget the colors of the last file */
+	length = sb_revision_table_get_n_revisions (revisions);
+	g_array_set_size (self->_private->colors, length);
+	g_array_set_size (self->_private->ages, length);
+	for (i = 0; i < length; i++) {
+		g_array_index (self->_private->colors, GdkColor, i) = unknown_color;
+		g_array_index (self->_private->ages,   gfloat,   i) = 0.0;
+	}
+
+	color_map_compute (self);
+}
+
+GdkColor const*
+sb_color_map_lookup (SbColorMap const* self,
+		     guint             id)
+{
+	g_return_val_if_fail (SB_IS_COLOR_MAP (self), &unknown_color);
+
+	if (G_UNLIKELY (id >= self->_private->colors->len)) {
+		return &unknown_color;
+	}
+
+	return &g_array_index (self->_private->colors, GdkColor, id);
+}
+
+gfloat
+sb_color_map_get_age (SbColorMap const* self,
+		      guint             id)
+{
+	g_return_val_if_fail (SB_IS_COLOR_MAP (self), 0.0);
+
+	if (G_UNLIKELY (id >= self->_private->ages->len)) {
+		return 0.0;
+	}
+
+	return g_array_index (self->_private->ages, gfloat, id);
+}
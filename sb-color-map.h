@@ -0,0 +1,76 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_COLOR_MAP_H
+#define SB_COLOR_MAP_H
+
+#include <gtk/gtk.h>
+#include "sb-revision-table.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbColorMap        SbColorMap;
+typedef struct _SbColorMapPrivate SbColorMapPrivate;
+typedef struct _SbColorMapClass   SbColorMapClass;
+
+#define SB_TYPE_COLOR_MAP         (sb_color_map_get_type ())
+#define SB_COLOR_MAP(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_COLOR_MAP, SbColorMap))
+#define SB_COLOR_MAP_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_COLOR_MAP, SbColorMapClass))
+#define SB_IS_COLOR_MAP(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_COLOR_MAP))
+#define SB_IS_COLOR_MAP_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_COLOR_MAP))
+#define SB_COLOR_MAP_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_COLOR_MAP, SbColorMapClass))
+
+typedef enum {
+	SB_COLOR_BY_REVISION,
+	SB_COLOR_BY_AGE
+} SbColorMode;
+
+GType           sb_color_map_get_type (void);
+SbColorMap*     sb_color_map_new      (void);
+SbColorMode     sb_color_map_get_mode (SbColorMap const* self);
+void            sb_color_map_set_mode (SbColorMap      * self,
+				       SbColorMode       mode);
+void            sb_color_map_update   (SbColorMap      * self,
+				       SbRevisionTable * revisions,
+				       guint const     * ids,
+				       guint             n_ids);
+GdkColor const* sb_color_map_lookup   (SbColorMap const* self,
+				       guint             id);
+gfloat          sb_color_map_get_age  (SbColorMap const* self,
+				       guint             id);
+
+struct _SbColorMap {
+	GObject            base_instance;
+	SbColorMapPrivate* _private;
+};
+
+struct _SbColorMapClass {
+	GObjectClass       base_class;
+
+	/* signals */
+	void (*changed) (SbColorMap* self);
+};
+
+G_END_DECLS
+
+#endif /* !SB_COLOR_MAP_H */
@@ -0,0 +1,178 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-commit-graph.h"
+
+#include <string.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+/* Finds out whether git blame can use a commit-graph with changed-path
+ * Bloom filters; without them, every blame walks all the commits and
+ * diffs their trees.
+ *
+ * Only the header and the chunk table of the file are read (see
+ * gitformat-commit-graph(5)): "CGPH", the version, the hash version, the
+ * number of chunks, the number of base graphs, and then the chunk ids
+ * with their offsets. The filters are the chunks "BIDX" and "BDAT". For
+ * a split graph only the newest layer counts: it holds the new commits.
+ */
+
+#define HEADER_SIZE 8
+#define CHUNK_SIZE  12  /* 4 bytes id, 8 bytes offset */
+
+static gboolean
+graph_has_bloom (gchar const* path)
+{
+	GMappedFile * file = g_mapped_file_new (path, FALSE, NULL);
+	guchar const* contents;
+	gsize         length;
+	guint         n_chunks;
+	guint         i;
+	gboolean      index = FALSE;
+	gboolean      data  = FALSE;
+
+	if (!file) {
+		return FALSE;
+	}
+
+	contents = (guchar const*)g_mapped_file_get_contents (file);
+	length   = g_mapped_file_get_length (file);
+
+	if (length < HEADER_SIZE || memcmp (contents, "CGPH", 4) || contents[4] != 1) {
+		g_mapped_file_free (file);
+		return FALSE;
+	}
+
+	n_chunks = contents[6];
+	for (i = 0; i < n_chunks && HEADER_SIZE + (i + 1) * CHUNK_SIZE <= length; i++) {
+		guchar const* id = contents + HEADER_SIZE + i * CHUNK_SIZE;
+
+		index |= !memcmp (id, "BIDX", 4);
+		data  |= !memcmp (id, "BDAT", 4);
+	}
+
+	g_mapped_file_free (file);
+
+	return index && data;
+}
+
+/* the graph file, or the newest layer of a split one */
+static gchar*
+graph_find (gchar const* objects_dir)
+{
+	gchar * path = g_build_filename (objects_dir, "info", "commit-graph", NULL);
+	gchar * chain;
+	gchar * contents = NULL;
+	gchar** lines;
+	gchar*  name;
+	guint   n_lines;
+
+	if (g_file_test (path, G_FILE_TEST_IS_REGULAR)) {
+		return path;
+	}
+	g_free (path);
+
+	chain = g_build_filename (objects_dir, "info", "commit-graphs", "commit-graph-chain", NULL);
+	if (!g_file_get_contents (chain, &contents, NULL, NULL)) {
+		g_free (chain);
+		return NULL;
+	}
+	g_free (chain);
+
+	/* one hash per line, the base first */
+	lines   = g_strsplit (g_strstrip (contents), "\n", -1);
+	n_lines = g_strv_length (lines);
+	path    = NULL;
+	if (n_lines && *lines[n_lines - 1]) {
+		name = g_strdup_printf ("graph-%s.graph", lines[n_lines - 1]);
+		path = g_build_filename (objects_dir, "info", "commit-graphs", name, NULL);
+		g_free (name);
+	}
+
+	g_strfreev (lines);
+	g_free (contents);
+
+	return path;
+}
+
+/* the modification time of the newest pack; 0 without packs */
+time_t
+sb_commit_graph_pack_time (gchar const* objects_dir)
+{
+	gchar      * folder = g_build_filename (objects_dir, "pack", NULL);
+	GDir       * dir    = g_dir_open (folder, 0, NULL);
+	gchar const* name;
+	time_t       result = 0;
+
+	while (dir && (name = g_dir_read_name (dir))) {
+		struct stat buf;
+		gchar     * path;
+
+		if (!g_str_has_suffix (name, ".pack")) {
+			continue;
+		}
+
+		path = g_build_filename (folder, name, NULL);
+		if (!g_stat (path, &buf)) {
+			result = MAX (result, buf.st_mtime);
+		}
+		g_free (path);
+	}
+
+	if (dir) {
+		g_dir_close (dir);
+	}
+	g_free (folder);
+
+	return result;
+}
+
+SbCommitGraphState
+sb_commit_graph_check (gchar const* objects_dir)
+{
+	SbCommitGraphState result;
+	struct stat        buf;
+	gchar            * path;
+
+	g_return_val_if_fail (objects_dir, SB_COMMIT_GRAPH_MISSING);
+
+	path = graph_find (objects_dir);
+	if (!path || g_stat (path, &buf)) {
+		g_free (path);
+		return SB_COMMIT_GRAPH_MISSING;
+	}
+
+	if (!graph_has_bloom (path)) {
+		result = SB_COMMIT_GRAPH_NO_BLOOM;
+	} else if (buf.st_mtime < sb_commit_graph_pack_time (objects_dir)) {
+		/* the commits of a fetch or a repack lack the filters */
+		result = SB_COMMIT_GRAPH_STALE;
+	} else {
+		result = SB_COMMIT_GRAPH_OK;
+	}
+
+	g_free (path);
+
+	return result;
+}
@@ -0,0 +1,45 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_COMMIT_GRAPH_H
+#define SB_COMMIT_GRAPH_H
+
+#include <time.h>
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* worst first */
+typedef enum {
+	SB_COMMIT_GRAPH_MISSING,
+	SB_COMMIT_GRAPH_NO_BLOOM,  /* without changed-path Bloom filters */
+	SB_COMMIT_GRAPH_STALE,     /* older than the newest pack */
+	SB_COMMIT_GRAPH_OK
+} SbCommitGraphState;
+
+SbCommitGraphState sb_commit_graph_check     (gchar const* objects_dir);
+time_t             sb_commit_graph_pack_time (gchar const* objects_dir);
+
+G_END_DECLS
+
+#endif /* !SB_COMMIT_GRAPH_H */
@@ -1,9 +1,9 @@
-/* This file is part of ...
+/* This file is part of source browser
  *
  * AUTHORS
- *     Sven Herzberg  <herzi@gnome-de.org>
+ *     Sven Herzberg  <sven@imendio.com>
  *
- * Copyright (C) 2007  Sven Herzberg
+ * Copyright (C) 2008  Sven Herzberg
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public License as
@@ -23,3 +23,500 @@
 
 #include "sb-contributor.h"
 
+#include <string.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "sb-annotation-cache.h"
+#include "sb-git.h"
+#include "sb-scheduler.h"
+
+/* Counts the lines owned per author and per revision.
+ *
+ * Finished loads get merged with sb_contributor_add_loader(): the line
+ * index of a load already knows the lines of every revision, so merging
+ * a file costs one pass over its revisions, not over its lines.
+ *
+ * sb_contributor_scan() does that for every file git knows below a
+ * folder. The list comes from "git ls-files" and the files get blamed
+ * at indexing priority, as many at once as the scheduler runs processes
+ * (one per core); the annotation cache is asked first. "changed" is
+ * emitted at most every CHANGED_DELAY milliseconds while the numbers
+ * grow, "done" once at the end.
+ */
+
+#define CHANGED_DELAY 250
+#define MAX_SIZE      (1 << 20)  /* bytes; larger files are mostly generated */
+
+struct _SbContributorPrivate {
+	/* the ids below are from this table; not ours */
+	SbRevisionTable* revisions;
+
+	GArray         * author_lines;    /* of guint, by author id */
+	GArray         * author_files;
+	GArray         * revision_lines;  /* of guint, by revision id */
+	guint            n_lines;
+	guint            n_files;
+
+	/* scanning */
+	gchar          * folder;
+	guint            flags;
+	SbJob          * listing;
+	GQueue         * pending;         /* of gchar* paths */
+	GList          * running;         /* of SbHistoryLoader */
+	guint            changed_timeout;
+};
+
+enum {
+	CHANGED,
+	DONE,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+G_DEFINE_TYPE (SbContributor, sb_contributor, G_TYPE_OBJECT);
+
+static void
+sb_contributor_init (SbContributor* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_CONTRIBUTOR,
+						      SbContributorPrivate);
+
+	self->_private->author_lines   = g_array_new (FALSE, TRUE, sizeof (guint));
+	self->_private->author_files   = g_array_new (FALSE, TRUE, sizeof (guint));
+	self->_private->revision_lines = g_array_new (FALSE, TRUE, sizeof (guint));
+	self->_private->pending        = g_queue_new ();
+}
+
+static void
+contributor_finalize (GObject* object)
+{
+	SbContributor* self = SB_CONTRIBUTOR (object);
+
+	sb_contributor_cancel (self);
+
+	g_array_free (self->_private->author_lines,   TRUE);
+	g_array_free (self->_private->author_files,   TRUE);
+	g_array_free (self->_private->revision_lines, TRUE);
+	g_queue_free (self->_private->pending);
+	g_free (self->_private->folder);
+
+	G_OBJECT_CLASS (sb_contributor_parent_class)->finalize (object);
+}
+
+static void
+sb_contributor_class_init (SbContributorClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = contributor_finalize;
+
+	signals[CHANGED] = g_signal_new ("changed",
+					 SB_TYPE_CONTRIBUTOR,
+					 G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbContributorClass, changed),
+					 NULL, NULL,
+					 g_cclosure_marshal_VOID__VOID,
+					 G_TYPE_NONE, 0);
+	signals[DONE]    = g_signal_new ("done",
+					 SB_TYPE_CONTRIBUTOR,
+					 G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbContributorClass, done),
+					 NULL, NULL,
+					 g_cclosure_marshal_VOID__VOID,
+					 G_TYPE_NONE, 0);
+
+	g_type_class_add_private (self_class, sizeof (SbContributorPrivate));
+}
+
+SbContributor*
+sb_contributor_new (void)
+{
+	return g_object_new (SB_TYPE_CONTRIBUTOR, NULL);
+}
+
+static gboolean
+contributor_changed_cb (gpointer data)
+{
+	SbContributor* self = SB_CONTRIBUTOR (data);
+
+	self->_private->changed_timeout = 0;
+	g_signal_emit (self, signals[CHANGED], 0);
+
+	return FALSE;
+}
+
+static void
+contributor_queue_changed (SbContributor* self)
+{
+	if (!self->_private->changed_timeout) {
+		self->_private->changed_timeout = g_timeout_add (CHANGED_DELAY, contributor_changed_cb, self);
+	}
+}
+
+static inline void
+contributor_add (GArray* array,
+		 guint   index,
+		 guint   value)
+{
+	if (index >= array->len) {
+		g_array_set_size (array, index + 1);
+	}
+
+	g_array_index (array, guint, index) += value;
+}
+
+void
+sb_contributor_add_loader (SbContributor  * self,
+			   SbHistoryLoader* loader)
+{
+	SbRevisionTable  * revisions;
+	SbLineIndex const* index;
+	guint const      * ids;
+	guint              n_ids;
+	guint              i;
+	GHashTable       * authors;
+	GHashTableIter     iter;
+	gpointer           author;
+
+	g_return_if_fail (SB_IS_CONTRIBUTOR (self));
+	g_return_if_fail (SB_IS_HISTORY_LOADER (loader));
+
+	revisions = sb_history_loader_get_revisions (loader);
+	index     = sb_history_loader_get_lines (loader);
+	if (!revisions || !index) {
+		return;
+	}
+
+	if (!self->_private->revisions) {
+		self->_private->revisions = revisions;
+	} else if (self->_private->revisions != revisions) {
+		// FIXME: merge by name for folders with submodules
+		return;
+	}
+
+	/* the authors who own lines of this file */
+	authors = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	ids = sb_history_loader_get_revision_ids (loader, &n_ids);
+	for (i = 0; i < n_ids; i++) {
+		SbLineRange const* ranges;
+		guint              n_ranges;
+		guint              lines;
+		guint              author;
+
+		ranges = sb_line_index_get_revision_lines (index, ids[i], &n_ranges);
+		lines  = sb_line_index_count_lines (ranges, n_ranges);
+		if (!lines) {
+			continue;
+		}
+
+		contributor_add (self->_private->revision_lines, ids[i], lines);
+		self->_private->n_lines += lines;
+
+		author = sb_revision_table_get_author (revisions, ids[i]);
+		if (author != SB_REVISION_NONE) {
+			contributor_add (self->_private->author_lines, author, lines);
+			g_hash_table_insert (authors, GUINT_TO_POINTER (author), GUINT_TO_POINTER (author));
+		}
+	}
+
+	g_hash_table_iter_init (&iter, authors);
+	while (g_hash_table_iter_next (&iter, &author, NULL)) {
+		contributor_add (self->_private->author_files, GPOINTER_TO_UINT (author), 1);
+	}
+	g_hash_table_destroy (authors);
+
+	self->_private->n_files++;
+	contributor_queue_changed (self);
+}
+
+static gboolean
+contributor_is_busy (SbContributor const* self)
+{
+	return self->_private->listing || self->_private->running ||
+	       !g_queue_is_empty (self->_private->pending);
+}
+
+static void
+contributor_finish (SbContributor* self)
+{
+	if (self->_private->changed_timeout) {
+		g_source_remove (self->_private->changed_timeout);
+		self->_private->changed_timeout = 0;
+	}
+
+	g_signal_emit (self, signals[CHANGED], 0);
+	g_signal_emit (self, signals[DONE],    0);
+}
+
+static void contributor_run (SbContributor* self);
+
+static void
+loader_done_cb (SbHistoryLoader* loader,
+		SbContributor  * self)
+{
+	self->_private->running = g_list_remove (self->_private->running, loader);
+
+	/* files which git blame failed for (e.g. submodules) count for nothing */
+	if (sb_history_loader_get_references (loader)) {
+		sb_contributor_add_loader (self, loader);
+	}
+	g_object_unref (loader);
+
+	contributor_run (self);
+
+	if (!contributor_is_busy (self)) {
+		contributor_finish (self);
+	}
+}
+
+static void
+contributor_run (SbContributor* self)
+{
+	SbSchedulerStats stats;
+
+	/* the scheduler knows the number of cores */
+	sb_scheduler_get_stats (&stats);
+
+	while (g_list_length (self->_private->running) < stats.limit) {
+		gchar          * path = g_queue_pop_head (self->_private->pending);
+		SbHistoryLoader* loader;
+		struct stat      buf;
+
+		if (!path) {
+			break;
+		}
+
+		if (g_stat (path, &buf) || !S_ISREG (buf.st_mode) || buf.st_size > MAX_SIZE) {
+			g_free (path);
+			continue;
+		}
+
+		loader = sb_annotation_cache_lookup (path, self->_private->flags);
+		if (loader) {
+			g_free (path);
+			sb_contributor_add_loader (self, loader);
+			continue;
+		}
+
+		loader = sb_history_loader_new (path, self->_private->flags);
+		g_free (path);
+
+		sb_history_loader_set_background (loader, TRUE);
+		sb_history_loader_set_priority (loader, SB_JOB_PRIORITY_INDEX);
+		if (!sb_history_loader_start (loader, NULL)) {
+			g_object_unref (loader);
+			continue;
+		}
+
+		g_signal_connect (loader, "done",
+				  G_CALLBACK (loader_done_cb), self);
+		self->_private->running = g_list_prepend (self->_private->running, loader);
+	}
+}
+
+static void
+listing_read_lines_cb (SbAsyncReader    * reader,
+		       SbLineBatch const* batch,
+		       SbContributor    * self)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_lines; i++) {
+		if (!*batch->lines[i] || *batch->lines[i] == '"') {
+			// FIXME: unquote the names with control characters
+			continue;
+		}
+
+		g_queue_push_tail (self->_private->pending,
+				   g_build_filename (self->_private->folder, batch->lines[i], NULL));
+	}
+
+	contributor_run (self);
+}
+
+static void
+listing_done_cb (SbContributor* self,
+		 SbJob        * job)
+{
+	g_signal_handlers_disconnect_by_func (sb_job_get_reader (job), listing_read_lines_cb, self);
+	g_signal_handlers_disconnect_by_func (job, listing_done_cb, self);
+	g_object_unref (self->_private->listing);
+	self->_private->listing = NULL;
+
+	if (!contributor_is_busy (self)) {
+		contributor_finish (self);
+	}
+}
+
+/* forgets the numbers (but doesn't stop a scan) */
+void
+sb_contributor_clear (SbContributor* self)
+{
+	g_return_if_fail (SB_IS_CONTRIBUTOR (self));
+
+	g_array_set_size (self->_private->author_lines,   0);
+	g_array_set_size (self->_private->author_files,   0);
+	g_array_set_size (self->_private->revision_lines, 0);
+	self->_private->n_lines   = 0;
+	self->_private->n_files   = 0;
+	self->_private->revisions = NULL;
+
+	contributor_queue_changed (self);
+}
+
+/* the numbers of all files below @folder; flags are the SbSettingsKeys for
+ * git blame (without copy and move detection, a whole repository takes
+ * minutes instead of hours) */
+gboolean
+sb_contributor_scan (SbContributor* self,
+		     gchar const  * folder,
+		     guint          flags,
+		     GError      ** error)
+{
+	g_return_val_if_fail (SB_IS_CONTRIBUTOR (self), FALSE);
+	g_return_val_if_fail (folder && g_path_is_absolute (folder), FALSE);
+
+	sb_contributor_cancel (self);
+	sb_contributor_clear (self);
+
+	g_free (self->_private->folder);
+	self->_private->folder = g_strdup (folder);
+	self->_private->flags  = flags;
+
+	/* paths relative to the folder, and unquoted unless really strange */
+	self->_private->listing = sb_git_job_new (folder, 0,
+						  "-c", "core.quotePath=false",
+						  "ls-files",
+						  NULL);
+	sb_job_set_priority (self->_private->listing, SB_JOB_PRIORITY_INDEX);
+	if (!sb_job_start (self->_private->listing, error)) {
+		g_object_unref (self->_private->listing);
+		self->_private->listing = NULL;
+		return FALSE;
+	}
+
+	g_signal_connect (sb_job_get_reader (self->_private->listing), "read-lines",
+			  G_CALLBACK (listing_read_lines_cb), self);
+	g_signal_connect_swapped (self->_private->listing, "done",
+				  G_CALLBACK (listing_done_cb), self);
+
+	return TRUE;
+}
+
+void
+sb_contributor_cancel (SbContributor* self)
+{
+	gchar* path;
+
+	g_return_if_fail (SB_IS_CONTRIBUTOR (self));
+
+	if (self->_private->listing) {
+		g_signal_handlers_disconnect_matched (sb_job_get_reader (self->_private->listing), G_SIGNAL_MATCH_DATA,
+						      0, 0, NULL, NULL, self);
+		g_signal_handlers_disconnect_matched (self->_private->listing, G_SIGNAL_MATCH_DATA,
+						      0, 0, NULL, NULL, self);
+		sb_job_cancel (self->_private->listing);
+		g_object_unref (self->_private->listing);
+		self->_private->listing = NULL;
+	}
+
+	while (self->_private->running) {
+		SbHistoryLoader* loader = self->_private->running->data;
+
+		g_signal_handlers_disconnect_by_func (loader, loader_done_cb, self);
+		sb_history_loader_cancel (loader);
+		g_object_unref (loader);
+		self->_private->running = g_list_delete_link (self->_private->running, self->_private->running);
+	}
+
+	while ((path = g_queue_pop_head (self->_private->pending))) {
+		g_free (path);
+	}
+
+	if (self->_private->changed_timeout) {
+		g_source_remove (self->_private->changed_timeout);
+		self->_private->changed_timeout = 0;
+	}
+}
+
+gboolean
+sb_contributor_is_done (SbContributor const* self)
+{
+	g_return_val_if_fail (SB_IS_CONTRIBUTOR (self), FALSE);
+
+	return !contributor_is_busy (self);
+}
+
+SbRevisionTable*
+sb_contributor_get_revisions (SbContributor const* self)
+{
+	g_return_val_if_fail (SB_IS_CONTRIBUTOR (self), NULL);
+
+	return self->_private->revisions;
+}
+
+/* indexed by the author ids of the revision table */
+guint const*
+sb_contributor_get_author_lines (SbContributor const* self,
+				 guint              * n_authors)
+{
+	g_return_val_if_fail (SB_IS_CONTRIBUTOR (self), NULL);
+	g_return_val_if_fail (n_authors, NULL);
+
+	*n_authors = self->_private->author_lines->len;
+
+	return (guint const*)self->_private->author_lines->data;
+}
+
+/* the number of files each author owns lines of */
+guint const*
+sb_contributor_get_author_files (SbContributor const* self,
+				 guint              * n_authors)
+{
+	g_return_val_if_fail (SB_IS_CONTRIBUTOR (self), NULL);
+	g_return_val_if_fail (n_authors, NULL);
+
+	*n_authors = self->_private->author_files->len;
+
+	return (guint const*)self->_private->author_files->data;
+}
+
+/* indexed by the revision ids of the revision table */
+guint const*
+sb_contributor_get_revision_lines (SbContributor const* self,
+				   guint              * n_revisions)
+{
+	g_return_val_if_fail (SB_IS_CONTRIBUTOR (self), NULL);
+	g_return_val_if_fail (n_revisions, NULL);
+
+	*n_revisions = self->_private->revision_lines->len;
+
+	return (guint const*)self->_private->revision_lines->data;
+}
+
+guint
+sb_contributor_get_n_lines (SbContributor const* self)
+{
+	g_return_val_if_fail (SB_IS_CONTRIBUTOR (self), 0);
+
+	return self->_private->n_lines;
+}
+
+guint
+sb_contributor_get_n_files (SbContributor const* self)
+{
+	g_return_val_if_fail (SB_IS_CONTRIBUTOR (self), 0);
+
+	return self->_private->n_files;
+}
+
+/* the files still to be counted */
+guint
+sb_contributor_get_n_pending (SbContributor const* self)
+{
+	g_return_val_if_fail (SB_IS_CONTRIBUTOR (self), 0);
+
+	return g_queue_get_length (self->_private->pending) + g_list_length (self->_private->running);
+}
@@ -1,9 +1,9 @@
-/* This file is part of ...
+/* This file is part of source browser
  *
  * AUTHORS
- *     Sven Herzberg  <herzi@gnome-de.org>
+ *     Sven Herzberg  <sven@imendio.com>
  *
- * Copyright (C) 2007  Sven Herzberg
+ * Copyright (C) 2008  Sven Herzberg
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public License as
@@ -24,5 +24,56 @@
 #ifndef SB_CONTRIBUTOR_H
 #define SB_CONTRIBUTOR_H
 
+#include "sb-history-loader.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbContributor        SbContributor;
+typedef struct _SbContributorPrivate SbContributorPrivate;
+typedef struct _SbContributorClass   SbContributorClass;
+
+#define SB_TYPE_CONTRIBUTOR         (sb_contributor_get_type ())
+#define SB_CONTRIBUTOR(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_CONTRIBUTOR, SbContributor))
+#define SB_CONTRIBUTOR_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_CONTRIBUTOR, SbContributorClass))
+#define SB_IS_CONTRIBUTOR(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_CONTRIBUTOR))
+#define SB_IS_CONTRIBUTOR_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_CONTRIBUTOR))
+#define SB_CONTRIBUTOR_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_CONTRIBUTOR, SbContributorClass))
+
+GType            sb_contributor_get_type           (void);
+SbContributor*   sb_contributor_new                (void);
+void             sb_contributor_clear              (SbContributor      * self);
+void             sb_contributor_add_loader         (SbContributor      * self,
+						    SbHistoryLoader    * loader);
+gboolean         sb_contributor_scan               (SbContributor      * self,
+						    gchar const        * folder,
+						    guint                flags,
+						    GError            ** error);
+void             sb_contributor_cancel             (SbContributor      * self);
+gboolean         sb_contributor_is_done            (SbContributor const* self);
+SbRevisionTable* sb_contributor_get_revisions      (SbContributor const* self);
+guint const*     sb_contributor_get_author_lines   (SbContributor const* self,
+						    guint              * n_authors);
+guint const*     sb_contributor_get_author_files   (SbContributor const* self,
+						    guint              * n_authors);
+guint const*     sb_contributor_get_revision_lines (SbContributor const* self,
+						    guint              * n_revisions);
+guint            sb_contributor_get_n_lines        (SbContributor const* self);
+guint            sb_contributor_get_n_files        (SbContributor const* self);
+guint            sb_contributor_get_n_pending      (SbContributor const* self);
+
+struct _SbContributor {
+	GObject               base_instance;
+	SbContributorPrivate* _private;
+};
+
+struct _SbContributorClass {
+	GObjectClass          base_class;
+
+	/* signals */
+	void (*changed) (SbContributor* self);
+	void (*done)    (SbContributor* self);
+};
+
+G_END_DECLS
 
 #endif /* !SB_CONTRIBUTOR_H */
@@ -23,19 +23,27 @@
 
 #include "sb-display.h"
 
-#include <gfc/gfc-job.h>
-#include <gfc/gfc-spawn-screen.h>
+#include <string.h>
+#include <gio/gio.h>
 
+#include "sb-annotation-cache.h"
 #include "sb-annotations.h"
 #include "sb-callback-data.h"
-#include "sb-comparable.h"
+#include "sb-git.h"
+#include "sb-history-loader.h"
+#include "sb-hunk.h"
+#include "sb-line-index.h"
+#include "sb-line-map.h"
 #include "sb-marshallers.h"
-#include "sb-reference.h"
+#include "sb-minimap.h"
+#include "sb-prefetcher.h"
 #include "sb-settings.h"
 
 struct _SbDisplayPrivate {
 	SbAnnotations* annotations;
 	GtkTextView  * text_view;
+	SbMinimap    * minimap;
+	SbColorMap   * colors;
 
 	/* these two are ours */
 	GtkAdjustment* horizontal;
@@ -45,19 +53,98 @@ struct _SbDisplayPrivate {
 	GtkAdjustment* anno_horizontal;
 	GtkAdjustment* anno_vertical;
 
-	/* the following are only valid during history loading */
-	// FIXME: move them into an SbHistoryLoader
-	GList        * references;
-	GfcReader    * reader;
-	GHashTable   * revisions;
-	SbRevision   * revision; // FIXME: drop this one
-	SbReference  * reference;
+	gchar        * path;
+	gchar        * revision;        /* NULL for the working copy */
+	SbRepository * repository;
+	guint          blame_flags;     /* the settings the annotations were created with */
+	guint          settings_notify;
+	gboolean       reload_pending;  /* settings changed during a load */
+
+	/* what the loaded text and annotations were made from; with edits in
+	 * the buffer, the checksum follows the file on disk only */
+	gchar        * checksum;
+	guint          n_text_lines;    /* as git counts them */
+	gchar        * head;
+	GFileMonitor * monitor;
+	guint          refresh_timeout;
+
+	/* the finished load being shown; shared with the annotation cache */
+	SbHistoryLoader   * history;
+
+	/* the lines of every revision and author of the loaded file */
+	SbLineIndex const * lines;
+	GtkTextTag   * highlight_tag;
+	GtkTextTag   * dimmed_tag;
+	guint          highlight_revision;
+	guint          highlight_author;
+	gboolean       filtered;
+
+	/* the references sorted by line, for lookups by line number */
+	GPtrArray    * references;
+
+	/* the lines of the blamed file => the lines of the edited buffer */
+	SbLineMap    * line_map;
+	/* the same for the text of the running load, until it gets shown */
+	SbLineMap    * next_line_map;
+
+	/* only the visible lines get tinted; one tag per color */
+	GHashTable   * tint_tags;
+	gint           tint_first;      /* tinted lines; empty if first > last */
+	gint           tint_last;
+	guint          tint_idle;
+
+	/* only valid during history loading */
+	SbHistoryLoader* loader;
+
+	/* the blame with copy and move detection, after the quick one */
+	SbHistoryLoader* refiner;
+	guint            refine_timeout;
+
+	/* how often each line changed; shared with the annotation cache */
+	SbChurn        * churn;
+
+	/* the file in a past revision, until cat-file delivers it */
+	gchar          * blob;
+	gchar          * blob_path;
+	gchar          * blob_revision;
+	guint            blob_line;
+	guint            blob_n_lines;
+
+	/* of Location, where the revisions were entered from; most recent first */
+	GQueue         * back;
+
+	/* the diff that takes a drilled down hunk to the lines of the parent */
+	SbJob          * mapping;
+	GArray         * mapping_hunks;   /* of SbHunk */
+	guint            mapping_start;   /* the lines of the hunk in its revision */
+	guint            mapping_end;
+
+	/* of Blob, the texts of past revisions; most recently used first */
+	GQueue         * blobs;
+	GHashTable     * blob_links;    /* name => link in blobs */
+
+	/* of SbHistoryLoader, the blames of the neighbouring revisions */
+	GList          * prefetching;
 };
 
+typedef struct {
+	gchar  * name;   /* "revision:path" */
+	GString* contents;
+} Blob;
+
+typedef struct {
+	gchar* path;
+	gchar* revision;
+	guint  line;
+	gchar* edits;    /* the edited text of the working copy, or NULL */
+	gsize  edits_length;
+} Location;
+
 enum {
 	LOAD_STARTED,
 	LOAD_PROGRESS,
 	LOAD_DONE,
+	FILE_CHANGED,
 	// FIXME: LOAD_CANCELLED,
 	N_SIGNALS
 };
@@ -66,6 +153,99 @@ static guint signals[N_SIGNALS] = {0};
 
 G_DEFINE_TYPE (SbDisplay, sb_display, GTK_TYPE_HBOX);
 
+static void load_history (SbDisplay   * self,
+			  gchar const * file_path,
+			  SbHunk const* change);
+static void reference_clicked_cb (SbAnnotations* annotations,
+				  SbReference  * reference,
+				  guint          modifiers,
+				  SbDisplay    * self);
+static void display_queue_tint   (SbDisplay    * self);
+static void display_update_viewport (SbDisplay * self);
+static void display_queue_refresh (SbDisplay   * self);
+static void display_stop_refining (SbDisplay   * self);
+static void display_start_refining (SbDisplay      * self,
+				    SbHistoryLoader* quick);
+static void refiner_done_cb        (SbDisplay      * self,
+				    SbHistoryLoader* refiner);
+static void display_stop_churn     (SbDisplay      * self);
+static void display_show_blob      (SbDisplay      * self,
+				    gchar const    * contents,
+				    gsize            length);
+static void blob_free              (Blob           * blob);
+static void display_stop_loading   (SbDisplay      * self);
+static void display_stop_mapping   (SbDisplay      * self);
+static void display_stop_prefetch  (SbDisplay      * self,
+				    SbHistoryLoader* loader);
+static void display_load_churn     (SbDisplay      * self);
+static gboolean churn_expose_event_cb (GtkWidget     * text_view,
+				       GdkEventExpose* event,
+				       SbDisplay     * self);
+static void buffer_insert_text_cb  (GtkTextBuffer* buffer,
+				    GtkTextIter  * location,
+				    gchar const  * text,
+				    gint           length,
+				    SbDisplay    * self);
+static void buffer_delete_range_cb (GtkTextBuffer* buffer,
+				    GtkTextIter  * start,
+				    GtkTextIter  * end,
+				    SbDisplay    * self);
+
+/* editors and git touch files several times in a row */
+#define REFRESH_DELAY 500
+
+/* blamed first on a fresh load, until the view knows its size */
+#define VIEWPORT_MIN_LINES 100
+
+/* the most expensive options of git blame; shown later */
+#define REFINE_FLAGS (SB_SETTINGS_FOLLOW_COPIES | SB_SETTINGS_FOLLOW_MOVES)
+
+/* seconds git may run for it; pathological files keep the quick blame */
+#define REFINE_BUDGET 30
+
+/* pixels; the churn column left of the text */
+#define CHURN_WIDTH 6
+
+/* the texts of past revisions kept for stepping through them */
+#define MAX_BLOBS 32
+
+/* blames of neighbouring revisions running at once */
+#define MAX_PREFETCH 4
+
+static void
+settings_changed_cb (SbSettingsKey changed,
+		     gpointer      user_data)
+{
+	SbDisplay* self = SB_DISPLAY (user_data);
+
+	if (changed & SB_SETTINGS_COLOR_BY_AGE) {
+		sb_color_map_set_mode (self->_private->colors,
+				       sb_settings_get_color_by_age () ? SB_COLOR_BY_AGE : SB_COLOR_BY_REVISION);
+	}
+	if (changed & SB_SETTINGS_TINT_LINES) {
+		display_queue_tint (self);
+	}
+	if (changed & SB_SETTINGS_SHOW_CHURN) {
+		display_load_churn (self);
+	}
+
+	if (!self->_private->path ||
+	    !((sb_settings_get_flags () ^ self->_private->blame_flags) & SB_SETTINGS_BLAME_KEYS))
+	{
+		/* nothing loaded or nothing relevant for us */
+		return;
+	}
+
+	if (self->_private->loader) {
+		/* re-blame once the current load is done */
+		self->_private->reload_pending = TRUE;
+		return;
+	}
+
+	g_signal_emit (self, signals[LOAD_STARTED], 0);
+	load_history (self, self->_private->path, NULL);
+}
+
 static void
 sb_display_init (SbDisplay* self)
 {
@@ -98,10 +278,66 @@ sb_display_init (SbDisplay* self)
 	sb_annotations_set_text_view (self->_private->annotations,
 				      self->_private->text_view);
 
-	self->_private->revisions = g_hash_table_new_full ((GHashFunc)sb_comparable_hash,
-							   (GEqualFunc)sb_comparable_equals,
-							   NULL,
-							   g_object_unref);
+	self->_private->highlight_tag = gtk_text_buffer_create_tag (gtk_text_view_get_buffer (self->_private->text_view),
+								    "highlight",
+								    "background", "#fce94f", // butter
+								    NULL);
+	self->_private->dimmed_tag = gtk_text_buffer_create_tag (gtk_text_view_get_buffer (self->_private->text_view),
+								 "dimmed",
+								 "foreground", "#babdb6", // aluminium
+								 NULL);
+	self->_private->highlight_revision = SB_REVISION_NONE;
+	self->_private->highlight_author   = SB_REVISION_NONE;
+
+	self->_private->references = g_ptr_array_new ();
+	self->_private->back       = g_queue_new ();
+	self->_private->mapping_hunks = g_array_new (FALSE, FALSE, sizeof (SbHunk));
+	self->_private->blobs      = g_queue_new ();
+	self->_private->blob_links = g_hash_table_new (g_str_hash, g_str_equal);
+	self->_private->tint_tags  = g_hash_table_new (g_direct_hash, g_direct_equal);
+	self->_private->tint_first = 0;
+	self->_private->tint_last  = -1;
+	g_signal_connect_swapped (self->_private->text_view, "size-allocate",
+				  G_CALLBACK (display_queue_tint), self);
+	g_signal_connect (self->_private->text_view, "expose-event",
+			  G_CALLBACK (churn_expose_event_cb), self);
+
+	/* before the default handlers, the iters still point into the old text */
+	g_signal_connect (gtk_text_view_get_buffer (self->_private->text_view), "insert-text",
+			  G_CALLBACK (buffer_insert_text_cb), self);
+	g_signal_connect (gtk_text_view_get_buffer (self->_private->text_view), "delete-range",
+			  G_CALLBACK (buffer_delete_range_cb), self);
+
+	g_signal_connect (self->_private->annotations, "reference-clicked",
+			  G_CALLBACK (reference_clicked_cb), self);
+
+	self->_private->colors = sb_color_map_new ();
+	sb_color_map_set_mode (self->_private->colors,
+			       sb_settings_get_color_by_age () ? SB_COLOR_BY_AGE : SB_COLOR_BY_REVISION);
+	sb_annotations_set_color_map (self->_private->annotations,
+				      self->_private->colors);
+	g_signal_connect_swapped (self->_private->colors, "changed",
+				  G_CALLBACK (display_queue_tint), self);
+
+	widget = sb_minimap_new (self->_private->colors);
+	gtk_widget_show (widget);
+	gtk_box_pack_start (GTK_BOX (self),
+			    widget,
+			    FALSE,
+			    FALSE,
+			    0);
+	self->_private->minimap = SB_MINIMAP (widget);
+
+	self->_private->settings_notify = sb_settings_notify_add (settings_changed_cb, self);
+}
+
+static void
+location_free (Location* location)
+{
+	g_free (location->path);
+	g_free (location->revision);
+	g_free (location->edits);
+	g_slice_free (Location, location);
 }
 
 static void
@@ -111,7 +347,55 @@ display_finalize (GObject* object)
 
 	// FIXME: g_warn_if_fail (!self->_private->horizontal)
 	// FIXME: g_warn_if_fail (!self->_private->vertical)
-	g_hash_table_destroy (self->_private->revisions);
+	sb_settings_notify_remove (self->_private->settings_notify);
+	if (self->_private->refresh_timeout) {
+		g_source_remove (self->_private->refresh_timeout);
+	}
+	if (self->_private->monitor) {
+		g_file_monitor_cancel (self->_private->monitor);
+		g_object_unref (self->_private->monitor);
+	}
+	g_free (self->_private->checksum);
+	g_free (self->_private->head);
+	if (self->_private->tint_idle) {
+		g_source_remove (self->_private->tint_idle);
+	}
+	g_hash_table_destroy (self->_private->tint_tags);
+	g_ptr_array_foreach (self->_private->references, (GFunc)g_object_unref, NULL);
+	g_ptr_array_free (self->_private->references, TRUE);
+	g_signal_handlers_disconnect_by_func (self->_private->colors, display_queue_tint, self);
+	g_object_unref (self->_private->colors);
+	if (self->_private->history) {
+		g_object_unref (self->_private->history);
+	}
+	if (self->_private->line_map) {
+		sb_line_map_free (self->_private->line_map);
+	}
+	display_stop_loading (self);
+	display_stop_refining (self);
+	display_stop_churn (self);
+	while (!g_queue_is_empty (self->_private->back)) {
+		location_free (g_queue_pop_head (self->_private->back));
+	}
+	g_queue_free (self->_private->back);
+	display_stop_mapping (self);
+	g_array_free (self->_private->mapping_hunks, TRUE);
+	g_queue_foreach (self->_private->blobs, (GFunc)blob_free, NULL);
+	g_queue_free (self->_private->blobs);
+	g_hash_table_destroy (self->_private->blob_links);
+	while (self->_private->prefetching) {
+		display_stop_prefetch (self, self->_private->prefetching->data);
+	}
+	g_free (self->_private->blob);
+	g_free (self->_private->blob_path);
+	g_free (self->_private->blob_revision);
+	g_free (self->_private->revision);
+	g_free (self->_private->path);
+	if (self->_private->repository) {
+		g_signal_handlers_disconnect_by_func (self->_private->repository, display_queue_refresh, self);
+		sb_cat_file_cancel (sb_repository_get_cat_file (self->_private->repository), self);
+		g_object_unref (self->_private->repository);
+	}
 
 	G_OBJECT_CLASS (sb_display_parent_class)->finalize (object);
 }
@@ -123,6 +407,9 @@ update_range (GtkAdjustment* master,
 	gtk_layout_set_size (GTK_LAYOUT (self->_private->annotations),
 			     100, // FIXME: get the 100 scalable in some way
 			     master->upper - master->lower);
+	/* the heights of edited lines get known late */
+	sb_annotations_queue_layout (self->_private->annotations);
+	display_queue_tint (self);
 }
 
 static void
@@ -130,6 +417,8 @@ update_value (GtkAdjustment* master,
 	      SbDisplay    * self)
 {
 	gtk_adjustment_set_value (self->_private->anno_vertical, master->value);
+	display_queue_tint (self);
+	display_update_viewport (self);
 }
 
 static void
@@ -215,6 +504,12 @@ sb_display_class_init (SbDisplayClass* self_class)
 					       NULL, NULL,
 					       g_cclosure_marshal_VOID__VOID,
 					       G_TYPE_NONE, 0);
+	signals[FILE_CHANGED] = g_signal_new  ("file-changed",
+					       SB_TYPE_DISPLAY,
+					       0, 0,
+					       NULL, NULL,
+					       g_cclosure_marshal_VOID__VOID,
+					       G_TYPE_NONE, 0);
 }
 
 GtkWidget*
@@ -231,179 +526,1792 @@ sb_display_get_n_lines (SbDisplay const* self)
 	return gtk_text_buffer_get_line_count (gtk_text_view_get_buffer (self->_private->text_view));
 }
 
-static gint
-sort_refs_by_target_line (gconstpointer a,
-			  gconstpointer b)
+static void
+display_set_references (SbDisplay* self,
+			GList    * references)
 {
-	return sb_reference_get_current_start (a) - sb_reference_get_current_start (b);
+	g_ptr_array_foreach (self->_private->references, (GFunc)g_object_unref, NULL);
+	g_ptr_array_set_size (self->_private->references, 0);
+
+	for (; references; references = references->next) {
+		g_ptr_array_add (self->_private->references, g_object_ref (references->data));
+	}
+
+	display_queue_tint (self);
 }
 
-static void
-display_parse_line (GfcReader  * reader,
-		    gchar const* line,
-		    SbDisplay  * self)
+/* the index of the reference containing @line (or the one before it) */
+static guint
+display_find_reference (SbDisplay* self,
+			guint      line)
 {
-#undef DEBUG_DISPLAY
-	g_return_if_fail (SB_IS_DISPLAY (self));
+	GPtrArray* references = self->_private->references;
+	guint      low = 0;
+	guint      high = references->len;
+
+	while (low < high) {
+		guint middle = low + (high - low) / 2;
 
-	// FIXME: make sure we have a new hash table each time
-	if (G_UNLIKELY (!self->_private->revision)) {
-		/* from git-annotate (1)
-		 * "<40-byte hex sha1> <sourceline> <resultline> <num_lines>"
-		 */
-		gchar     **words    = g_strsplit (line, " ", -1);
-		SbRevision* revision = sb_revision_new (words[0]);
-		gint        n_lines  = atoi (words[3]);
-
-		self->_private->revision = g_hash_table_lookup (self->_private->revisions,
-								revision);
-
-		if (!self->_private->revision) {
-			self->_private->revision = g_object_ref (revision);
-			// FIXME: create an API for SbHashedVector
-			g_hash_table_insert (self->_private->revisions,
-					     self->_private->revision,
-					     self->_private->revision);
+		if (sb_reference_get_current_start (g_ptr_array_index (references, middle)) <= line) {
+			low = middle + 1;
+		} else {
+			high = middle;
 		}
+	}
+
+	return low ? low - 1 : 0;
+}
+
+/* the line of the buffer for a line of the blamed file (both from 1) */
+static guint
+display_map_line (SbDisplay* self,
+		  guint      line)
+{
+	return self->_private->line_map ? sb_line_map_get_line (self->_private->line_map, line) : line;
+}
+
+static guint
+display_unmap_line (SbDisplay* self,
+		    guint      line)
+{
+	return self->_private->line_map ? sb_line_map_get_original (self->_private->line_map, line) : line;
+}
+
+static GtkTextTag*
+display_get_tint_tag (SbDisplay     * self,
+		      GdkColor const* color)
+{
+	guint       key = ((color->red >> 8) << 16) | ((color->green >> 8) << 8) | (color->blue >> 8);
+	GtkTextTag* tag = g_hash_table_lookup (self->_private->tint_tags, GUINT_TO_POINTER (key));
+
+	if (G_UNLIKELY (!tag)) {
+		tag = gtk_text_buffer_create_tag (gtk_text_view_get_buffer (self->_private->text_view),
+						  NULL,
+						  "paragraph-background-gdk", color,
+						  NULL);
+		/* below the highlight and the dimming */
+		gtk_text_tag_set_priority (tag, 0);
+		g_hash_table_insert (self->_private->tint_tags, GUINT_TO_POINTER (key), tag);
+	}
 
-		self->_private->reference = sb_reference_new (self->_private->revision,
-							      atoi (words[2]),
-							      atoi (words[2]) + n_lines - 1);
-
-		g_signal_emit (self,
-			       signals[LOAD_PROGRESS],
-			       0,
-			       n_lines);
-
-		g_object_unref (revision);
-		g_strfreev (words);
-	} else if (g_str_has_prefix (line, "filename ")) {
-		gchar** vector = g_strsplit (line, " ", 2);
-#ifdef DEBUG_DISPLAY
-		g_print ("%s\n", sb_revision_get_name (self->_private->revision));
-#endif
-		self->_private->revision = NULL;
-		sb_reference_set_filename (self->_private->reference,
-					   vector[1]);
-		// FIXME: use a GSequence for the revisions (maybe that would make the API nicer too)
-		self->_private->references = g_list_insert_sorted (self->_private->references,
-								   g_object_ref (self->_private->reference),
-								   sort_refs_by_target_line);
-		g_object_unref (self->_private->reference);
-		self->_private->reference = NULL;
-		g_strfreev (vector);
-	} else if (g_str_has_prefix (line, "summary ")) {
-		gchar** vector = g_strsplit (line, " ", 2);
-		sb_revision_set_summary (self->_private->revision,
-					 vector[1]);
-		g_strfreev (vector);
-#ifdef DEBUG_DISPLAY
+	return tag;
+}
+
+static void
+display_get_line_iter (GtkTextBuffer* buffer,
+		       GtkTextIter  * iter,
+		       gint           line)
+{
+	/* gtk_text_buffer_get_iter_at_line() stops at the start of the last line */
+	if (line >= gtk_text_buffer_get_line_count (buffer)) {
+		gtk_text_buffer_get_end_iter (buffer, iter);
 	} else {
-		// FIXME: meta-information about the commit
-		g_debug ("Got unknown line: %s",
-			 line);
-#endif
+		gtk_text_buffer_get_iter_at_line (buffer, iter, line);
+	}
+}
+
+static void
+display_untint (SbDisplay* self)
+{
+	GtkTextBuffer* buffer = gtk_text_view_get_buffer (self->_private->text_view);
+	GtkTextIter    start;
+	GtkTextIter    end;
+	GHashTableIter iter;
+	gpointer       tag;
+
+	if (self->_private->tint_first > self->_private->tint_last) {
+		return;
+	}
+
+	display_get_line_iter (buffer, &start, self->_private->tint_first);
+	display_get_line_iter (buffer, &end, self->_private->tint_last + 1);
+
+	g_hash_table_iter_init (&iter, self->_private->tint_tags);
+	while (g_hash_table_iter_next (&iter, NULL, &tag)) {
+		gtk_text_buffer_remove_tag (buffer, tag, &start, &end);
+	}
+
+	self->_private->tint_first = 0;
+	self->_private->tint_last  = -1;
+}
+
+/* the lines of the buffer on screen (from 0), with half a screen of
+ * margin on either side */
+static void
+display_get_visible_lines (SbDisplay* self,
+			   gint     * first,
+			   gint     * last)
+{
+	GdkRectangle visible;
+	GtkTextIter  iter;
+	gint         margin;
+
+	gtk_text_view_get_visible_rect (self->_private->text_view, &visible);
+	gtk_text_view_get_line_at_y (self->_private->text_view, &iter, visible.y, NULL);
+	*first = gtk_text_iter_get_line (&iter);
+	gtk_text_view_get_line_at_y (self->_private->text_view, &iter, visible.y + visible.height, NULL);
+	*last  = gtk_text_iter_get_line (&iter);
+
+	margin = (*last - *first) / 2 + 1;
+	*first = MAX (*first - margin, 0);
+	*last  = MIN (*last + margin, gtk_text_buffer_get_line_count (gtk_text_view_get_buffer (self->_private->text_view)) - 1);
+}
+
+/* the lines leaving the view lose their tags, so the work (and the number
+ * of tagged ranges) depends on the size of the view, not of the file */
+static gboolean
+display_tint (gpointer data)
+{
+	SbDisplay    * self = SB_DISPLAY (data);
+	GtkTextBuffer* buffer = gtk_text_view_get_buffer (self->_private->text_view);
+	GtkTextIter    start;
+	GtkTextIter    end;
+	gint           first;
+	gint           last;
+	guint          i;
+
+	self->_private->tint_idle = 0;
+
+	display_untint (self);
+
+	if (!sb_settings_get_tint_lines () || !self->_private->references->len) {
+		return FALSE;
+	}
+
+	display_get_visible_lines (self, &first, &last);
+
+	/* one tag per hunk (the references count from 1) */
+	for (i = display_find_reference (self, MAX (display_unmap_line (self, first + 1), 1));
+	     i < self->_private->references->len; i++)
+	{
+		SbReference* reference = g_ptr_array_index (self->_private->references, i);
+		gint         hunk_start = display_map_line (self, sb_reference_get_current_start (reference)) - 1;
+		gint         hunk_end   = display_map_line (self, sb_reference_get_current_end (reference)) - 1;
+
+		if (hunk_start > last) {
+			break;
+		}
+
+		hunk_start = MAX (hunk_start, first);
+		hunk_end   = MIN (hunk_end, last);
+		if (hunk_start > hunk_end) {
+			continue;
+		}
+
+		display_get_line_iter (buffer, &start, hunk_start);
+		display_get_line_iter (buffer, &end, hunk_end + 1);
+		gtk_text_buffer_apply_tag (buffer,
+					   display_get_tint_tag (self,
+								 sb_color_map_lookup (self->_private->colors,
+										      sb_revision_get_id (sb_reference_get_revision (reference)))),
+					   &start, &end);
+	}
+
+	self->_private->tint_first = first;
+	self->_private->tint_last  = last;
+
+	return FALSE;
+}
+
+static void
+display_queue_tint (SbDisplay* self)
+{
+	if (!self->_private->tint_idle) {
+		/* after the resize, before the redraw */
+		self->_private->tint_idle = g_idle_add_full (G_PRIORITY_HIGH_IDLE + 15,
+							     display_tint, self, NULL);
+	}
+}
+
+static void
+display_lines_moved (SbDisplay* self)
+{
+	sb_annotations_queue_layout (self->_private->annotations);
+	display_queue_tint (self);
+}
+
+static void
+buffer_insert_text_cb (GtkTextBuffer* buffer,
+		       GtkTextIter  * location,
+		       gchar const  * text,
+		       gint           length,
+		       SbDisplay    * self)
+{
+	gchar const* end = text + length;
+	guint        n_lines = 0;
+	gint         line;
+
+	if (!self->_private->line_map) {
+		return;
+	}
+
+	// FIXME: also count "\r" and "\r\n" like GtkTextBuffer does
+	for (; (text = memchr (text, '\n', end - text)); text++) {
+		n_lines++;
+	}
+
+	if (!n_lines) {
+		return;
+	}
+
+	line = gtk_text_iter_get_line (location);
+	sb_line_map_insert (self->_private->line_map, line + 1, n_lines);
+	if (self->_private->next_line_map) {
+		sb_line_map_insert (self->_private->next_line_map, line + 1, n_lines);
+	}
+
+	/* the tinted lines moved down with the text */
+	if (line <= self->_private->tint_last) {
+		self->_private->tint_last += n_lines;
+		if (line < self->_private->tint_first) {
+			self->_private->tint_first += n_lines;
+		}
+	}
+
+	display_lines_moved (self);
+}
+
+static void
+buffer_delete_range_cb (GtkTextBuffer* buffer,
+			GtkTextIter  * start,
+			GtkTextIter  * end,
+			SbDisplay    * self)
+{
+	gint first = gtk_text_iter_get_line (start);
+	gint last  = gtk_text_iter_get_line (end);
+
+	if (!self->_private->line_map || first == last) {
+		return;
+	}
+
+	sb_line_map_delete (self->_private->line_map, first + 1, last - first);
+	if (self->_private->next_line_map) {
+		sb_line_map_delete (self->_private->next_line_map, first + 1, last - first);
+	}
+
+	/* the tinted lines moved up with the text; the deleted ones got
+	 * joined into @first */
+	if (self->_private->tint_last > first) {
+		self->_private->tint_last -= MIN (self->_private->tint_last, last) - first;
+		if (self->_private->tint_first > first) {
+			self->_private->tint_first -= MIN (self->_private->tint_first, last) - first;
+		}
+	}
+
+	display_lines_moved (self);
+}
+
+static void
+loader_progress_cb (SbHistoryLoader* loader,
+		    guint            n_lines,
+		    SbDisplay      * self)
+{
+	g_signal_emit (self,
+		       signals[LOAD_PROGRESS],
+		       0,
+		       n_lines);
+}
+
+static void
+revision_details_cb (gchar const* name,
+		     gchar const* object,
+		     gchar const* type,
+		     gchar const* contents,
+		     gsize        length,
+		     gpointer     user_data)
+{
+	SbDisplay      * self = SB_DISPLAY (user_data);
+	SbRevisionTable* revisions;
+	guint            id;
+
+	if (!type || strcmp (type, "commit") || !self->_private->repository) {
+		/* e.g. the "not committed yet" revision */
+		return;
+	}
+
+	revisions = sb_repository_get_revisions (self->_private->repository);
+	id = sb_revision_table_lookup (revisions, name);
+
+	if (id != SB_REVISION_NONE) {
+		sb_revision_load_commit (sb_revision_table_get_revision (revisions, id),
+					 contents, length);
+	}
+}
+
+/* fetches the messages of all new revisions in one batch */
+static void
+display_load_details (SbDisplay* self)
+{
+	SbCatFile      * cat_file;
+	SbRevisionTable* revisions;
+	guint const    * ids;
+	guint            n_ids;
+	guint            i;
+
+	if (!self->_private->repository) {
+		return;
+	}
+
+	cat_file  = sb_repository_get_cat_file (self->_private->repository);
+	revisions = sb_repository_get_revisions (self->_private->repository);
+	ids       = sb_history_loader_get_revision_ids (self->_private->loader, &n_ids);
+
+	/* don't ask twice for the revisions of an earlier load */
+	sb_cat_file_cancel (cat_file, self);
+
+	for (i = 0; i < n_ids; i++) {
+		SbRevision* revision = sb_revision_table_get_revision (revisions, ids[i]);
+
+		if (!sb_revision_has_details (revision)) {
+			sb_cat_file_request (cat_file,
+					     sb_revision_get_name (revision),
+					     revision_details_cb,
+					     self);
+		}
+	}
+}
+
+/* the running load blames the lines on screen first */
+static void
+display_update_viewport (SbDisplay* self)
+{
+	/* the lines of the text that gets blamed */
+	SbLineMap* map = self->_private->next_line_map ? self->_private->next_line_map : self->_private->line_map;
+	gint       first;
+	gint       last;
+
+	if (!self->_private->loader || sb_history_loader_is_done (self->_private->loader)) {
+		return;
+	}
+
+	display_get_visible_lines (self, &first, &last);
+
+	/* before the first layout, the view seems to show one line */
+	last = MAX (last, first + VIEWPORT_MIN_LINES);
+	first++;
+	last++;
+	if (map) {
+		first = sb_line_map_get_original (map, first);
+		last  = sb_line_map_get_original (map, last);
 	}
+
+	sb_history_loader_set_viewport (self->_private->loader,
+					MAX (first, 1),
+					MAX (last, 1));
 }
 
 static void
-job_done_cb (SbDisplay* self,
-	     GfcJob   * job)
+display_show_history (SbDisplay      * self,
+		      SbHistoryLoader* loader)
 {
-	gfc_reader_flush (self->_private->reader);
+	guint const* ids;
+	guint        n_ids;
+
+	sb_display_clear_highlight (self);
+	if (self->_private->next_line_map && loader == self->_private->loader) {
+		/* the annotations of the text that got blamed arrive */
+		sb_annotations_set_line_map (self->_private->annotations, self->_private->next_line_map);
+		sb_line_map_free (self->_private->line_map);
+		self->_private->line_map      = self->_private->next_line_map;
+		self->_private->next_line_map = NULL;
+	}
+	if (self->_private->history != loader) {
+		if (self->_private->history) {
+			g_object_unref (self->_private->history);
+		}
+		self->_private->history = g_object_ref (loader);
+	}
+	self->_private->lines = sb_history_loader_get_lines (loader);
+
+	ids = sb_history_loader_get_revision_ids (loader, &n_ids);
+	sb_color_map_update (self->_private->colors,
+			     sb_history_loader_get_revisions (loader),
+			     ids, n_ids);
 
 	sb_annotations_set_references (self->_private->annotations,
-				       self->_private->references);
-	self->_private->references = NULL;
+				       sb_history_loader_get_references (loader));
+	display_set_references (self, sb_history_loader_get_references (loader));
+	sb_minimap_set_references (self->_private->minimap,
+				   sb_history_loader_get_references (loader),
+				   sb_display_get_n_lines (self));
+
+	display_load_details (self);
+}
+
+/* the viewport is there, the rest of the file follows */
+static void
+loader_partial_cb (SbDisplay      * self,
+		   SbHistoryLoader* loader)
+{
+	display_show_history (self, loader);
+}
 
-	g_object_unref (self->_private->reader);
-	self->_private->reader = NULL;
-	g_object_unref (job);
+static void
+loader_done_cb (SbDisplay      * self,
+		SbHistoryLoader* loader)
+{
+	display_show_history (self, loader);
+	if (self->_private->repository && !self->_private->revision &&
+	    !sb_history_loader_is_incremental (loader) &&
+	    !sb_annotation_cache_contains (sb_history_loader_get_file_path (loader),
+					   sb_history_loader_get_flags (loader)))
+	{
+		/* a fresh blame, not one from the cache */
+		sb_repository_add_blame_time (self->_private->repository,
+					      sb_history_loader_get_file_path (loader),
+					      sb_history_loader_get_runtime (loader));
+	}
+	sb_annotation_cache_insert (loader);
+
+	g_object_unref (self->_private->loader);
+	self->_private->loader = NULL;
 
 	g_signal_emit (self,
 		       signals[LOAD_DONE],
 		       0);
+
+	if (sb_history_loader_get_flags (loader) != self->_private->blame_flags) {
+		display_start_refining (self, loader);
+	}
+
+	/* the foreground is idle now */
+	if (!self->_private->revision) {
+		sb_prefetcher_queue (self->_private->path, self->_private->blame_flags);
+		display_load_churn (self);
+	}
+
+	if (G_UNLIKELY (self->_private->reload_pending)) {
+		self->_private->reload_pending = FALSE;
+		settings_changed_cb (SB_SETTINGS_BLAME_KEYS, self);
+	}
+}
+
+static void
+display_stop_refining (SbDisplay* self)
+{
+	if (self->_private->refine_timeout) {
+		g_source_remove (self->_private->refine_timeout);
+		self->_private->refine_timeout = 0;
+	}
+
+	if (self->_private->refiner) {
+		g_signal_handlers_disconnect_by_func (self->_private->refiner, refiner_done_cb, self);
+		sb_history_loader_cancel (self->_private->refiner);
+		g_object_unref (self->_private->refiner);
+		self->_private->refiner = NULL;
+	}
+}
+
+/* the budget only counts while git runs: the refiner might wait for a
+ * slot or get suspended for the foreground */
+static gboolean
+refine_timeout_cb (gpointer data)
+{
+	SbDisplay* self = SB_DISPLAY (data);
+
+	if (sb_history_loader_get_elapsed (self->_private->refiner) < REFINE_BUDGET) {
+		return TRUE;
+	}
+
+	self->_private->refine_timeout = 0;
+	display_stop_refining (self);
+
+	return FALSE;
 }
 
-static inline void // FIXME: rename function
-load_history (SbDisplay  * self,
-	      gchar const* file_path)
+/* whether both blames attribute every line to the same revision and file */
+static gboolean
+display_same_attribution (GList const* a,
+			  GList const* b)
 {
-	gchar* working_folder;
-	gchar* basename;
-	GPtrArray* array;
-	GfcJob* job;
-	GPid pid = 0;
-	gint out_fd = 0;
+	for (; a && b; a = a->next, b = b->next) {
+		if (sb_reference_get_current_start (a->data) != sb_reference_get_current_start (b->data) ||
+		    sb_reference_get_current_end (a->data)   != sb_reference_get_current_end (b->data) ||
+		    sb_reference_get_revision (a->data)      != sb_reference_get_revision (b->data) ||
+		    g_strcmp0 (sb_reference_get_filename (a->data), sb_reference_get_filename (b->data)))
+		{
+			return FALSE;
+		}
+	}
 
-	g_return_if_fail (!self->_private->reader); // protect against multiple execution
+	return !a && !b;
+}
 
-	g_list_foreach (self->_private->references, (GFunc)g_object_unref, NULL);
-	g_list_free    (self->_private->references);
-	self->_private->references = NULL;
+static void
+refiner_done_cb (SbDisplay      * self,
+		 SbHistoryLoader* refiner)
+{
+	g_object_ref (refiner);
+	self->_private->refiner = NULL;
+	display_stop_refining (self);
+
+	sb_annotation_cache_insert (refiner);
+
+	/* the annotations keep the labels of the hunks that stayed; a
+	 * partial refinement doesn't replace a complete quick blame */
+	if (!sb_history_loader_has_failed (refiner) &&
+	    (!self->_private->history ||
+	     !display_same_attribution (sb_history_loader_get_references (self->_private->history),
+					sb_history_loader_get_references (refiner))))
+	{
+		display_show_history (self, refiner);
+	}
 
-	array = g_ptr_array_sized_new (1   /* command */
-				       + 1 /* --incremental */
-				       + 1 /* -M (?) */
-				       + 1 /* -C (?) */
-				       + 1 /* basename */
-				       + 1 /* ignore whitespaces */
-				       + 1 /* NULL */);
-	g_ptr_array_add (array, "git-blame");
-	g_ptr_array_add (array, "--incremental");
+	g_object_unref (refiner);
+}
 
-	if (sb_settings_get_follow_moves ()) {
-		g_ptr_array_add (array, "-M");
+/* runs the blame with copy and move detection in the background; the quick
+ * blame stays if it's cancelled */
+static void
+display_start_refining (SbDisplay      * self,
+			SbHistoryLoader* quick)
+{
+	GError     * error = NULL;
+	gchar const* contents;
+	gsize        length;
+
+	display_stop_refining (self);
+
+	self->_private->refiner = sb_history_loader_new (sb_history_loader_get_file_path (quick),
+							 self->_private->blame_flags);
+	sb_history_loader_set_revision (self->_private->refiner, sb_history_loader_get_revision (quick));
+	contents = sb_history_loader_get_contents (quick, &length);
+	if (contents) {
+		/* the same lines as the quick blame */
+		sb_history_loader_set_contents (self->_private->refiner, contents, length);
 	}
-	if (sb_settings_get_follow_copies ()) {
-		g_ptr_array_add (array, "-C");
+	sb_history_loader_set_background (self->_private->refiner, TRUE);
+
+	if (!sb_history_loader_start (self->_private->refiner, &error)) {
+		g_error_free (error);
+		g_object_unref (self->_private->refiner);
+		self->_private->refiner = NULL;
+		return;
 	}
-	if (sb_settings_get_ignore_whitespaces ()) {
-		g_ptr_array_add (array, "-w");
+
+	g_signal_connect_swapped (self->_private->refiner, "done",
+				  G_CALLBACK (refiner_done_cb), self);
+	self->_private->refine_timeout = g_timeout_add_seconds (1, refine_timeout_cb, self);
+}
+
+/* drawn into the left border of the text view, one bar per line; the
+ * more often a line changed, the redder */
+static gboolean
+churn_expose_event_cb (GtkWidget     * text_view,
+		       GdkEventExpose* event,
+		       SbDisplay     * self)
+{
+	GtkTextIter  iter;
+	guint const* counts;
+	guint        n_counts;
+	guint        max;
+	cairo_t    * cr;
+	gint         y;
+
+	if (event->window != gtk_text_view_get_window (self->_private->text_view, GTK_TEXT_WINDOW_LEFT) ||
+	    !self->_private->churn || !sb_churn_is_done (self->_private->churn))
+	{
+		return FALSE;
 	}
 
-	working_folder = g_path_get_dirname (file_path);
-	basename = g_path_get_basename (file_path);
-	g_ptr_array_add (array, basename);
-	g_ptr_array_add (array, NULL);
+	counts = sb_churn_get_counts (self->_private->churn, &n_counts);
+	max    = MAX (sb_churn_get_max (self->_private->churn), 1);
+
+	cr = gdk_cairo_create (event->window);
+	gdk_cairo_rectangle (cr, &event->area);
+	cairo_clip (cr);
+
+	gtk_text_view_window_to_buffer_coords (self->_private->text_view, GTK_TEXT_WINDOW_LEFT,
+					       0, event->area.y, NULL, &y);
+	gtk_text_view_get_line_at_y (self->_private->text_view, &iter, y, NULL);
+
+	do {
+		/* the counts are made for the blamed file */
+		guint   line     = gtk_text_iter_get_line (&iter) + 1;
+		guint   original = display_unmap_line (self, line);
+		gdouble heat;
+		gint    height;
+
+		gtk_text_view_get_line_yrange (self->_private->text_view, &iter, &y, &height);
+		gtk_text_view_buffer_to_window_coords (self->_private->text_view, GTK_TEXT_WINDOW_LEFT,
+						       0, y, NULL, &y);
+		if (y > event->area.y + event->area.height) {
+			break;
+		}
+
+		if (!original || original > n_counts || display_map_line (self, original) != line ||
+		    !counts[original - 1])
+		{
+			/* edited or never changed */
+			continue;
+		}
 
-	job = gfc_job_new_full (working_folder,
-				(gchar const**)array->pdata,
-				gfc_spawn_screen_new (gtk_widget_get_screen (GTK_WIDGET (self))));
-	self->_private->reader = g_object_ref (gfc_job_get_out_reader (job));
-	g_signal_connect_swapped (job, "done",
-				  G_CALLBACK (job_done_cb), self);
+		heat = (gdouble)counts[original - 1] / max;
+		cairo_set_source_rgb (cr, 1.0, 1.0 - 0.8 * heat, 0.6 - 0.6 * heat);
+		cairo_rectangle (cr, 0.0, y, CHURN_WIDTH, height);
+		cairo_fill (cr);
+	} while (gtk_text_iter_forward_line (&iter));
 
-	g_free (basename);
-	g_free (working_folder);
+	cairo_destroy (cr);
 
-	g_signal_connect (self->_private->reader, "read-line",
-			  G_CALLBACK (display_parse_line), self);
+	return FALSE;
 }
 
-void
-sb_display_load_path (SbDisplay  * self,
-		      gchar const* path,
-		      GError     **error)
+static void
+churn_done_cb (SbDisplay* self,
+	       SbChurn  * churn)
 {
-	GtkTextBuffer* buffer;
-	GMappedFile  * file;
+	sb_annotation_cache_insert_churn (churn);
 
-	file = g_mapped_file_new (path, FALSE, error);
-	buffer = gtk_text_view_get_buffer (self->_private->text_view);
+	if (GTK_WIDGET_REALIZED (self->_private->text_view)) {
+		gdk_window_invalidate_rect (gtk_text_view_get_window (self->_private->text_view, GTK_TEXT_WINDOW_LEFT),
+					    NULL, FALSE);
+	}
+}
 
-	gtk_text_buffer_set_text (buffer,
-				  g_mapped_file_get_contents (file),
-				  g_mapped_file_get_length (file));
+static void
+display_stop_churn (SbDisplay* self)
+{
+	if (!self->_private->churn) {
+		return;
+	}
 
-	g_signal_emit (self, signals[LOAD_STARTED], 0);
+	g_signal_handlers_disconnect_by_func (self->_private->churn, churn_done_cb, self);
+	if (!sb_churn_is_done (self->_private->churn)) {
+		sb_churn_cancel (self->_private->churn);
+	}
+	g_object_unref (self->_private->churn);
+	self->_private->churn = NULL;
+}
 
-	g_mapped_file_free (file);
+/* in the background, after the blame: one pass over the history of the file */
+static void
+display_load_churn (SbDisplay* self)
+{
+	GError * error = NULL;
+	SbChurn* cached;
 
-	load_history (self,
-		      path);
+	if (!sb_settings_get_show_churn () || !self->_private->path || self->_private->revision) {
+		display_stop_churn (self);
+		gtk_text_view_set_border_window_size (self->_private->text_view, GTK_TEXT_WINDOW_LEFT, 0);
+		return;
+	}
 
-	// FIXME: disable loading of new files until the history is loaded
-	// FIXME: make history loading cancellable
+	gtk_text_view_set_border_window_size (self->_private->text_view, GTK_TEXT_WINDOW_LEFT, CHURN_WIDTH);
+
+	if (self->_private->churn &&
+	    !strcmp (sb_churn_get_file_path (self->_private->churn), self->_private->path) &&
+	    sb_churn_is_current (self->_private->churn))
+	{
+		/* running or shown already */
+		return;
+	}
+
+	display_stop_churn (self);
+
+	cached = sb_annotation_cache_lookup_churn (self->_private->path);
+	if (cached) {
+		self->_private->churn = g_object_ref (cached);
+		churn_done_cb (self, cached);
+		return;
+	}
+
+	self->_private->churn = sb_churn_new (self->_private->path);
+	if (!sb_churn_start (self->_private->churn, &error)) {
+		g_warning ("couldn't count the changes of %s: %s", self->_private->path, error->message);
+		g_error_free (error);
+		g_object_unref (self->_private->churn);
+		self->_private->churn = NULL;
+		return;
+	}
+
+	g_signal_connect_swapped (self->_private->churn, "done",
+				  G_CALLBACK (churn_done_cb), self);
 }
 
+/* the text of the buffer, with the edits */
+static gchar*
+display_get_text (SbDisplay* self,
+		  gsize    * length)
+{
+	GtkTextBuffer* buffer = gtk_text_view_get_buffer (self->_private->text_view);
+	GtkTextIter    start;
+	GtkTextIter    end;
+	gchar        * result;
+
+	gtk_text_buffer_get_bounds (buffer, &start, &end);
+	result  = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+	*length = strlen (result);
+
+	return result;
+}
+
+/* whether the shown annotations belong to the text of @file_path on disk,
+ * with the current settings */
+static gboolean
+display_history_is_current (SbDisplay  * self,
+			    gchar const* file_path)
+{
+	SbHistoryLoader* history = self->_private->history;
+	guint            flags;
+
+	if (!history || !sb_history_loader_is_done (history) || sb_history_loader_has_failed (history) ||
+	    sb_history_loader_get_revision (history) || sb_history_loader_get_contents (history, NULL) ||
+	    strcmp (sb_history_loader_get_file_path (history), file_path))
+	{
+		return FALSE;
+	}
+
+	flags = sb_history_loader_get_flags (history);
+	return flags == self->_private->blame_flags || flags == (self->_private->blame_flags & ~REFINE_FLAGS);
+}
+
+/* @change: the lines of the text that got replaced since the shown
+ * annotations were loaded; only those get blamed then */
+static void // FIXME: rename function
+load_history (SbDisplay   * self,
+	      gchar const * file_path,
+	      SbHunk const* change)
+{
+	GtkTextBuffer  * buffer = gtk_text_view_get_buffer (self->_private->text_view);
+	GError         * error  = NULL;
+	SbHistoryLoader* cached = NULL;
+	SbHistoryLoader* base   = NULL;
+	/* the edits get blamed instead of the file */
+	gboolean         edited = !self->_private->revision && gtk_text_buffer_get_modified (buffer);
+
+	g_return_if_fail (!self->_private->loader); // protect against multiple execution
+
+	/* the foreground goes first */
+	sb_prefetcher_preempt ();
+	display_stop_refining (self);
+
+	/* no settings IPC here, that's a snapshot */
+	self->_private->blame_flags = sb_settings_get_flags ();
+	if (change && !edited && display_history_is_current (self, file_path)) {
+		base = self->_private->history;
+	} else if (!edited) {
+		cached = sb_annotation_cache_lookup_revision (file_path, self->_private->revision, self->_private->blame_flags);
+		if (!cached && (self->_private->blame_flags & REFINE_FLAGS)) {
+			cached = sb_annotation_cache_lookup_revision (file_path, self->_private->revision,
+								      self->_private->blame_flags & ~REFINE_FLAGS);
+		}
+	}
+	if (cached) {
+		self->_private->loader = g_object_ref (cached);
+	} else {
+		/* quick first, with copies and moves after that */
+		self->_private->loader = sb_history_loader_new (file_path,
+								base ? sb_history_loader_get_flags (base) :
+								self->_private->blame_flags & ~REFINE_FLAGS);
+		sb_history_loader_set_revision (self->_private->loader, self->_private->revision);
+		if (edited) {
+			gsize  length;
+			gchar* text = display_get_text (self, &length);
+
+			sb_history_loader_set_contents (self->_private->loader, text, length);
+			g_free (text);
+		} else {
+			/* the viewport must stay within the blamed text */
+			sb_history_loader_set_n_lines (self->_private->loader, self->_private->n_text_lines);
+		}
+		if (base) {
+			sb_history_loader_set_base (self->_private->loader, base, change);
+		}
+	}
+
+	if (self->_private->repository) {
+		g_signal_handlers_disconnect_by_func (self->_private->repository, display_queue_refresh, self);
+		sb_cat_file_cancel (sb_repository_get_cat_file (self->_private->repository), self);
+		g_object_unref (self->_private->repository);
+	}
+	self->_private->repository = sb_history_loader_get_repository (self->_private->loader);
+	g_free (self->_private->head);
+	self->_private->head = NULL;
+	if (G_LIKELY (self->_private->repository)) {
+		g_object_ref (self->_private->repository);
+		self->_private->head = g_strdup (sb_repository_get_head (self->_private->repository));
+		/* commits, checkouts and resets */
+		g_signal_connect_swapped (self->_private->repository, "changed",
+					  G_CALLBACK (display_queue_refresh), self);
+	}
+
+	/* the shown annotations keep following the edits until the new ones
+	 * arrive, and those are made from the text as it is now */
+	self->_private->next_line_map = sb_line_map_new (gtk_text_buffer_get_line_count (buffer));
+
+	if (cached) {
+		loader_done_cb (self, self->_private->loader);
+		return;
+	}
+
+	display_update_viewport (self);
+
+	if (!sb_history_loader_start (self->_private->loader, &error)) {
+		// FIXME: report the error to the user
+		g_warning ("couldn't start git blame: %s", error->message);
+		g_error_free (error);
+
+		g_object_unref (self->_private->loader);
+		self->_private->loader = NULL;
+		sb_line_map_free (self->_private->next_line_map);
+		self->_private->next_line_map = NULL;
+
+		g_signal_emit (self, signals[LOAD_DONE], 0);
+		return;
+	}
+
+	g_signal_connect (self->_private->loader, "progress",
+			  G_CALLBACK (loader_progress_cb), self);
+	g_signal_connect_swapped (self->_private->loader, "partial",
+				  G_CALLBACK (loader_partial_cb), self);
+	g_signal_connect_swapped (self->_private->loader, "done",
+				  G_CALLBACK (loader_done_cb), self);
+
+	if (base) {
+		/* the lines that stayed keep their annotations right away */
+		display_show_history (self, self->_private->loader);
+	}
+}
+
+/* what a fresh load gets made from */
+static void
+display_remember_text (SbDisplay  * self,
+		       gchar const* contents,
+		       gsize        length)
+{
+	g_free (self->_private->checksum);
+	self->_private->checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1,
+								(guchar const*)contents,
+								length);
+	self->_private->n_text_lines = sb_history_loader_count_lines (contents, length);
+}
+
+/* replaces only the lines that differ from @contents, so the others keep
+ * their annotations; @change gets the replaced lines, like a hunk of
+ * "git diff" */
+static void
+display_update_text (SbDisplay  * self,
+		     gchar const* contents,
+		     gsize        length,
+		     SbHunk     * change)
+{
+	GtkTextBuffer* buffer = gtk_text_view_get_buffer (self->_private->text_view);
+	GtkTextIter    start;
+	GtkTextIter    end;
+	gchar        * text;
+	gsize          text_length;
+	gsize          prefix = 0;  /* the common lines at the start, in bytes */
+	guint          n_prefix_lines = 0;
+	gsize          suffix = 0;  /* ... and at the end */
+	gsize          i;
+
+	gtk_text_buffer_get_bounds (buffer, &start, &end);
+	text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+	text_length = strlen (text);
+
+	// FIXME: also split at "\r" like GtkTextBuffer does
+	for (i = 0; i < text_length && i < length && text[i] == contents[i]; i++) {
+		if (text[i] == '\n') {
+			prefix = i + 1;
+			n_prefix_lines++;
+		}
+	}
+
+	for (i = 1; i <= text_length - prefix && i <= length - prefix &&
+		    text[text_length - i] == contents[length - i]; i++)
+	{
+		gsize old_end = text_length - i;
+		gsize new_end = length - i;
+
+		/* a line starts there in both texts */
+		if ((!old_end || text[old_end - 1] == '\n') &&
+		    (!new_end || contents[new_end - 1] == '\n'))
+		{
+			suffix = i;
+		}
+	}
+
+	change->old_count = sb_history_loader_count_lines (text + prefix, text_length - prefix - suffix);
+	change->new_count = sb_history_loader_count_lines (contents + prefix, length - prefix - suffix);
+	/* an empty side names the line before it */
+	change->old_start = n_prefix_lines + (change->old_count ? 1 : 0);
+	change->new_start = n_prefix_lines + (change->new_count ? 1 : 0);
+
+	display_get_line_iter (buffer, &start, n_prefix_lines);
+	if (suffix) {
+		/* the replaced lines end with a newline */
+		display_get_line_iter (buffer, &end, n_prefix_lines + change->old_count);
+	}
+	gtk_text_buffer_delete (buffer, &start, &end);
+	gtk_text_buffer_insert (buffer, &start, contents + prefix, length - prefix - suffix);
+	gtk_text_buffer_set_modified (buffer, FALSE);
+
+	display_remember_text (self, contents, length);
+
+	g_free (text);
+}
+
+/* reload only what changed: the changed lines of the text, or only the
+ * annotations when the text stayed the same but its history moved */
+static gboolean
+display_refresh (gpointer data)
+{
+	SbDisplay* self = SB_DISPLAY (data);
+	gchar    * contents;
+	gsize      length;
+	gchar    * checksum;
+	gboolean   changed;
+	gboolean   edited;
+	gboolean   moved;
+	SbHunk     change;
+
+	self->_private->refresh_timeout = 0;
+
+	if (self->_private->revision) {
+		/* the past doesn't change */
+		return FALSE;
+	}
+
+	if (self->_private->loader) {
+		/* try again after the load */
+		display_queue_refresh (self);
+		return FALSE;
+	}
+
+	if (!self->_private->path ||
+	    !g_file_get_contents (self->_private->path, &contents, &length, NULL))
+	{
+		/* maybe the file is gone just for a moment; it's watched still */
+		return FALSE;
+	}
+
+	checksum = g_compute_checksum_for_data (G_CHECKSUM_SHA1, (guchar const*)contents, length);
+	changed  = g_strcmp0 (checksum, self->_private->checksum) != 0;
+	edited   = gtk_text_buffer_get_modified (gtk_text_view_get_buffer (self->_private->text_view));
+	moved    = self->_private->repository &&
+		   g_strcmp0 (sb_repository_get_head (self->_private->repository), self->_private->head);
+
+	if (changed && edited) {
+		// FIXME: offer to take the new text instead of the edits
+		/* the edits and their annotations stay; tell only once */
+		g_free (self->_private->checksum);
+		self->_private->checksum = checksum;
+		checksum = NULL;
+		g_signal_emit (self, signals[FILE_CHANGED], 0);
+	} else if (changed) {
+		display_update_text (self, contents, length, &change);
+	}
+
+	g_free (checksum);
+	g_free (contents);
+
+	if (moved) {
+		/* commits, checkouts and resets; the text (and the edits) stay */
+		g_signal_emit (self, signals[LOAD_STARTED], 0);
+		load_history (self, self->_private->path, NULL);
+	} else if (changed && !edited) {
+		g_signal_emit (self, signals[LOAD_STARTED], 0);
+		load_history (self, self->_private->path, &change);
+	}
+
+	return FALSE;
+}
+
+static void
+display_queue_refresh (SbDisplay* self)
+{
+	if (self->_private->refresh_timeout) {
+		g_source_remove (self->_private->refresh_timeout);
+	}
+
+	/* wait until the changes settle */
+	self->_private->refresh_timeout = g_timeout_add (REFRESH_DELAY, display_refresh, self);
+}
+
+static void
+file_changed_cb (GFileMonitor     * monitor,
+		 GFile            * file,
+		 GFile            * other,
+		 GFileMonitorEvent  event,
+		 SbDisplay        * self)
+{
+	switch (event) {
+	case G_FILE_MONITOR_EVENT_CHANGED:
+	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+	case G_FILE_MONITOR_EVENT_CREATED:
+		display_queue_refresh (self);
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+display_watch (SbDisplay* self)
+{
+	GFile* file;
+
+	if (self->_private->monitor) {
+		g_file_monitor_cancel (self->_private->monitor);
+		g_object_unref (self->_private->monitor);
+	}
+
+	file = g_file_new_for_path (self->_private->path);
+	self->_private->monitor = g_file_monitor_file (file, G_FILE_MONITOR_NONE, NULL, NULL);
+	if (self->_private->monitor) {
+		g_signal_connect (self->_private->monitor, "changed",
+				  G_CALLBACK (file_changed_cb), self);
+	}
+	g_object_unref (file);
+}
+
+static void
+display_set_text (SbDisplay  * self,
+		  gchar const* contents,
+		  gsize        length)
+{
+	GtkTextBuffer* buffer = gtk_text_view_get_buffer (self->_private->text_view);
+
+	/* replacing the text isn't an edit */
+	sb_annotations_set_line_map (self->_private->annotations, NULL);
+	if (self->_private->line_map) {
+		sb_line_map_free (self->_private->line_map);
+		self->_private->line_map = NULL;
+	}
+
+	gtk_text_buffer_set_text (buffer, contents, length);
+	gtk_text_buffer_set_modified (buffer, FALSE);
+	/* the past can't be edited */
+	gtk_text_view_set_editable (self->_private->text_view, !self->_private->revision);
+
+	display_remember_text (self, contents, length);
+
+	self->_private->line_map = sb_line_map_new (gtk_text_buffer_get_line_count (buffer));
+	sb_annotations_set_line_map (self->_private->annotations, self->_private->line_map);
+
+	/* the tags went away with the old text */
+	self->_private->tint_first = 0;
+	self->_private->tint_last  = -1;
+	display_set_references (self, NULL);
+}
+
+/* selects @n_lines from @line (from 1) and scrolls them into view */
+static void
+display_scroll_to_line (SbDisplay* self,
+			guint      line,
+			guint      n_lines)
+{
+	GtkTextBuffer* buffer = gtk_text_view_get_buffer (self->_private->text_view);
+	GtkTextIter    start;
+	GtkTextIter    end;
+
+	display_get_line_iter (buffer, &start, MAX (line, 1) - 1);
+	display_get_line_iter (buffer, &end, MAX (line, 1) - 1 + n_lines);
+	gtk_text_buffer_select_range (buffer, &start, &end);
+
+	/* a mark, because the new text has no layout yet */
+	gtk_text_view_scroll_to_mark (self->_private->text_view, gtk_text_buffer_get_insert (buffer),
+				      0.0, TRUE, 0.0, 0.3);
+}
+
+/* the first line on screen, from 1 */
+static guint
+display_get_top_line (SbDisplay* self)
+{
+	GdkRectangle visible;
+	GtkTextIter  iter;
+
+	gtk_text_view_get_visible_rect (self->_private->text_view, &visible);
+	gtk_text_view_get_line_at_y (self->_private->text_view, &iter, visible.y, NULL);
+
+	return gtk_text_iter_get_line (&iter) + 1;
+}
+
+static void
+display_cancel_blob (SbDisplay* self)
+{
+	g_free (self->_private->blob);
+	self->_private->blob = NULL;
+	g_free (self->_private->blob_path);
+	self->_private->blob_path = NULL;
+	g_free (self->_private->blob_revision);
+	self->_private->blob_revision = NULL;
+}
+
+/* @edits: the text to show instead of the file, as if it was edited */
+static void
+display_load_path (SbDisplay  * self,
+		   gchar const* path,
+		   gchar const* edits,
+		   gsize        edits_length,
+		   GError     **error)
+{
+	GMappedFile* file;
+	gboolean     was_revision = self->_private->revision != NULL;
+
+	file = g_mapped_file_new (path, FALSE, error);
+	if (!file) {
+		/* the caller reports the error; the old text stays */
+		return;
+	}
+
+	display_cancel_blob (self);
+	display_stop_mapping (self);
+	display_stop_loading (self);
+	g_free (self->_private->revision);
+	self->_private->revision = NULL;
+
+	if (edits) {
+		/* the checksum stays the one of the file; the edits get blamed */
+		display_set_text (self, edits, edits_length);
+		display_remember_text (self,
+				       g_mapped_file_get_contents (file),
+				       g_mapped_file_get_length (file));
+		gtk_text_buffer_set_modified (gtk_text_view_get_buffer (self->_private->text_view), TRUE);
+	} else {
+		display_set_text (self,
+				  g_mapped_file_get_contents (file),
+				  g_mapped_file_get_length (file));
+	}
+
+	g_signal_emit (self, signals[LOAD_STARTED], 0);
+
+	g_mapped_file_free (file);
+
+	if (self->_private->path != path || was_revision) {
+		if (self->_private->path != path) {
+			g_free (self->_private->path);
+			self->_private->path = g_strdup (path);
+		}
+		display_watch (self);
+	}
+
+	load_history (self,
+		      path,
+		      NULL);
+
+	// FIXME: disable loading of new files until the history is loaded
+	// FIXME: make history loading cancellable
+}
+
+void
+sb_display_load_path (SbDisplay  * self,
+		      gchar const* path,
+		      GError     **error)
+{
+	display_load_path (self, path, NULL, 0, error);
+}
+
+/* the blame of what was shown before */
+static void
+display_stop_loading (SbDisplay* self)
+{
+	if (self->_private->next_line_map) {
+		sb_line_map_free (self->_private->next_line_map);
+		self->_private->next_line_map = NULL;
+	}
+
+	if (!self->_private->loader) {
+		return;
+	}
+
+	g_signal_handlers_disconnect_matched (self->_private->loader, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	sb_history_loader_cancel (self->_private->loader);
+	g_object_unref (self->_private->loader);
+	self->_private->loader = NULL;
+}
+
+static void
+blob_free (Blob* blob)
+{
+	g_free (blob->name);
+	g_string_free (blob->contents, TRUE);
+	g_slice_free (Blob, blob);
+}
+
+/* the most recently used blob gets to the head */
+static GString*
+display_lookup_blob (SbDisplay  * self,
+		     gchar const* name)
+{
+	GList* link = g_hash_table_lookup (self->_private->blob_links, name);
+
+	if (!link) {
+		return NULL;
+	}
+
+	g_queue_unlink         (self->_private->blobs, link);
+	g_queue_push_head_link (self->_private->blobs, link);
+
+	return ((Blob*)link->data)->contents;
+}
+
+static void
+display_cache_blob (SbDisplay  * self,
+		    gchar const* name,
+		    gchar const* contents,
+		    gsize        length)
+{
+	Blob* blob;
+
+	if (display_lookup_blob (self, name)) {
+		return;
+	}
+
+	blob = g_slice_new (Blob);
+	blob->name     = g_strdup (name);
+	blob->contents = g_string_new_len (contents, length);
+	g_queue_push_head (self->_private->blobs, blob);
+	g_hash_table_insert (self->_private->blob_links, blob->name, self->_private->blobs->head);
+
+	if (self->_private->blobs->length > MAX_BLOBS) {
+		blob = g_queue_pop_tail (self->_private->blobs);
+		g_hash_table_remove (self->_private->blob_links, blob->name);
+		blob_free (blob);
+	}
+}
+
+static void
+display_blob_cb (gchar const* name,
+		 gchar const* object,
+		 gchar const* type,
+		 gchar const* contents,
+		 gsize        length,
+		 gpointer     user_data)
+{
+	SbDisplay* self = SB_DISPLAY (user_data);
+
+	if (!g_strcmp0 (type, "blob")) {
+		display_cache_blob (self, name, contents, length);
+	}
+
+	if (g_strcmp0 (name, self->_private->blob)) {
+		/* asked for something else since, or prefetched */
+		return;
+	}
+
+	if (g_strcmp0 (type, "blob")) {
+		// FIXME: report the error to the user
+		g_warning ("couldn't read %s", name);
+		display_cancel_blob (self);
+		return;
+	}
+
+	display_show_blob (self, contents, length);
+}
+
+static void
+display_show_blob (SbDisplay  * self,
+		   gchar const* contents,
+		   gsize        length)
+{
+	/* a slider keeps the position */
+	guint line = self->_private->blob_line ? self->_private->blob_line : display_get_top_line (self);
+
+	g_free (self->_private->path);
+	self->_private->path = self->_private->blob_path;
+	self->_private->blob_path = NULL;
+	g_free (self->_private->revision);
+	self->_private->revision = self->_private->blob_revision;
+	self->_private->blob_revision = NULL;
+	g_free (self->_private->blob);
+	self->_private->blob = NULL;
+
+	/* only the working copy changes */
+	if (self->_private->monitor) {
+		g_file_monitor_cancel (self->_private->monitor);
+		g_object_unref (self->_private->monitor);
+		self->_private->monitor = NULL;
+	}
+
+	display_stop_loading (self);
+
+	display_set_text (self, contents, length);
+	display_scroll_to_line (self, line, self->_private->blob_n_lines);
+
+	g_signal_emit (self, signals[LOAD_STARTED], 0);
+	load_history (self, self->_private->path, NULL);
+}
+
+/* the blob comes from the cat-file process and the blame from the cache
+ * if it was there before, so going back and forth is quick */
+static void
+display_load_revision (SbDisplay  * self,
+		       gchar const* path,
+		       gchar const* revision,
+		       guint        line,
+		       guint        n_lines)
+{
+	GString* blob;
+
+	if (!self->_private->repository) {
+		return;
+	}
+
+	display_cancel_blob (self);
+	display_stop_mapping (self);
+	self->_private->blob          = g_strdup_printf ("%s:%s", revision,
+							 sb_repository_get_relative_path (self->_private->repository, path));
+	self->_private->blob_path     = g_strdup (path);
+	self->_private->blob_revision = g_strdup (revision);
+	self->_private->blob_line     = line;
+	self->_private->blob_n_lines  = n_lines;
+
+	blob = display_lookup_blob (self, self->_private->blob);
+	if (blob) {
+		display_show_blob (self, blob->str, blob->len);
+		return;
+	}
+
+	sb_cat_file_request (sb_repository_get_cat_file (self->_private->repository),
+			     self->_private->blob,
+			     display_blob_cb,
+			     self);
+}
+
+/* shows @path as it was in @revision, with its blame; @line (from 1)
+ * gets scrolled to */
+void
+sb_display_load_revision (SbDisplay  * self,
+			  gchar const* path,
+			  gchar const* revision,
+			  guint        line)
+{
+	g_return_if_fail (SB_IS_DISPLAY (self));
+	g_return_if_fail (path && g_path_is_absolute (path));
+	g_return_if_fail (revision);
+
+	display_load_revision (self, path, revision, line, 0);
+}
+
+/* NULL for the working copy */
+gchar const*
+sb_display_get_revision (SbDisplay const* self)
+{
+	g_return_val_if_fail (SB_IS_DISPLAY (self), NULL);
+
+	return self->_private->revision;
+}
+
+/* whether the working copy is shown with changes that aren't on disk */
+gboolean
+sb_display_has_edits (SbDisplay const* self)
+{
+	g_return_val_if_fail (SB_IS_DISPLAY (self), FALSE);
+
+	return !self->_private->revision &&
+	       gtk_text_buffer_get_modified (gtk_text_view_get_buffer (self->_private->text_view));
+}
+
+static void
+display_stop_prefetch (SbDisplay      * self,
+		       SbHistoryLoader* loader)
+{
+	self->_private->prefetching = g_list_remove (self->_private->prefetching, loader);
+	g_signal_handlers_disconnect_matched (loader, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	sb_history_loader_cancel (loader);
+	g_object_unref (loader);
+}
+
+static void
+prefetch_done_cb (SbDisplay      * self,
+		  SbHistoryLoader* loader)
+{
+	sb_annotation_cache_insert (loader);
+	display_stop_prefetch (self, loader);
+}
+
+/* gets the text and the (quick) blame of @path in @revision ready in the
+ * background, for sb_display_load_revision() to show them right away */
+void
+sb_display_prefetch_revision (SbDisplay  * self,
+			      gchar const* path,
+			      gchar const* revision)
+{
+	guint            flags;
+	gchar          * name;
+	GList          * iter;
+	SbHistoryLoader* loader;
+
+	g_return_if_fail (SB_IS_DISPLAY (self));
+	g_return_if_fail (path && g_path_is_absolute (path));
+	g_return_if_fail (revision);
+
+	if (!self->_private->repository) {
+		return;
+	}
+
+	name = g_strdup_printf ("%s:%s", revision,
+				sb_repository_get_relative_path (self->_private->repository, path));
+	if (!display_lookup_blob (self, name)) {
+		sb_cat_file_request (sb_repository_get_cat_file (self->_private->repository),
+				     name,
+				     display_blob_cb,
+				     self);
+	}
+	g_free (name);
+
+	flags = sb_settings_get_flags () & ~REFINE_FLAGS;
+	if (sb_annotation_cache_lookup_revision (path, revision, flags)) {
+		return;
+	}
+	for (iter = self->_private->prefetching; iter; iter = iter->next) {
+		if (!g_strcmp0 (sb_history_loader_get_revision (iter->data), revision) &&
+		    !strcmp (sb_history_loader_get_file_path (iter->data), path))
+		{
+			return;
+		}
+	}
+
+	loader = sb_history_loader_new (path, flags);
+	sb_history_loader_set_revision (loader, revision);
+	sb_history_loader_set_background (loader, TRUE);
+	if (!sb_history_loader_start (loader, NULL)) {
+		g_object_unref (loader);
+		return;
+	}
+
+	g_signal_connect_swapped (loader, "done",
+				  G_CALLBACK (prefetch_done_cb), self);
+	self->_private->prefetching = g_list_prepend (self->_private->prefetching, loader);
+
+	/* the ones of the revisions passed by long ago go first */
+	if (g_list_length (self->_private->prefetching) > MAX_PREFETCH) {
+		display_stop_prefetch (self, g_list_last (self->_private->prefetching)->data);
+	}
+}
+
+static void
+display_stop_mapping (SbDisplay* self)
+{
+	g_array_set_size (self->_private->mapping_hunks, 0);
+
+	if (!self->_private->mapping) {
+		return;
+	}
+
+	g_signal_handlers_disconnect_matched (sb_job_get_reader (self->_private->mapping), G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	g_signal_handlers_disconnect_matched (self->_private->mapping, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	if (!sb_job_is_done (self->_private->mapping)) {
+		sb_job_cancel (self->_private->mapping);
+	}
+	g_object_unref (self->_private->mapping);
+	self->_private->mapping = NULL;
+}
+
+static void
+mapping_read_lines_cb (SbAsyncReader    * reader,
+		       SbLineBatch const* batch,
+		       SbDisplay        * self)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_lines; i++) {
+		SbHunk hunk;
+
+		/* the content lines start with ' ', '+', '-' or '\\' */
+		if (sb_hunk_parse (batch->lines[i], &hunk)) {
+			g_array_append_val (self->_private->mapping_hunks, hunk);
+		}
+	}
+}
+
+static void
+mapping_done_cb (SbDisplay* self,
+		 SbJob    * job)
+{
+	SbHunk const* hunks   = (SbHunk const*)self->_private->mapping_hunks->data;
+	guint         n_hunks = self->_private->mapping_hunks->len;
+	guint         start;
+	guint         end;
+
+	if (sb_job_get_exit_status (job)) {
+		/* the lines stay where the revision put them */
+		display_stop_mapping (self);
+		return;
+	}
+
+	start = sb_hunk_map_to_old (hunks, n_hunks, self->_private->mapping_start);
+	end   = MAX (sb_hunk_map_to_old (hunks, n_hunks, self->_private->mapping_end), start);
+	display_stop_mapping (self);
+
+	if (self->_private->blob) {
+		/* cat-file didn't deliver yet */
+		self->_private->blob_line    = start;
+		self->_private->blob_n_lines = end - start + 1;
+	} else {
+		display_scroll_to_line (self, start, end - start + 1);
+	}
+}
+
+/* diffs the parent against the revision of @reference, to find the lines
+ * from @start to @end (in that revision) in the parent */
+static void
+display_start_mapping (SbDisplay  * self,
+		       SbReference* reference,
+		       guint        start,
+		       guint        end)
+{
+	gchar* before;
+	gchar* after;
+
+	before = g_strdup_printf ("%s:%s",
+				  sb_revision_get_name (sb_reference_get_previous (reference)),
+				  sb_reference_get_previous_filename (reference));
+	after  = g_strdup_printf ("%s:%s",
+				  sb_revision_get_name (sb_reference_get_revision (reference)),
+				  sb_reference_get_filename (reference));
+
+	self->_private->mapping_start = start;
+	self->_private->mapping_end   = end;
+	self->_private->mapping = sb_git_job_new (sb_repository_get_toplevel (self->_private->repository), 0,
+						  "diff", "-U0", "--no-color", "--no-ext-diff",
+						  before, after,
+						  NULL);
+	sb_job_set_priority (self->_private->mapping, SB_JOB_PRIORITY_VISIBLE);
+	g_free (before);
+	g_free (after);
+
+	if (!sb_job_start (self->_private->mapping, NULL)) {
+		g_object_unref (self->_private->mapping);
+		self->_private->mapping = NULL;
+		return;
+	}
+
+	g_signal_connect (sb_job_get_reader (self->_private->mapping), "read-lines",
+			  G_CALLBACK (mapping_read_lines_cb), self);
+	g_signal_connect_swapped (self->_private->mapping, "done",
+				  G_CALLBACK (mapping_done_cb), self);
+}
+
+/* blames the lines of @reference before its revision changed them */
+static void
+display_drill_down (SbDisplay  * self,
+		    SbReference* reference)
+{
+	SbRevision* previous = sb_reference_get_previous (reference);
+	Location  * location;
+	gchar     * path;
+	guint       start;
+	guint       end;
+
+	if (!previous || !self->_private->repository || !self->_private->path) {
+		/* added by the revision, or the first one */
+		return;
+	}
+
+	location = g_slice_new (Location);
+	location->path     = g_strdup (self->_private->path);
+	location->revision = g_strdup (self->_private->revision);
+	location->line     = display_get_top_line (self);
+	location->edits    = NULL;
+	location->edits_length = 0;
+	if (!self->_private->revision &&
+	    gtk_text_buffer_get_modified (gtk_text_view_get_buffer (self->_private->text_view)))
+	{
+		/* going back brings them back */
+		location->edits = display_get_text (self, &location->edits_length);
+	}
+	g_queue_push_head (self->_private->back, location);
+
+	/* where the revision put the lines, until the diff tells where they
+	 * were before */
+	start = sb_reference_get_original_start (reference);
+	end   = start + sb_reference_get_current_end (reference) - sb_reference_get_current_start (reference);
+
+	path = g_build_filename (sb_repository_get_toplevel (self->_private->repository),
+				 sb_reference_get_previous_filename (reference),
+				 NULL);
+	display_load_revision (self, path, sb_revision_get_name (previous),
+			       start, end - start + 1);
+	g_free (path);
+
+	display_start_mapping (self, reference, start, end);
+}
+
+gboolean
+sb_display_can_go_back (SbDisplay const* self)
+{
+	g_return_val_if_fail (SB_IS_DISPLAY (self), FALSE);
+
+	return !g_queue_is_empty (self->_private->back);
+}
+
+/* to where the last drill down started */
+void
+sb_display_go_back (SbDisplay* self)
+{
+	Location* location;
+
+	g_return_if_fail (SB_IS_DISPLAY (self));
+
+	location = g_queue_pop_head (self->_private->back);
+	if (!location) {
+		return;
+	}
+
+	if (location->revision) {
+		display_load_revision (self, location->path, location->revision, location->line, 0);
+	} else {
+		display_load_path (self, location->path,
+				   location->edits, location->edits_length, NULL);
+		display_scroll_to_line (self, location->line, 0);
+	}
+
+	location_free (location);
+}
+
+static void
+display_show_lines (SbDisplay        * self,
+		    SbLineRange const* ranges,
+		    guint              n_ranges,
+		    gboolean           filter)
+{
+	GtkTextBuffer* buffer = gtk_text_view_get_buffer (self->_private->text_view);
+	GtkTextIter    start;
+	GtkTextIter    end;
+	guint          i;
+
+	gtk_text_buffer_get_bounds (buffer, &start, &end);
+	gtk_text_buffer_remove_tag (buffer, self->_private->highlight_tag, &start, &end);
+	if (self->_private->filtered) {
+		gtk_text_buffer_remove_tag (buffer, self->_private->dimmed_tag, &start, &end);
+	}
+	if (filter) {
+		gtk_text_buffer_apply_tag (buffer, self->_private->dimmed_tag, &start, &end);
+	}
+	self->_private->filtered = filter;
+
+	for (i = 0; i < n_ranges; i++) {
+		/* the ranges count from 1, the buffer from 0; the end is the
+		 * beginning of the next line */
+		display_get_line_iter (buffer, &start, display_map_line (self, ranges[i].start) - 1);
+		display_get_line_iter (buffer, &end, display_map_line (self, ranges[i].end));
+
+		if (filter) {
+			gtk_text_buffer_remove_tag (buffer, self->_private->dimmed_tag, &start, &end);
+		} else {
+			gtk_text_buffer_apply_tag (buffer, self->_private->highlight_tag, &start, &end);
+		}
+	}
+}
+
+/* the blame times of the shown file before and after its repository got a
+ * commit-graph; FALSE unless both are known */
+gboolean
+sb_display_get_blame_times (SbDisplay* self,
+			    gdouble  * before,
+			    gdouble  * after)
+{
+	g_return_val_if_fail (SB_IS_DISPLAY (self), FALSE);
+
+	if (!self->_private->repository || !self->_private->history) {
+		return FALSE;
+	}
+
+	return sb_repository_get_blame_times (self->_private->repository,
+					      sb_history_loader_get_file_path (self->_private->history),
+					      before, after);
+}
+
+void
+sb_display_highlight_revision (SbDisplay * self,
+			       SbRevision* revision,
+			       gboolean    filter)
+{
+	SbLineRange const* ranges;
+	guint              n_ranges;
+
+	g_return_if_fail (SB_IS_DISPLAY (self));
+	g_return_if_fail (SB_IS_REVISION (revision));
+
+	if (!self->_private->lines) {
+		return;
+	}
+
+	self->_private->highlight_revision = sb_revision_get_id (revision);
+	self->_private->highlight_author   = SB_REVISION_NONE;
+
+	ranges = sb_line_index_get_revision_lines (self->_private->lines,
+						   self->_private->highlight_revision,
+						   &n_ranges);
+	display_show_lines (self, ranges, n_ranges, filter);
+}
+
+void
+sb_display_highlight_author (SbDisplay  * self,
+			     gchar const* author,
+			     gboolean     filter)
+{
+	SbLineRange const* ranges;
+	guint              n_ranges;
+
+	g_return_if_fail (SB_IS_DISPLAY (self));
+	g_return_if_fail (author);
+
+	if (!self->_private->lines || !self->_private->repository) {
+		return;
+	}
+
+	self->_private->highlight_revision = SB_REVISION_NONE;
+	self->_private->highlight_author   = sb_revision_table_lookup_author (sb_repository_get_revisions (self->_private->repository),
+									      author);
+
+	ranges = sb_line_index_get_author_lines (self->_private->lines,
+						 self->_private->highlight_author,
+						 &n_ranges);
+	display_show_lines (self, ranges, n_ranges, filter);
+}
+
+void
+sb_display_clear_highlight (SbDisplay* self)
+{
+	g_return_if_fail (SB_IS_DISPLAY (self));
+
+	self->_private->highlight_revision = SB_REVISION_NONE;
+	self->_private->highlight_author   = SB_REVISION_NONE;
+
+	display_show_lines (self, NULL, 0, FALSE);
+}
+
+/* click: the lines of the revision; shift-click: the lines of its author;
+ * with control: dim all other lines; the same click again clears;
+ * alt-click: the blame from before the revision */
+static void
+reference_clicked_cb (SbAnnotations* annotations,
+		      SbReference  * reference,
+		      guint          modifiers,
+		      SbDisplay    * self)
+{
+	SbRevision* revision = sb_reference_get_revision (reference);
+	gboolean    filter   = (modifiers & GDK_CONTROL_MASK) != 0;
+
+	if (modifiers & GDK_MOD1_MASK) {
+		display_drill_down (self, reference);
+	} else if (modifiers & GDK_SHIFT_MASK) {
+		SbRevisionTable* table = sb_revision_get_table (revision);
+		guint            author;
+
+		if (!table) {
+			return;
+		}
+
+		author = sb_revision_table_get_author (table, sb_revision_get_id (revision));
+		if (author == self->_private->highlight_author && filter == self->_private->filtered) {
+			sb_display_clear_highlight (self);
+		} else if (sb_revision_get_author (revision)) {
+			sb_display_highlight_author (self, sb_revision_get_author (revision), filter);
+		}
+	} else if (sb_revision_get_id (revision) == self->_private->highlight_revision &&
+		   filter == self->_private->filtered)
+	{
+		sb_display_clear_highlight (self);
+	} else {
+		sb_display_highlight_revision (self, revision, filter);
+	}
+}
@@ -25,6 +25,7 @@
 #define SB_DISPLAY_H
 
 #include <gtk/gtk.h>
+#include "sb-revision.h"
 
 G_BEGIN_DECLS
 
@@ -39,12 +40,33 @@ typedef struct _SbDisplayClass   SbDisplayClass;
 #define SB_IS_DISPLAY_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_DISPLAY))
 #define SB_DISPLAY_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_DISPLAY, SbDisplayClass))
 
-GType      sb_display_get_type    (void);
-GtkWidget* sb_display_new         (void);
-gint       sb_display_get_n_lines (SbDisplay const* self);
-void       sb_display_load_path   (SbDisplay      * self,
-				   gchar const    * path,
-				   GError         **error);
+GType      sb_display_get_type           (void);
+GtkWidget* sb_display_new                (void);
+gint       sb_display_get_n_lines        (SbDisplay const* self);
+void       sb_display_load_path          (SbDisplay      * self,
+					  gchar const    * path,
+					  GError         **error);
+void       sb_display_load_revision      (SbDisplay      * self,
+					  gchar const    * path,
+					  gchar const    * revision,
+					  guint            line);
+void       sb_display_prefetch_revision  (SbDisplay      * self,
+					  gchar const    * path,
+					  gchar const    * revision);
+gchar const* sb_display_get_revision     (SbDisplay const* self);
+gboolean   sb_display_has_edits          (SbDisplay const* self);
+gboolean   sb_display_can_go_back        (SbDisplay const* self);
+void       sb_display_go_back            (SbDisplay      * self);
+gboolean   sb_display_get_blame_times    (SbDisplay      * self,
+					  gdouble        * before,
+					  gdouble        * after);
+void       sb_display_highlight_revision (SbDisplay      * self,
+					  SbRevision     * revision,
+					  gboolean         filter);
+void       sb_display_highlight_author   (SbDisplay      * self,
+					  gchar const    * author,
+					  gboolean         filter);
+void       sb_display_clear_highlight    (SbDisplay      * self);
 
 struct _SbDisplay {
 	GtkHBox           base_instance;
@@ -0,0 +1,305 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-file-history.h"
+
+#include "sb-git.h"
+#include "sb-repository.h"
+
+/* The commits which changed a file, oldest first, with the path the file
+ * had in each of them. One "git log --follow --name-only" lists them;
+ * the paths differ from today's across renames.
+ */
+
+typedef struct {
+	gchar * revision;
+	gchar * path;     /* absolute */
+	gint64  time;
+} Entry;
+
+struct _SbFileHistoryPrivate {
+	gchar       * file_path;
+	SbRepository* repository;
+
+	GArray      * entries;  /* of Entry, newest first while reading */
+	SbJob       * job;
+	gboolean      done;
+};
+
+enum {
+	DONE,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+G_DEFINE_TYPE (SbFileHistory, sb_file_history, G_TYPE_OBJECT);
+
+static void
+sb_file_history_init (SbFileHistory* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_FILE_HISTORY,
+						      SbFileHistoryPrivate);
+
+	self->_private->entries = g_array_new (FALSE, FALSE, sizeof (Entry));
+}
+
+static void
+file_history_finalize (GObject* object)
+{
+	SbFileHistory* self = SB_FILE_HISTORY (object);
+	guint          i;
+
+	sb_file_history_cancel (self);
+
+	for (i = 0; i < self->_private->entries->len; i++) {
+		Entry* entry = &g_array_index (self->_private->entries, Entry, i);
+
+		g_free (entry->revision);
+		g_free (entry->path);
+	}
+	g_array_free (self->_private->entries, TRUE);
+	g_free (self->_private->file_path);
+	if (self->_private->repository) {
+		g_object_unref (self->_private->repository);
+	}
+
+	G_OBJECT_CLASS (sb_file_history_parent_class)->finalize (object);
+}
+
+static void
+sb_file_history_class_init (SbFileHistoryClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = file_history_finalize;
+
+	signals[DONE] = g_signal_new ("done",
+				      SB_TYPE_FILE_HISTORY,
+				      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbFileHistoryClass, done),
+				      NULL, NULL,
+				      g_cclosure_marshal_VOID__VOID,
+				      G_TYPE_NONE, 0);
+
+	g_type_class_add_private (self_class, sizeof (SbFileHistoryPrivate));
+}
+
+SbFileHistory*
+sb_file_history_new (gchar const* file_path)
+{
+	SbFileHistory* self;
+	gchar        * folder;
+
+	g_return_val_if_fail (file_path && g_path_is_absolute (file_path), NULL);
+
+	self = g_object_new (SB_TYPE_FILE_HISTORY, NULL);
+	self->_private->file_path = g_strdup (file_path);
+
+	folder = g_path_get_dirname (file_path);
+	self->_private->repository = sb_repository_lookup (folder);
+	if (self->_private->repository) {
+		g_object_ref (self->_private->repository);
+	}
+	g_free (folder);
+
+	return self;
+}
+
+static void
+file_history_disconnect (SbFileHistory* self)
+{
+	g_signal_handlers_disconnect_matched (sb_job_get_reader (self->_private->job), G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	g_signal_handlers_disconnect_matched (self->_private->job, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	g_object_unref (self->_private->job);
+	self->_private->job = NULL;
+}
+
+/* "\0<commit>\t<time>", then the path in that commit */
+static void
+file_history_read_lines_cb (SbAsyncReader    * reader,
+			    SbLineBatch const* batch,
+			    SbFileHistory    * self)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_lines; i++) {
+		gchar const* line = batch->lines[i];
+
+		if (!batch->lengths[i]) {
+			continue;
+		}
+
+		if (!*line) {
+			gchar** fields = g_strsplit (line + 1, "\t", 2);
+			Entry   entry  = {NULL};
+
+			entry.revision = g_strdup (fields[0]);
+			entry.time     = fields[0] && fields[1] ? g_ascii_strtoll (fields[1], NULL, 10) : 0;
+			g_array_append_val (self->_private->entries, entry);
+			g_strfreev (fields);
+		} else if (self->_private->entries->len) {
+			Entry* entry = &g_array_index (self->_private->entries, Entry, self->_private->entries->len - 1);
+
+			if (!entry->path) {
+				entry->path = g_build_filename (sb_repository_get_toplevel (self->_private->repository),
+								line, NULL);
+			}
+		}
+	}
+}
+
+static void
+file_history_done_cb (SbFileHistory* self,
+		      SbJob        * job)
+{
+	GArray* entries = self->_private->entries;
+	guint   i;
+
+	file_history_disconnect (self);
+
+	/* oldest first, like a time line */
+	for (i = 0; i < entries->len / 2; i++) {
+		Entry swap = g_array_index (entries, Entry, i);
+
+		g_array_index (entries, Entry, i) = g_array_index (entries, Entry, entries->len - 1 - i);
+		g_array_index (entries, Entry, entries->len - 1 - i) = swap;
+	}
+
+	/* merges don't name files */
+	for (i = 0; i < entries->len; i++) {
+		Entry* entry = &g_array_index (entries, Entry, i);
+
+		if (!entry->path) {
+			entry->path = g_strdup (i ? g_array_index (entries, Entry, i - 1).path : self->_private->file_path);
+		}
+	}
+
+	self->_private->done = TRUE;
+	g_signal_emit (self, signals[DONE], 0);
+}
+
+gboolean
+sb_file_history_start (SbFileHistory* self,
+		       GError       ** error)
+{
+	g_return_val_if_fail (SB_IS_FILE_HISTORY (self), FALSE);
+	g_return_val_if_fail (!self->_private->job && !self->_private->done, FALSE);
+
+	if (!self->_private->repository) {
+		g_set_error (error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED,
+			     "%s is not in a git repository", self->_private->file_path);
+		return FALSE;
+	}
+
+	/* NUL can't be in a path, so it marks the commits */
+	self->_private->job = sb_git_job_new (sb_repository_get_toplevel (self->_private->repository), 0,
+					      "-c", "core.quotePath=false",
+					      "log", "--follow", "--name-only",
+					      "--format=%x00%H%x09%at",
+					      "--",
+					      sb_repository_get_relative_path (self->_private->repository,
+									       self->_private->file_path),
+					      NULL);
+	sb_job_set_priority (self->_private->job, SB_JOB_PRIORITY_DETAILS);
+	if (!sb_job_start (self->_private->job, error)) {
+		g_object_unref (self->_private->job);
+		self->_private->job = NULL;
+		return FALSE;
+	}
+
+	g_signal_connect (sb_job_get_reader (self->_private->job), "read-lines",
+			  G_CALLBACK (file_history_read_lines_cb), self);
+	g_signal_connect_swapped (self->_private->job, "done",
+				  G_CALLBACK (file_history_done_cb), self);
+
+	return TRUE;
+}
+
+void
+sb_file_history_cancel (SbFileHistory* self)
+{
+	g_return_if_fail (SB_IS_FILE_HISTORY (self));
+
+	if (self->_private->job) {
+		sb_job_cancel (self->_private->job);
+		file_history_disconnect (self);
+	}
+}
+
+gboolean
+sb_file_history_is_done (SbFileHistory const* self)
+{
+	g_return_val_if_fail (SB_IS_FILE_HISTORY (self), FALSE);
+
+	return self->_private->done;
+}
+
+gchar const*
+sb_file_history_get_file_path (SbFileHistory const* self)
+{
+	g_return_val_if_fail (SB_IS_FILE_HISTORY (self), NULL);
+
+	return self->_private->file_path;
+}
+
+guint
+sb_file_history_get_n_revisions (SbFileHistory const* self)
+{
+	g_return_val_if_fail (SB_IS_FILE_HISTORY (self), 0);
+
+	return self->_private->done ? self->_private->entries->len : 0;
+}
+
+gchar const*
+sb_file_history_get_revision (SbFileHistory const* self,
+			      guint                index)
+{
+	g_return_val_if_fail (SB_IS_FILE_HISTORY (self), NULL);
+	g_return_val_if_fail (index < sb_file_history_get_n_revisions (self), NULL);
+
+	return g_array_index (self->_private->entries, Entry, index).revision;
+}
+
+/* the absolute path the file had in the revision */
+gchar const*
+sb_file_history_get_path (SbFileHistory const* self,
+			  guint                index)
+{
+	g_return_val_if_fail (SB_IS_FILE_HISTORY (self), NULL);
+	g_return_val_if_fail (index < sb_file_history_get_n_revisions (self), NULL);
+
+	return g_array_index (self->_private->entries, Entry, index).path;
+}
+
+gint64
+sb_file_history_get_time (SbFileHistory const* self,
+			  guint                index)
+{
+	g_return_val_if_fail (SB_IS_FILE_HISTORY (self), 0);
+	g_return_val_if_fail (index < sb_file_history_get_n_revisions (self), 0);
+
+	return g_array_index (self->_private->entries, Entry, index).time;
+}
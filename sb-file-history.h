@@ -0,0 +1,71 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_FILE_HISTORY_H
+#define SB_FILE_HISTORY_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef struct _SbFileHistory        SbFileHistory;
+typedef struct _SbFileHistoryPrivate SbFileHistoryPrivate;
+typedef struct _SbFileHistoryClass   SbFileHistoryClass;
+
+#define SB_TYPE_FILE_HISTORY         (sb_file_history_get_type ())
+#define SB_FILE_HISTORY(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_FILE_HISTORY, SbFileHistory))
+#define SB_FILE_HISTORY_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_FILE_HISTORY, SbFileHistoryClass))
+#define SB_IS_FILE_HISTORY(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_FILE_HISTORY))
+#define SB_IS_FILE_HISTORY_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_FILE_HISTORY))
+#define SB_FILE_HISTORY_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_FILE_HISTORY, SbFileHistoryClass))
+
+GType          sb_file_history_get_type     (void);
+SbFileHistory* sb_file_history_new          (gchar const        * file_path);
+gboolean       sb_file_history_start        (SbFileHistory      * self,
+					     GError            ** error);
+void           sb_file_history_cancel       (SbFileHistory      * self);
+gboolean       sb_file_history_is_done      (SbFileHistory const* self);
+gchar const*   sb_file_history_get_file_path (SbFileHistory const* self);
+guint          sb_file_history_get_n_revisions (SbFileHistory const* self);
+gchar const*   sb_file_history_get_revision (SbFileHistory const* self,
+					     guint                index);
+gchar const*   sb_file_history_get_path     (SbFileHistory const* self,
+					     guint                index);
+gint64         sb_file_history_get_time     (SbFileHistory const* self,
+					     guint                index);
+
+struct _SbFileHistory {
+	GObject               base_instance;
+	SbFileHistoryPrivate* _private;
+};
+
+struct _SbFileHistoryClass {
+	GObjectClass          base_class;
+
+	/* signals */
+	void (*done) (SbFileHistory* self);
+};
+
+G_END_DECLS
+
+#endif /* !SB_FILE_HISTORY_H */
@@ -0,0 +1,485 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-file-index.h"
+
+#include <string.h>
+
+#include "sb-git.h"
+
+/* The paths of every file git knows in a repository, for finding files
+ * by a few letters of their name.
+ *
+ * The list comes from "git ls-files -z" once per HEAD and gets written
+ * into the cache folder of the user (see sb_repository_get_cache_file()),
+ * so the next start only reads one file. The
+ * paths live in one buffer, NUL separated, plus a lower case copy for
+ * matching; an array holds where each path starts.
+ *
+ * A path matches if the (lower case) query is a subsequence of it. Each
+ * letter is found with memchr(), which scans many bytes per step, so a
+ * non-matching path costs about as much as reading it. Matches score
+ * for letters right after the previous one, at the start of a word and
+ * in the file name; shorter paths win ties. A query that extends the
+ * previous one only looks at the previous matches.
+ */
+
+#define INDEX_FILE "files"
+
+struct _SbFileIndexPrivate {
+	SbRepository* repository;
+	gchar       * head;      /* what the index was made from */
+
+	GByteArray  * paths;     /* NUL separated */
+	GByteArray  * folded;    /* the same in lower case */
+	GArray      * starts;    /* of guint, by file */
+
+	/* narrowed down while the query grows */
+	gchar       * query;
+	GArray      * matches;   /* of guint */
+
+	SbJob       * job;
+	gboolean      ready;
+};
+
+enum {
+	READY,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+static GHashTable* indices = NULL;  /* git dir => SbFileIndex */
+
+G_DEFINE_TYPE (SbFileIndex, sb_file_index, G_TYPE_OBJECT);
+
+static void
+sb_file_index_init (SbFileIndex* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_FILE_INDEX,
+						      SbFileIndexPrivate);
+
+	self->_private->paths   = g_byte_array_new ();
+	self->_private->folded  = g_byte_array_new ();
+	self->_private->starts  = g_array_new (FALSE, FALSE, sizeof (guint));
+	self->_private->matches = g_array_new (FALSE, FALSE, sizeof (guint));
+}
+
+static void
+file_index_stop (SbFileIndex* self)
+{
+	if (!self->_private->job) {
+		return;
+	}
+
+	g_signal_handlers_disconnect_matched (sb_job_get_reader (self->_private->job), G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	g_signal_handlers_disconnect_matched (self->_private->job, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	sb_job_cancel (self->_private->job);
+	g_object_unref (self->_private->job);
+	self->_private->job = NULL;
+}
+
+static void
+file_index_finalize (GObject* object)
+{
+	SbFileIndex* self = SB_FILE_INDEX (object);
+
+	file_index_stop (self);
+
+	g_byte_array_free (self->_private->paths,  TRUE);
+	g_byte_array_free (self->_private->folded, TRUE);
+	g_array_free (self->_private->starts,  TRUE);
+	g_array_free (self->_private->matches, TRUE);
+	g_free (self->_private->query);
+	g_free (self->_private->head);
+	g_object_unref (self->_private->repository);
+
+	G_OBJECT_CLASS (sb_file_index_parent_class)->finalize (object);
+}
+
+static void
+sb_file_index_class_init (SbFileIndexClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = file_index_finalize;
+
+	signals[READY] = g_signal_new ("ready",
+				       SB_TYPE_FILE_INDEX,
+				       G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbFileIndexClass, ready),
+				       NULL, NULL,
+				       g_cclosure_marshal_VOID__VOID,
+				       G_TYPE_NONE, 0);
+
+	g_type_class_add_private (self_class, sizeof (SbFileIndexPrivate));
+}
+
+static void
+file_index_clear (SbFileIndex* self)
+{
+	g_byte_array_set_size (self->_private->paths,  0);
+	g_byte_array_set_size (self->_private->folded, 0);
+	g_array_set_size (self->_private->starts,  0);
+	g_array_set_size (self->_private->matches, 0);
+	g_free (self->_private->query);
+	self->_private->query = NULL;
+	self->_private->ready = FALSE;
+}
+
+static void
+file_index_add (SbFileIndex* self,
+		gchar const* path,
+		gsize        length)
+{
+	guint start = self->_private->paths->len;
+	guint i;
+
+	g_array_append_val (self->_private->starts, start);
+	g_byte_array_append (self->_private->paths, (guint8 const*)path, length + 1);
+
+	/* ASCII only; the folding has to keep the offsets */
+	g_byte_array_set_size (self->_private->folded, start + length + 1);
+	for (i = 0; i <= length; i++) {
+		self->_private->folded->data[start + i] = g_ascii_tolower (path[i]);
+	}
+}
+
+static gchar*
+file_index_get_file (SbFileIndex const* self)
+{
+	return sb_repository_get_cache_file (self->_private->repository, INDEX_FILE);
+}
+
+/* "<head>\n" and the NUL terminated paths */
+static gboolean
+file_index_read (SbFileIndex* self)
+{
+	gchar      * filename = file_index_get_file (self);
+	gchar      * contents = NULL;
+	gsize        length   = 0;
+	gchar const* iter;
+	gchar const* end;
+	gchar const* newline;
+
+	g_file_get_contents (filename, &contents, &length, NULL);
+	g_free (filename);
+
+	newline = contents ? memchr (contents, '\n', length) : NULL;
+	if (!newline || !self->_private->head ||
+	    strncmp (contents, self->_private->head, newline - contents) ||
+	    strlen (self->_private->head) != (gsize)(newline - contents))
+	{
+		g_free (contents);
+		return FALSE;
+	}
+
+	end = contents + length;
+	for (iter = newline + 1; iter < end; ) {
+		gchar const* nul = memchr (iter, '\0', end - iter);
+
+		if (!nul) {
+			break;
+		}
+
+		file_index_add (self, iter, nul - iter);
+		iter = nul + 1;
+	}
+	g_free (contents);
+
+	return TRUE;
+}
+
+static void
+file_index_write (SbFileIndex* self)
+{
+	gchar  * filename = file_index_get_file (self);
+	GString* contents = g_string_sized_new (self->_private->paths->len + 64);
+	GError * error    = NULL;
+
+	g_string_append_printf (contents, "%s\n", self->_private->head);
+	g_string_append_len (contents, (gchar const*)self->_private->paths->data, self->_private->paths->len);
+
+	if (!g_file_set_contents (filename, contents->str, contents->len, &error)) {
+		/* only the next start gets slower */
+		g_warning ("couldn't write %s: %s", filename, error->message);
+		g_error_free (error);
+	}
+
+	g_string_free (contents, TRUE);
+	g_free (filename);
+}
+
+static void
+file_index_read_lines_cb (SbAsyncReader    * reader,
+			  SbLineBatch const* batch,
+			  SbFileIndex      * self)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_lines; i++) {
+		if (batch->lengths[i]) {
+			file_index_add (self, batch->lines[i], batch->lengths[i]);
+		}
+	}
+}
+
+static void
+file_index_done_cb (SbFileIndex* self,
+		    SbJob      * job)
+{
+	gboolean complete = sb_job_get_exit_status (job) == 0;
+
+	file_index_stop (self);
+
+	if (complete) {
+		file_index_write (self);
+	}
+
+	/* searches while loading only saw a part */
+	g_free (self->_private->query);
+	self->_private->query = NULL;
+
+	self->_private->ready = TRUE;
+	g_signal_emit (self, signals[READY], 0);
+}
+
+static void
+file_index_load (SbFileIndex* self)
+{
+	file_index_stop (self);
+	file_index_clear (self);
+
+	g_free (self->_private->head);
+	self->_private->head = g_strdup (sb_repository_get_head (self->_private->repository));
+
+	if (file_index_read (self)) {
+		self->_private->ready = TRUE;
+		return;
+	}
+	file_index_clear (self);
+
+	self->_private->job = sb_git_job_new (sb_repository_get_toplevel (self->_private->repository), 0,
+					      "ls-files", "-z",
+					      NULL);
+	sb_job_set_priority (self->_private->job, SB_JOB_PRIORITY_VISIBLE);
+	if (!sb_job_start (self->_private->job, NULL)) {
+		g_object_unref (self->_private->job);
+		self->_private->job   = NULL;
+		self->_private->ready = TRUE;
+		return;
+	}
+
+	sb_async_reader_set_separator (sb_job_get_reader (self->_private->job), '\0');
+	g_signal_connect (sb_job_get_reader (self->_private->job), "read-lines",
+			  G_CALLBACK (file_index_read_lines_cb), self);
+	g_signal_connect_swapped (self->_private->job, "done",
+				  G_CALLBACK (file_index_done_cb), self);
+}
+
+/* shared per repository and rebuilt when HEAD moved; "ready" tells when a
+ * new list is there. The caller doesn't own the returned index. */
+SbFileIndex*
+sb_file_index_lookup (SbRepository* repository)
+{
+	SbFileIndex* self;
+
+	g_return_val_if_fail (SB_IS_REPOSITORY (repository), NULL);
+
+	if (G_UNLIKELY (!indices)) {
+		indices = g_hash_table_new_full (g_str_hash, g_str_equal,
+						 g_free,     g_object_unref);
+	}
+
+	self = g_hash_table_lookup (indices, sb_repository_get_git_dir (repository));
+	if (!self) {
+		self = g_object_new (SB_TYPE_FILE_INDEX, NULL);
+		self->_private->repository = g_object_ref (repository);
+		g_hash_table_insert (indices, g_strdup (sb_repository_get_git_dir (repository)), self);
+		file_index_load (self);
+	} else if (!self->_private->job &&
+		   g_strcmp0 (self->_private->head, sb_repository_get_head (repository)))
+	{
+		file_index_load (self);
+	}
+
+	return self;
+}
+
+SbRepository*
+sb_file_index_get_repository (SbFileIndex const* self)
+{
+	g_return_val_if_fail (SB_IS_FILE_INDEX (self), NULL);
+
+	return self->_private->repository;
+}
+
+gboolean
+sb_file_index_is_ready (SbFileIndex const* self)
+{
+	g_return_val_if_fail (SB_IS_FILE_INDEX (self), FALSE);
+
+	return self->_private->ready;
+}
+
+guint
+sb_file_index_get_n_files (SbFileIndex const* self)
+{
+	g_return_val_if_fail (SB_IS_FILE_INDEX (self), 0);
+
+	return self->_private->starts->len;
+}
+
+/* relative to the top level of the repository */
+gchar const*
+sb_file_index_get_path (SbFileIndex const* self,
+			guint              index)
+{
+	g_return_val_if_fail (SB_IS_FILE_INDEX (self), NULL);
+	g_return_val_if_fail (index < self->_private->starts->len, NULL);
+
+	return (gchar const*)self->_private->paths->data + g_array_index (self->_private->starts, guint, index);
+}
+
+static inline gboolean
+is_word_start (gchar const* path,
+	       gchar const* letter)
+{
+	return letter == path || strchr ("/_-. ", letter[-1]);
+}
+
+/* -1 if @query isn't a subsequence of @path (both folded) */
+static gint
+file_index_score (gchar const* path,
+		  gsize        length,
+		  gchar const* query,
+		  gsize        query_length)
+{
+	gchar const* end  = path + length;
+	gchar const* name = g_strrstr_len (path, length, "/");
+	gchar const* iter = path;
+	gchar const* last = NULL;
+	gint         result = 0;
+	gsize        i;
+
+	name = name ? name + 1 : path;
+
+	for (i = 0; i < query_length; i++) {
+		gchar const* hit = memchr (iter, query[i], end - iter);
+
+		if (!hit) {
+			return -1;
+		}
+
+		result += 1;
+		if (last && hit == last + 1) {
+			result += 4;
+		}
+		if (is_word_start (path, hit)) {
+			result += 6;
+		}
+		if (hit >= name) {
+			result += 2;
+		}
+
+		last = hit;
+		iter = hit + 1;
+	}
+
+	return result * 64 - MIN (length, 63);
+}
+
+/* the best @max_results matches for @query, best first; returns how many
+ * were stored in @results */
+guint
+sb_file_index_search (SbFileIndex* self,
+		      gchar const* query,
+		      guint      * results,
+		      guint        max_results)
+{
+	GArray     * matches = self->_private->matches;
+	gchar      * folded;
+	gsize        query_length;
+	gint       * scores;
+	guint        n_results = 0;
+	guint        n_candidates;
+	guint        kept = 0;
+	guint        i;
+
+	g_return_val_if_fail (SB_IS_FILE_INDEX (self), 0);
+	g_return_val_if_fail (query, 0);
+	g_return_val_if_fail (results || !max_results, 0);
+
+	folded       = g_ascii_strdown (query, -1);
+	query_length = strlen (folded);
+
+	/* a longer query only drops matches */
+	if (!self->_private->query || !g_str_has_prefix (folded, self->_private->query)) {
+		g_array_set_size (matches, self->_private->starts->len);
+		for (i = 0; i < matches->len; i++) {
+			g_array_index (matches, guint, i) = i;
+		}
+	}
+	n_candidates = matches->len;
+
+	scores = g_new (gint, max_results + 1);
+
+	for (i = 0; i < n_candidates; i++) {
+		guint        index = g_array_index (matches, guint, i);
+		guint        start = g_array_index (self->_private->starts, guint, index);
+		guint        next  = index + 1 < self->_private->starts->len ?
+				     g_array_index (self->_private->starts, guint, index + 1) :
+				     self->_private->folded->len;
+		gint         score = file_index_score ((gchar const*)self->_private->folded->data + start,
+						       next - start - 1,
+						       folded, query_length);
+		guint        position;
+
+		if (score < 0) {
+			continue;
+		}
+		g_array_index (matches, guint, kept++) = index;
+
+		if (n_results == max_results && (!max_results || score <= scores[n_results - 1])) {
+			continue;
+		}
+
+		/* insert into the (short) sorted results */
+		for (position = MIN (n_results, max_results - 1); position && scores[position - 1] < score; position--) {
+			scores[position]  = scores[position - 1];
+			results[position] = results[position - 1];
+		}
+		scores[position]  = score;
+		results[position] = index;
+		n_results = MIN (n_results + 1, max_results);
+	}
+
+	g_array_set_size (matches, kept);
+	g_free (self->_private->query);
+	self->_private->query = folded;
+	g_free (scores);
+
+	return n_results;
+}
@@ -0,0 +1,68 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_FILE_INDEX_H
+#define SB_FILE_INDEX_H
+
+#include "sb-repository.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbFileIndex        SbFileIndex;
+typedef struct _SbFileIndexPrivate SbFileIndexPrivate;
+typedef struct _SbFileIndexClass   SbFileIndexClass;
+
+#define SB_TYPE_FILE_INDEX         (sb_file_index_get_type ())
+#define SB_FILE_INDEX(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_FILE_INDEX, SbFileIndex))
+#define SB_FILE_INDEX_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_FILE_INDEX, SbFileIndexClass))
+#define SB_IS_FILE_INDEX(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_FILE_INDEX))
+#define SB_IS_FILE_INDEX_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_FILE_INDEX))
+#define SB_FILE_INDEX_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_FILE_INDEX, SbFileIndexClass))
+
+GType         sb_file_index_get_type    (void);
+SbFileIndex*  sb_file_index_lookup      (SbRepository     * repository);
+SbRepository* sb_file_index_get_repository (SbFileIndex const* self);
+gboolean      sb_file_index_is_ready    (SbFileIndex const* self);
+guint         sb_file_index_get_n_files (SbFileIndex const* self);
+gchar const*  sb_file_index_get_path    (SbFileIndex const* self,
+					 guint              index);
+guint         sb_file_index_search      (SbFileIndex      * self,
+					 gchar const      * query,
+					 guint            * results,
+					 guint              max_results);
+
+struct _SbFileIndex {
+	GObject             base_instance;
+	SbFileIndexPrivate* _private;
+};
+
+struct _SbFileIndexClass {
+	GObjectClass        base_class;
+
+	/* signals */
+	void (*ready) (SbFileIndex* self);
+};
+
+G_END_DECLS
+
+#endif /* !SB_FILE_INDEX_H */
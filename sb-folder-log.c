@@ -0,0 +1,455 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-folder-log.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sb-git.h"
+#include "sb-repository.h"
+
+/* The entries of a folder at HEAD, each with the last commit touching it,
+ * like the file lists of code hosting sites.
+ *
+ * "git ls-tree" lists the entries, then one "git log --name-only" walks
+ * the history of the folder, newest first. The first commit naming a
+ * path below an entry is the last one touching it; the log gets cancelled
+ * as soon as every entry is known, which is early for busy folders.
+ *
+ * The logs are shared and kept until HEAD moves: going back into a
+ * folder shows it right away.
+ */
+
+#define MAX_LOGS 16
+
+struct _SbFolderLogPrivate {
+	gchar       * folder;
+	SbRepository* repository;
+	gchar       * head;        /* what the entries were made from */
+
+	GArray      * entries;     /* of SbFolderEntry, sorted by name */
+	GHashTable  * names;       /* name => index + 1 */
+	guint         n_pending;   /* entries without a commit */
+
+	/* of the commit being read */
+	gchar       * commit;
+	glong         time;
+	gchar       * author;
+	gchar       * subject;
+
+	SbJob       * job;
+	gboolean      done;
+};
+
+enum {
+	ENTRIES_LISTED,
+	ENTRY_RESOLVED,
+	DONE,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+static GQueue* logs = NULL;  /* of SbFolderLog, most recently used first */
+
+G_DEFINE_TYPE (SbFolderLog, sb_folder_log, G_TYPE_OBJECT);
+
+static void
+sb_folder_log_init (SbFolderLog* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_FOLDER_LOG,
+						      SbFolderLogPrivate);
+
+	self->_private->entries = g_array_new (FALSE, FALSE, sizeof (SbFolderEntry));
+	self->_private->names   = g_hash_table_new (g_str_hash, g_str_equal);
+}
+
+static void
+folder_log_stop (SbFolderLog* self)
+{
+	if (!self->_private->job) {
+		return;
+	}
+
+	g_signal_handlers_disconnect_matched (sb_job_get_reader (self->_private->job), G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	g_signal_handlers_disconnect_matched (self->_private->job, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	sb_job_cancel (self->_private->job);
+	g_object_unref (self->_private->job);
+	self->_private->job = NULL;
+}
+
+static void
+folder_log_finalize (GObject* object)
+{
+	SbFolderLog* self = SB_FOLDER_LOG (object);
+	guint        i;
+
+	folder_log_stop (self);
+
+	for (i = 0; i < self->_private->entries->len; i++) {
+		SbFolderEntry* entry = &g_array_index (self->_private->entries, SbFolderEntry, i);
+
+		g_free (entry->name);
+		g_free (entry->commit);
+		g_free (entry->author);
+		g_free (entry->subject);
+	}
+	g_array_free (self->_private->entries, TRUE);
+	g_hash_table_destroy (self->_private->names);
+
+	g_free (self->_private->commit);
+	g_free (self->_private->author);
+	g_free (self->_private->subject);
+	g_free (self->_private->head);
+	g_free (self->_private->folder);
+	if (self->_private->repository) {
+		g_object_unref (self->_private->repository);
+	}
+
+	G_OBJECT_CLASS (sb_folder_log_parent_class)->finalize (object);
+}
+
+static void
+sb_folder_log_class_init (SbFolderLogClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = folder_log_finalize;
+
+	signals[ENTRIES_LISTED] = g_signal_new ("entries-listed",
+						SB_TYPE_FOLDER_LOG,
+						G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbFolderLogClass, entries_listed),
+						NULL, NULL,
+						g_cclosure_marshal_VOID__VOID,
+						G_TYPE_NONE, 0);
+	signals[ENTRY_RESOLVED] = g_signal_new ("entry-resolved",
+						SB_TYPE_FOLDER_LOG,
+						G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbFolderLogClass, entry_resolved),
+						NULL, NULL,
+						g_cclosure_marshal_VOID__UINT,
+						G_TYPE_NONE, 1,
+						G_TYPE_UINT);
+	signals[DONE]           = g_signal_new ("done",
+						SB_TYPE_FOLDER_LOG,
+						G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbFolderLogClass, done),
+						NULL, NULL,
+						g_cclosure_marshal_VOID__VOID,
+						G_TYPE_NONE, 0);
+
+	g_type_class_add_private (self_class, sizeof (SbFolderLogPrivate));
+}
+
+static void
+folder_log_finish (SbFolderLog* self)
+{
+	folder_log_stop (self);
+	self->_private->done = TRUE;
+
+	g_signal_emit (self, signals[DONE], 0);
+}
+
+/* "\0<commit>\t<time>\t<author>\t<subject>", or a path below the folder */
+static void
+log_read_lines_cb (SbAsyncReader    * reader,
+		   SbLineBatch const* batch,
+		   SbFolderLog      * self)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_lines && self->_private->n_pending; i++) {
+		gchar const  * line = batch->lines[i];
+		SbFolderEntry* entry;
+		gchar        * name;
+		guint          index;
+
+		if (!batch->lengths[i]) {
+			continue;
+		}
+
+		if (!*line) {
+			gchar** fields = g_strsplit (line + 1, "\t", 4);
+
+			g_free (self->_private->commit);
+			g_free (self->_private->author);
+			g_free (self->_private->subject);
+			self->_private->commit  = g_strdup (fields[0]);
+			self->_private->time    = fields[0] && fields[1] ? strtol (fields[1], NULL, 10) : 0;
+			self->_private->author  = g_strdup (fields[0] && fields[1] ? fields[2] : NULL);
+			self->_private->subject = g_strdup (fields[0] && fields[1] && fields[2] ? fields[3] : NULL);
+			g_strfreev (fields);
+			continue;
+		}
+
+		/* the entry is the first component */
+		name  = g_strndup (line, strcspn (line, "/"));
+		index = GPOINTER_TO_UINT (g_hash_table_lookup (self->_private->names, name));
+		g_free (name);
+		if (!index || !self->_private->commit) {
+			/* gone since, or no commit */
+			continue;
+		}
+
+		entry = &g_array_index (self->_private->entries, SbFolderEntry, index - 1);
+		if (entry->commit) {
+			continue;
+		}
+
+		entry->commit  = g_strdup (self->_private->commit);
+		entry->time    = self->_private->time;
+		entry->author  = g_strdup (self->_private->author);
+		entry->subject = g_strdup (self->_private->subject);
+		self->_private->n_pending--;
+
+		g_signal_emit (self, signals[ENTRY_RESOLVED], 0, index - 1);
+	}
+
+	if (!self->_private->n_pending && self->_private->job) {
+		/* the rest of the history doesn't change anything */
+		sb_job_cancel (self->_private->job);
+	}
+}
+
+static void
+log_done_cb (SbFolderLog* self,
+	     SbJob      * job)
+{
+	folder_log_finish (self);
+}
+
+static void
+folder_log_start_log (SbFolderLog* self)
+{
+	folder_log_stop (self);
+
+	if (!self->_private->n_pending) {
+		folder_log_finish (self);
+		return;
+	}
+
+	/* NUL can't be in a path, so it marks the commits */
+	self->_private->job = sb_git_job_new (self->_private->folder, 0,
+					      "-c", "core.quotePath=false",
+					      "log", "--name-only", "--relative", "--no-renames",
+					      "--format=%x00%H%x09%at%x09%an%x09%s",
+					      "--", ".",
+					      NULL);
+	sb_job_set_priority (self->_private->job, SB_JOB_PRIORITY_DETAILS);
+	if (!sb_job_start (self->_private->job, NULL)) {
+		g_object_unref (self->_private->job);
+		self->_private->job = NULL;
+		folder_log_finish (self);
+		return;
+	}
+
+	g_signal_connect (sb_job_get_reader (self->_private->job), "read-lines",
+			  G_CALLBACK (log_read_lines_cb), self);
+	g_signal_connect_swapped (self->_private->job, "done",
+				  G_CALLBACK (log_done_cb), self);
+}
+
+static gint
+compare_entries (gconstpointer a,
+		 gconstpointer b)
+{
+	SbFolderEntry const* entry_a = a;
+	SbFolderEntry const* entry_b = b;
+
+	/* folders first */
+	if (entry_a->is_folder != entry_b->is_folder) {
+		return entry_a->is_folder ? -1 : 1;
+	}
+
+	return g_utf8_collate (entry_a->name, entry_b->name);
+}
+
+/* "<mode> <type> <object>\t<name>" */
+static void
+tree_read_lines_cb (SbAsyncReader    * reader,
+		    SbLineBatch const* batch,
+		    SbFolderLog      * self)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_lines; i++) {
+		gchar const * line = batch->lines[i];
+		gchar const * tab  = strchr (line, '\t');
+		gchar const * type = strchr (line, ' ');
+		SbFolderEntry entry = {NULL};
+
+		if (!tab || !type || type > tab) {
+			continue;
+		}
+
+		entry.name      = g_strdup (tab + 1);
+		entry.is_folder = g_str_has_prefix (type + 1, "tree ");
+		g_array_append_val (self->_private->entries, entry);
+	}
+}
+
+static void
+tree_done_cb (SbFolderLog* self,
+	      SbJob      * job)
+{
+	guint i;
+
+	g_array_sort (self->_private->entries, compare_entries);
+	for (i = 0; i < self->_private->entries->len; i++) {
+		g_hash_table_insert (self->_private->names,
+				     g_array_index (self->_private->entries, SbFolderEntry, i).name,
+				     GUINT_TO_POINTER (i + 1));
+	}
+	self->_private->n_pending = self->_private->entries->len;
+
+	g_signal_emit (self, signals[ENTRIES_LISTED], 0);
+
+	folder_log_start_log (self);
+}
+
+static SbFolderLog*
+folder_log_new (gchar const * folder,
+		SbRepository* repository)
+{
+	SbFolderLog* self = g_object_new (SB_TYPE_FOLDER_LOG, NULL);
+
+	self->_private->folder     = g_strdup (folder);
+	self->_private->repository = g_object_ref (repository);
+	self->_private->head       = g_strdup (sb_repository_get_head (repository));
+
+	// FIXME: show the entries which aren't committed yet
+	self->_private->job = sb_git_job_new (folder, 0,
+					      "-c", "core.quotePath=false",
+					      "ls-tree", "HEAD",
+					      NULL);
+	sb_job_set_priority (self->_private->job, SB_JOB_PRIORITY_VISIBLE);
+	if (!sb_job_start (self->_private->job, NULL)) {
+		g_object_unref (self->_private->job);
+		self->_private->job  = NULL;
+		self->_private->done = TRUE;
+		return self;
+	}
+
+	g_signal_connect (sb_job_get_reader (self->_private->job), "read-lines",
+			  G_CALLBACK (tree_read_lines_cb), self);
+	g_signal_connect_swapped (self->_private->job, "done",
+				  G_CALLBACK (tree_done_cb), self);
+
+	return self;
+}
+
+/* the log of @folder, started if it's not known for the current HEAD; NULL
+ * outside of repositories. The caller doesn't own the returned log. */
+SbFolderLog*
+sb_folder_log_lookup (gchar const* folder)
+{
+	SbRepository* repository;
+	SbFolderLog * self;
+	GList       * iter;
+
+	g_return_val_if_fail (folder && g_path_is_absolute (folder), NULL);
+
+	repository = sb_repository_lookup (folder);
+	if (!repository) {
+		return NULL;
+	}
+
+	if (G_UNLIKELY (!logs)) {
+		logs = g_queue_new ();
+	}
+
+	for (iter = logs->head; iter; iter = iter->next) {
+		self = iter->data;
+
+		if (strcmp (self->_private->folder, folder)) {
+			continue;
+		}
+
+		g_queue_unlink (logs, iter);
+		if (sb_folder_log_is_current (self)) {
+			g_queue_push_head_link (logs, iter);
+			return self;
+		}
+
+		folder_log_stop (self);
+		g_object_unref (self);
+		g_list_free_1 (iter);
+		break;
+	}
+
+	self = folder_log_new (folder, repository);
+	g_queue_push_head (logs, self);
+
+	if (logs->length > MAX_LOGS) {
+		SbFolderLog* oldest = g_queue_pop_tail (logs);
+
+		folder_log_stop (oldest);
+		g_object_unref (oldest);
+	}
+
+	return self;
+}
+
+gchar const*
+sb_folder_log_get_folder (SbFolderLog const* self)
+{
+	g_return_val_if_fail (SB_IS_FOLDER_LOG (self), NULL);
+
+	return self->_private->folder;
+}
+
+gboolean
+sb_folder_log_is_done (SbFolderLog const* self)
+{
+	g_return_val_if_fail (SB_IS_FOLDER_LOG (self), FALSE);
+
+	return self->_private->done;
+}
+
+gboolean
+sb_folder_log_is_current (SbFolderLog const* self)
+{
+	g_return_val_if_fail (SB_IS_FOLDER_LOG (self), FALSE);
+
+	return !g_strcmp0 (sb_repository_get_head (self->_private->repository), self->_private->head);
+}
+
+guint
+sb_folder_log_get_n_entries (SbFolderLog const* self)
+{
+	g_return_val_if_fail (SB_IS_FOLDER_LOG (self), 0);
+
+	return self->_private->entries->len;
+}
+
+SbFolderEntry const*
+sb_folder_log_get_entry (SbFolderLog const* self,
+			 guint              index)
+{
+	g_return_val_if_fail (SB_IS_FOLDER_LOG (self), NULL);
+	g_return_val_if_fail (index < self->_private->entries->len, NULL);
+
+	return &g_array_index (self->_private->entries, SbFolderEntry, index);
+}
@@ -0,0 +1,80 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_FOLDER_LOG_H
+#define SB_FOLDER_LOG_H
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef struct _SbFolderEntry      SbFolderEntry;
+typedef struct _SbFolderLog        SbFolderLog;
+typedef struct _SbFolderLogPrivate SbFolderLogPrivate;
+typedef struct _SbFolderLogClass   SbFolderLogClass;
+
+#define SB_TYPE_FOLDER_LOG         (sb_folder_log_get_type ())
+#define SB_FOLDER_LOG(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_FOLDER_LOG, SbFolderLog))
+#define SB_FOLDER_LOG_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_FOLDER_LOG, SbFolderLogClass))
+#define SB_IS_FOLDER_LOG(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_FOLDER_LOG))
+#define SB_IS_FOLDER_LOG_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_FOLDER_LOG))
+#define SB_FOLDER_LOG_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_FOLDER_LOG, SbFolderLogClass))
+
+GType                sb_folder_log_get_type    (void);
+SbFolderLog*         sb_folder_log_lookup      (gchar const      * folder);
+gchar const*         sb_folder_log_get_folder  (SbFolderLog const* self);
+gboolean             sb_folder_log_is_done     (SbFolderLog const* self);
+gboolean             sb_folder_log_is_current  (SbFolderLog const* self);
+guint                sb_folder_log_get_n_entries (SbFolderLog const* self);
+SbFolderEntry const* sb_folder_log_get_entry   (SbFolderLog const* self,
+						guint              index);
+
+struct _SbFolderEntry {
+	gchar  * name;
+	gboolean is_folder;
+
+	/* the last commit touching the entry; NULL until it's known */
+	gchar  * commit;
+	glong    time;
+	gchar  * author;
+	gchar  * subject;
+};
+
+struct _SbFolderLog {
+	GObject             base_instance;
+	SbFolderLogPrivate* _private;
+};
+
+struct _SbFolderLogClass {
+	GObjectClass        base_class;
+
+	/* signals */
+	void (*entries_listed) (SbFolderLog* self);
+	void (*entry_resolved) (SbFolderLog* self,
+				guint        index);
+	void (*done)           (SbFolderLog* self);
+};
+
+G_END_DECLS
+
+#endif /* !SB_FOLDER_LOG_H */
@@ -0,0 +1,337 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-folder-view.h"
+
+#include <string.h>
+#include <time.h>
+#include <glib/gi18n.h>
+
+#include "sb-folder-log.h"
+#include "sb-repository.h"
+
+/* The entries of a folder in the repository with their last commit and
+ * its author and date, from an SbFolderLog. The rows are there as soon as
+ * the tree is listed; the commit columns fill in while the log resolves
+ * them. Activating a folder (or "..") goes there, activating a file
+ * emits "file-activated".
+ */
+
+enum {
+	COL_NAME,
+	COL_IS_FOLDER,
+	COL_SUBJECT,
+	COL_AUTHOR,
+	COL_TIME,
+	N_COLUMNS
+};
+
+struct _SbFolderViewPrivate {
+	gchar       * folder;
+	SbFolderLog * log;
+	GtkListStore* store;
+	guint         offset;  /* the rows before the entries of the log */
+};
+
+enum {
+	FILE_ACTIVATED,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+G_DEFINE_TYPE (SbFolderView, sb_folder_view, GTK_TYPE_TREE_VIEW);
+
+static void
+name_data_func (GtkTreeViewColumn* column,
+		GtkCellRenderer  * renderer,
+		GtkTreeModel     * model,
+		GtkTreeIter      * iter,
+		gpointer           unused)
+{
+	gboolean is_folder;
+	gchar  * name;
+	gchar  * text;
+
+	gtk_tree_model_get (model, iter,
+			    COL_NAME,      &name,
+			    COL_IS_FOLDER, &is_folder,
+			    -1);
+
+	text = g_strconcat (name, is_folder ? "/" : NULL, NULL);
+	g_object_set (renderer, "text", text, NULL);
+	g_free (text);
+	g_free (name);
+}
+
+static void
+time_data_func (GtkTreeViewColumn* column,
+		GtkCellRenderer  * renderer,
+		GtkTreeModel     * model,
+		GtkTreeIter      * iter,
+		gpointer           unused)
+{
+	glong     seconds;
+	time_t    time;
+	struct tm tm;
+	gchar     date[64] = "";
+
+	gtk_tree_model_get (model, iter, COL_TIME, &seconds, -1);
+
+	if (seconds) {
+		time = seconds;
+		strftime (date, sizeof (date), "%Y-%m-%d", localtime_r (&time, &tm));
+	}
+	g_object_set (renderer, "text", date, NULL);
+}
+
+static void
+folder_view_append_column (SbFolderView* self,
+			   gchar const * title,
+			   gint          column)
+{
+	GtkCellRenderer  * renderer = gtk_cell_renderer_text_new ();
+	GtkTreeViewColumn* result;
+
+	if (column == COL_NAME || column == COL_TIME) {
+		result = gtk_tree_view_column_new_with_attributes (title, renderer, NULL);
+		gtk_tree_view_column_set_cell_data_func (result, renderer,
+							 column == COL_NAME ? name_data_func : time_data_func,
+							 NULL, NULL);
+	} else {
+		result = gtk_tree_view_column_new_with_attributes (title, renderer,
+								   "text", column,
+								   NULL);
+	}
+
+	if (column == COL_SUBJECT) {
+		g_object_set (renderer, "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+		gtk_tree_view_column_set_expand (result, TRUE);
+	}
+
+	gtk_tree_view_append_column (GTK_TREE_VIEW (self), result);
+}
+
+static void
+sb_folder_view_init (SbFolderView* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_FOLDER_VIEW,
+						      SbFolderViewPrivate);
+
+	/* not sortable: the rows keep the order of the log's entries */
+	self->_private->store = gtk_list_store_new (N_COLUMNS,
+						    G_TYPE_STRING,
+						    G_TYPE_BOOLEAN,
+						    G_TYPE_STRING,
+						    G_TYPE_STRING,
+						    G_TYPE_LONG);
+	gtk_tree_view_set_model (GTK_TREE_VIEW (self), GTK_TREE_MODEL (self->_private->store));
+
+	folder_view_append_column (self, _("Name"),        COL_NAME);
+	folder_view_append_column (self, _("Last Commit"), COL_SUBJECT);
+	folder_view_append_column (self, _("Author"),      COL_AUTHOR);
+	folder_view_append_column (self, _("Date"),        COL_TIME);
+
+	gtk_tree_view_set_search_column (GTK_TREE_VIEW (self), COL_NAME);
+}
+
+static void
+folder_view_entry_resolved_cb (SbFolderLog * log,
+			       guint         index,
+			       SbFolderView* self)
+{
+	SbFolderEntry const* entry = sb_folder_log_get_entry (log, index);
+	GtkTreeIter          iter;
+
+	if (!gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (self->_private->store), &iter,
+					    NULL, index + self->_private->offset))
+	{
+		return;
+	}
+
+	gtk_list_store_set (self->_private->store, &iter,
+			    COL_SUBJECT, entry->subject,
+			    COL_AUTHOR,  entry->author,
+			    COL_TIME,    entry->time,
+			    -1);
+}
+
+static void
+folder_view_fill (SbFolderView* self)
+{
+	SbRepository* repository;
+	guint         i;
+
+	gtk_list_store_clear (self->_private->store);
+	self->_private->offset = 0;
+
+	repository = sb_repository_lookup (self->_private->folder);
+	if (repository && strcmp (sb_repository_get_toplevel (repository), self->_private->folder)) {
+		gtk_list_store_insert_with_values (self->_private->store, NULL, -1,
+						   COL_NAME,      "..",
+						   COL_IS_FOLDER, FALSE,
+						   -1);
+		self->_private->offset = 1;
+	}
+
+	for (i = 0; i < sb_folder_log_get_n_entries (self->_private->log); i++) {
+		SbFolderEntry const* entry = sb_folder_log_get_entry (self->_private->log, i);
+
+		gtk_list_store_insert_with_values (self->_private->store, NULL, -1,
+						   COL_NAME,      entry->name,
+						   COL_IS_FOLDER, entry->is_folder,
+						   COL_SUBJECT,   entry->subject,
+						   COL_AUTHOR,    entry->author,
+						   COL_TIME,      entry->time,
+						   -1);
+	}
+}
+
+static void
+folder_view_disconnect (SbFolderView* self)
+{
+	if (!self->_private->log) {
+		return;
+	}
+
+	g_signal_handlers_disconnect_matched (self->_private->log, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	g_object_unref (self->_private->log);
+	self->_private->log = NULL;
+}
+
+static void
+folder_view_row_activated (GtkTreeView      * view,
+			   GtkTreePath      * path,
+			   GtkTreeViewColumn* column)
+{
+	SbFolderView* self = SB_FOLDER_VIEW (view);
+	GtkTreeIter   iter;
+	gboolean      is_folder;
+	gchar       * name;
+	gchar       * target;
+
+	if (!gtk_tree_model_get_iter (GTK_TREE_MODEL (self->_private->store), &iter, path)) {
+		return;
+	}
+
+	gtk_tree_model_get (GTK_TREE_MODEL (self->_private->store), &iter,
+			    COL_NAME,      &name,
+			    COL_IS_FOLDER, &is_folder,
+			    -1);
+
+	if (self->_private->offset && gtk_tree_path_get_indices (path)[0] == 0) {
+		target = g_path_get_dirname (self->_private->folder);
+		sb_folder_view_set_folder (self, target);
+	} else if (is_folder) {
+		target = g_build_filename (self->_private->folder, name, NULL);
+		sb_folder_view_set_folder (self, target);
+	} else {
+		target = g_build_filename (self->_private->folder, name, NULL);
+		g_signal_emit (self, signals[FILE_ACTIVATED], 0, target);
+	}
+
+	g_free (target);
+	g_free (name);
+}
+
+static void
+folder_view_finalize (GObject* object)
+{
+	SbFolderView* self = SB_FOLDER_VIEW (object);
+
+	folder_view_disconnect (self);
+	g_object_unref (self->_private->store);
+	g_free (self->_private->folder);
+
+	G_OBJECT_CLASS (sb_folder_view_parent_class)->finalize (object);
+}
+
+static void
+sb_folder_view_class_init (SbFolderViewClass* self_class)
+{
+	GObjectClass    * object_class    = G_OBJECT_CLASS (self_class);
+	GtkTreeViewClass* tree_view_class = GTK_TREE_VIEW_CLASS (self_class);
+
+	object_class->finalize = folder_view_finalize;
+
+	tree_view_class->row_activated = folder_view_row_activated;
+
+	signals[FILE_ACTIVATED] = g_signal_new ("file-activated",
+						SB_TYPE_FOLDER_VIEW,
+						G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbFolderViewClass, file_activated),
+						NULL, NULL,
+						g_cclosure_marshal_VOID__STRING,
+						G_TYPE_NONE, 1,
+						G_TYPE_STRING);
+
+	g_type_class_add_private (self_class, sizeof (SbFolderViewPrivate));
+}
+
+GtkWidget*
+sb_folder_view_new (void)
+{
+	return g_object_new (SB_TYPE_FOLDER_VIEW, NULL);
+}
+
+void
+sb_folder_view_set_folder (SbFolderView* self,
+			   gchar const * folder)
+{
+	SbFolderLog* log;
+
+	g_return_if_fail (SB_IS_FOLDER_VIEW (self));
+	g_return_if_fail (folder && g_path_is_absolute (folder));
+
+	log = sb_folder_log_lookup (folder);
+	if (self->_private->log == log && log && sb_folder_log_is_current (log)) {
+		return;
+	}
+
+	folder_view_disconnect (self);
+	if (self->_private->folder != folder) {
+		g_free (self->_private->folder);
+		self->_private->folder = g_strdup (folder);
+	}
+
+	if (!log) {
+		gtk_list_store_clear (self->_private->store);
+		return;
+	}
+
+	self->_private->log = g_object_ref (log);
+	g_signal_connect_swapped (log, "entries-listed",
+				  G_CALLBACK (folder_view_fill), self);
+	g_signal_connect (log, "entry-resolved",
+			  G_CALLBACK (folder_view_entry_resolved_cb), self);
+	folder_view_fill (self);
+}
+
+gchar const*
+sb_folder_view_get_folder (SbFolderView const* self)
+{
+	g_return_val_if_fail (SB_IS_FOLDER_VIEW (self), NULL);
+
+	return self->_private->folder;
+}
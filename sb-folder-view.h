@@ -0,0 +1,63 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_FOLDER_VIEW_H
+#define SB_FOLDER_VIEW_H
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _SbFolderView        SbFolderView;
+typedef struct _SbFolderViewPrivate SbFolderViewPrivate;
+typedef struct _SbFolderViewClass   SbFolderViewClass;
+
+#define SB_TYPE_FOLDER_VIEW         (sb_folder_view_get_type ())
+#define SB_FOLDER_VIEW(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_FOLDER_VIEW, SbFolderView))
+#define SB_FOLDER_VIEW_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_FOLDER_VIEW, SbFolderViewClass))
+#define SB_IS_FOLDER_VIEW(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_FOLDER_VIEW))
+#define SB_IS_FOLDER_VIEW_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_FOLDER_VIEW))
+#define SB_FOLDER_VIEW_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_FOLDER_VIEW, SbFolderViewClass))
+
+GType        sb_folder_view_get_type   (void);
+GtkWidget*   sb_folder_view_new        (void);
+void         sb_folder_view_set_folder (SbFolderView      * self,
+					gchar const       * folder);
+gchar const* sb_folder_view_get_folder (SbFolderView const* self);
+
+struct _SbFolderView {
+	GtkTreeView          base_instance;
+	SbFolderViewPrivate* _private;
+};
+
+struct _SbFolderViewClass {
+	GtkTreeViewClass     base_class;
+
+	/* signals */
+	void (*file_activated) (SbFolderView* self,
+				gchar const * path);
+};
+
+G_END_DECLS
+
+#endif /* !SB_FOLDER_VIEW_H */
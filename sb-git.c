@@ -0,0 +1,98 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-git.h"
+
+/* The git executable is looked up in $PATH once; commands are run as
+ * "git -C <toplevel> ..." (see sb-repository.c for finding the toplevel). */
+
+gchar const*
+sb_git_get_executable (void)
+{
+	static gchar* executable = NULL;
+
+	if (G_UNLIKELY (!executable)) {
+		executable = g_find_program_in_path ("git");
+
+		if (!executable) {
+			g_warning ("couldn't find git in $PATH");
+			executable = g_strdup ("/usr/bin/git");
+		}
+	}
+
+	return executable;
+}
+
+SbJob*
+sb_git_job_newv (gchar const       * toplevel,
+		 SbJobFlags          flags,
+		 gchar const* const* arguments)
+{
+	GPtrArray* argv = g_ptr_array_new ();
+	SbJob    * self;
+
+	g_return_val_if_fail (toplevel, NULL);
+	g_return_val_if_fail (arguments && arguments[0], NULL);
+
+	g_ptr_array_add (argv, (gpointer)sb_git_get_executable ());
+	g_ptr_array_add (argv, "-C");
+	g_ptr_array_add (argv, (gpointer)toplevel);
+	for (; *arguments; arguments++) {
+		g_ptr_array_add (argv, (gpointer)*arguments);
+	}
+	g_ptr_array_add (argv, NULL);
+
+	self = sb_job_new ((gchar const* const*)argv->pdata, flags);
+
+	g_ptr_array_free (argv, TRUE);
+
+	return self;
+}
+
+SbJob*
+sb_git_job_new (gchar const* toplevel,
+		SbJobFlags   flags,
+		gchar const* command,
+		...)
+{
+	GPtrArray  * arguments = g_ptr_array_new ();
+	gchar const* argument;
+	SbJob      * self;
+	va_list      argv;
+
+	g_ptr_array_add (arguments, (gpointer)command);
+
+	va_start (argv, command);
+	while ((argument = va_arg (argv, gchar const*))) {
+		g_ptr_array_add (arguments, (gpointer)argument);
+	}
+	va_end (argv);
+
+	g_ptr_array_add (arguments, NULL);
+
+	self = sb_git_job_newv (toplevel, flags, (gchar const* const*)arguments->pdata);
+
+	g_ptr_array_free (arguments, TRUE);
+
+	return self;
+}
@@ -0,0 +1,42 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_GIT_H
+#define SB_GIT_H
+
+#include "sb-job.h"
+
+G_BEGIN_DECLS
+
+gchar const* sb_git_get_executable (void);
+SbJob*       sb_git_job_new        (gchar const       * toplevel,
+				    SbJobFlags          flags,
+				    gchar const       * command,
+				    ...) G_GNUC_NULL_TERMINATED;
+SbJob*       sb_git_job_newv       (gchar const       * toplevel,
+				    SbJobFlags          flags,
+				    gchar const* const* arguments);
+
+G_END_DECLS
+
+#endif /* !SB_GIT_H */
@@ -0,0 +1,1210 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-history-loader.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "sb-git.h"
+#include "sb-settings.h"
+
+/* Runs "git blame --incremental" on one file and turns its porcelain
+ * output into SbReferences. The metadata of the revisions (author, dates,
+ * parents) goes straight into the repository's SbRevisionTable.
+ *
+ * With a viewport, large files get blamed in two steps: first the visible
+ * lines (with "-L"), then the lines that are still missing. When the
+ * viewport moves to lines that are still missing while the rest is being
+ * blamed, that blame gets cancelled (the hunks it delivered are final
+ * and stay) and the new viewport goes first.
+ *
+ * After a small change to the file, the hunks of the load before that
+ * outside of the change can be taken over (see
+ * sb_history_loader_set_base()); only the changed lines get blamed then.
+ * An edited text that isn't saved gets blamed with "--contents".
+ *
+ * The parser works on the lines as the reader hands them out: no
+ * splitting into vectors, no temporary objects for the lookups.
+ */
+
+/* enough for SHA-256 object names */
+#define MAX_NAME_LENGTH 64
+
+/* smaller files get blamed in one go */
+#define VIEWPORT_MIN_LINES 2000
+
+#define HAS_PREFIX(line, length, prefix) \
+	((length) >= sizeof (prefix) - 1 && !memcmp ((line), (prefix), sizeof (prefix) - 1))
+
+struct _SbHistoryLoaderPrivate {
+	gchar          * file_path;
+	guint            flags;
+	gboolean         background;
+	SbJobPriority    priority;
+	gchar          * commit;    /* NULL for the working copy */
+
+	/* the text to blame instead of the file */
+	gchar          * contents;
+	gsize            contents_length;
+	gchar          * contents_path;  /* a temporary copy for git */
+
+	/* the load of the file before @change, until its hunks are taken */
+	SbHistoryLoader* base;
+	SbHunk           change;
+	gboolean         incremental;
+	guint            finish_idle;
+
+	/* what the annotations were made from */
+	gchar          * head;
+	time_t           mtime;
+	off_t            size;
+	gdouble          runtime;  /* seconds of all the blames */
+
+	SbRepository   * repository;
+	SbRevisionTable* revisions;
+	gboolean         own_revisions; /* not in a repository */
+
+	SbJob          * job;
+	gboolean         in_viewport;   /* the job only blames job_lines */
+	SbLineRange      job_lines;
+	SbLineRange      viewport;      /* start == 0 if there's none */
+	guint            n_lines;       /* of the blamed text; 0 if unknown */
+	GArray         * pending;       /* SbLineRange not blamed yet; NULL for everything */
+
+	GList          * references;
+	GArray         * ids;           /* revisions of this file, each once */
+	GByteArray     * seen;          /* id => in ids */
+	GHashTable     * previous;      /* id => file name in the parent revision */
+	SbLineIndex    * lines;
+
+	/* the hunk being parsed */
+	SbReference    * reference;
+	guint            revision;
+
+	guint            done : 1;
+	guint            cancelled : 1;
+	guint            failed : 1;    /* some lines never got blamed */
+};
+
+enum {
+	PROGRESS,
+	PARTIAL,
+	DONE,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+G_DEFINE_TYPE (SbHistoryLoader, sb_history_loader, G_TYPE_OBJECT);
+
+static void
+sb_history_loader_init (SbHistoryLoader* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_HISTORY_LOADER,
+						      SbHistoryLoaderPrivate);
+
+	self->_private->ids      = g_array_new (FALSE, FALSE, sizeof (guint));
+	self->_private->seen     = g_byte_array_new ();
+	self->_private->previous = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+							  NULL, g_free);
+	self->_private->lines    = sb_line_index_new ();
+	self->_private->revision = SB_REVISION_NONE;
+}
+
+static void
+loader_disconnect (SbHistoryLoader* self)
+{
+	if (!self->_private->job) {
+		return;
+	}
+
+	if (sb_job_get_reader (self->_private->job)) {
+		g_signal_handlers_disconnect_matched (sb_job_get_reader (self->_private->job), G_SIGNAL_MATCH_DATA,
+						      0, 0, NULL, NULL, self);
+	}
+	g_signal_handlers_disconnect_matched (self->_private->job, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	g_object_unref (self->_private->job);
+	self->_private->job = NULL;
+}
+
+/* git is done with it */
+static void
+loader_remove_contents (SbHistoryLoader* self)
+{
+	if (!self->_private->contents_path) {
+		return;
+	}
+
+	g_unlink (self->_private->contents_path);
+	g_free (self->_private->contents_path);
+	self->_private->contents_path = NULL;
+}
+
+static void
+loader_finalize (GObject* object)
+{
+	SbHistoryLoader* self = SB_HISTORY_LOADER (object);
+
+	if (self->_private->finish_idle) {
+		g_source_remove (self->_private->finish_idle);
+	}
+	loader_remove_contents (self);
+	g_free (self->_private->contents);
+	if (self->_private->base) {
+		g_object_unref (self->_private->base);
+	}
+
+	if (self->_private->job && !sb_job_is_done (self->_private->job)) {
+		sb_job_cancel (self->_private->job);
+	}
+	loader_disconnect (self);
+
+	if (self->_private->reference) {
+		g_object_unref (self->_private->reference);
+	}
+	g_list_foreach (self->_private->references, (GFunc)g_object_unref, NULL);
+	g_list_free    (self->_private->references);
+
+	if (self->_private->pending) {
+		g_array_free (self->_private->pending, TRUE);
+	}
+	g_array_free         (self->_private->ids, TRUE);
+	g_byte_array_free    (self->_private->seen, TRUE);
+	g_hash_table_destroy (self->_private->previous);
+	if (self->_private->lines) {
+		sb_line_index_free (self->_private->lines);
+	}
+
+	if (self->_private->own_revisions) {
+		sb_revision_table_free (self->_private->revisions);
+	}
+	if (self->_private->repository) {
+		g_object_unref (self->_private->repository);
+	}
+	g_free (self->_private->file_path);
+	g_free (self->_private->commit);
+	g_free (self->_private->head);
+
+	G_OBJECT_CLASS (sb_history_loader_parent_class)->finalize (object);
+}
+
+static void
+sb_history_loader_class_init (SbHistoryLoaderClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = loader_finalize;
+
+	signals[PROGRESS] = g_signal_new ("progress",
+					  SB_TYPE_HISTORY_LOADER,
+					  G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbHistoryLoaderClass, progress),
+					  NULL, NULL,
+					  g_cclosure_marshal_VOID__UINT,
+					  G_TYPE_NONE, 1,
+					  G_TYPE_UINT);
+	signals[PARTIAL] = g_signal_new ("partial",
+					 SB_TYPE_HISTORY_LOADER,
+					 G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbHistoryLoaderClass, partial),
+					 NULL, NULL,
+					 g_cclosure_marshal_VOID__VOID,
+					 G_TYPE_NONE, 0);
+	signals[DONE] = g_signal_new ("done",
+				      SB_TYPE_HISTORY_LOADER,
+				      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbHistoryLoaderClass, done),
+				      NULL, NULL,
+				      g_cclosure_marshal_VOID__VOID,
+				      G_TYPE_NONE, 0);
+
+	g_type_class_add_private (self_class, sizeof (SbHistoryLoaderPrivate));
+}
+
+SbHistoryLoader*
+sb_history_loader_new (gchar const* file_path,
+		       guint        flags)
+{
+	SbHistoryLoader* self;
+	gchar          * folder;
+
+	g_return_val_if_fail (file_path && g_path_is_absolute (file_path), NULL);
+
+	self = g_object_new (SB_TYPE_HISTORY_LOADER, NULL);
+	self->_private->file_path = g_strdup (file_path);
+	self->_private->flags     = flags;
+
+	folder = g_path_get_dirname (file_path);
+	self->_private->repository = sb_repository_lookup (folder);
+	g_free (folder);
+
+	if (G_LIKELY (self->_private->repository)) {
+		g_object_ref (self->_private->repository);
+		self->_private->revisions = sb_repository_get_revisions (self->_private->repository);
+	} else {
+		self->_private->revisions     = sb_revision_table_new ();
+		self->_private->own_revisions = TRUE;
+	}
+
+	return self;
+}
+
+/* copies the object name at the start of @line into @name; returns the
+ * position after it */
+static gchar const*
+loader_read_name (gchar const* line,
+		  gsize        length,
+		  gchar      * name)
+{
+	gchar const* end = memchr (line, ' ', length);
+	gsize        name_length = end ? (gsize)(end - line) : length;
+
+	if (G_UNLIKELY (name_length == 0 || name_length > MAX_NAME_LENGTH)) {
+		return NULL;
+	}
+
+	memcpy (name, line, name_length);
+	name[name_length] = '\0';
+
+	return line + name_length;
+}
+
+/* whether @revision is new to this file */
+static gboolean
+loader_see (SbHistoryLoader* self,
+	    guint            revision)
+{
+	if (self->_private->seen->len <= revision) {
+		guint length = self->_private->seen->len;
+
+		/* g_byte_array_set_size() doesn't clear */
+		g_byte_array_set_size (self->_private->seen, revision + 1);
+		memset (self->_private->seen->data + length, 0, self->_private->seen->len - length);
+	}
+
+	if (self->_private->seen->data[revision]) {
+		return FALSE;
+	}
+
+	self->_private->seen->data[revision] = TRUE;
+	g_array_append_val (self->_private->ids, revision);
+
+	return TRUE;
+}
+
+/* "<sha1> <sourceline> <resultline> <num_lines>", see git-blame (1) */
+static void
+loader_parse_header (SbHistoryLoader* self,
+		     gchar const    * line,
+		     gsize            length)
+{
+	gchar        name[MAX_NAME_LENGTH + 1];
+	gchar const* numbers = loader_read_name (line, length, name);
+	gchar      * end;
+	guint        original;
+	guint        result;
+	guint        n_lines;
+	gchar const* previous;
+
+	if (G_UNLIKELY (!numbers)) {
+		g_warning ("unexpected blame output: %s", line);
+		return;
+	}
+
+	original = strtoul (numbers, &end, 10);
+	result   = strtoul (end, &end, 10);
+	n_lines  = strtoul (end, &end, 10);
+
+	self->_private->revision  = sb_revision_table_intern (self->_private->revisions, name);
+	self->_private->reference = sb_reference_new (sb_revision_table_get_revision (self->_private->revisions,
+										      self->_private->revision),
+						      result,
+						      result + n_lines - 1);
+	sb_reference_set_original_start (self->_private->reference, original);
+
+	if (!loader_see (self, self->_private->revision)) {
+		/* the headers only come with the first hunk of a revision */
+		previous = g_hash_table_lookup (self->_private->previous,
+						GUINT_TO_POINTER (self->_private->revision));
+		if (previous) {
+			guint parent = sb_revision_table_get_previous (self->_private->revisions,
+								       self->_private->revision);
+			sb_reference_set_previous (self->_private->reference,
+						   sb_revision_table_get_revision (self->_private->revisions, parent),
+						   previous);
+		}
+	}
+
+	g_signal_emit (self, signals[PROGRESS], 0, n_lines);
+}
+
+/* "previous <sha1> <filename>" */
+static void
+loader_parse_previous (SbHistoryLoader* self,
+		       gchar const    * line,
+		       gsize            length)
+{
+	gchar        name[MAX_NAME_LENGTH + 1];
+	gchar const* filename = loader_read_name (line, length, name);
+	guint        parent;
+
+	if (G_UNLIKELY (!filename || *filename != ' ')) {
+		return;
+	}
+	filename++;
+
+	parent = sb_revision_table_intern (self->_private->revisions, name);
+	sb_revision_table_set_previous (self->_private->revisions,
+					self->_private->revision,
+					parent);
+	g_hash_table_insert (self->_private->previous,
+			     GUINT_TO_POINTER (self->_private->revision),
+			     g_strdup (filename));
+
+	sb_reference_set_previous (self->_private->reference,
+				   sb_revision_table_get_revision (self->_private->revisions, parent),
+				   filename);
+}
+
+/* the lines from @start to @end are blamed */
+static void
+loader_cover (SbHistoryLoader* self,
+	      guint            start,
+	      guint            end)
+{
+	GArray* pending = self->_private->pending;
+	guint   i;
+
+	for (i = 0; pending && i < pending->len; i++) {
+		SbLineRange* range = &g_array_index (pending, SbLineRange, i);
+
+		if (range->end < start || range->start > end) {
+			continue;
+		}
+
+		if (range->start >= start && range->end <= end) {
+			g_array_remove_index (pending, i--);
+		} else if (range->start < start && range->end > end) {
+			SbLineRange tail = {end + 1, range->end};
+
+			range->end = start - 1;
+			g_array_insert_val (pending, i + 1, tail);
+			break;
+		} else if (range->start < start) {
+			range->end = start - 1;
+		} else {
+			range->start = end + 1;
+		}
+	}
+}
+
+/* takes @reference */
+static void
+loader_add_reference (SbHistoryLoader* self,
+		      SbReference    * reference,
+		      guint            revision)
+{
+	sb_line_index_add (self->_private->lines,
+			   revision,
+			   sb_revision_table_get_author (self->_private->revisions, revision),
+			   sb_reference_get_current_start (reference),
+			   sb_reference_get_current_end (reference));
+	loader_cover (self,
+		      sb_reference_get_current_start (reference),
+		      sb_reference_get_current_end (reference));
+	self->_private->references = g_list_prepend (self->_private->references,
+						     reference);
+}
+
+static void
+loader_parse_line (SbHistoryLoader* self,
+		   gchar const    * line,
+		   gsize            length)
+{
+	SbRevisionTable* revisions = self->_private->revisions;
+	guint            revision  = self->_private->revision;
+
+	if (G_UNLIKELY (!self->_private->reference)) {
+		loader_parse_header (self, line, length);
+		return;
+	}
+
+	switch (line[0]) {
+	case 'a':
+		if (HAS_PREFIX (line, length, "author ")) {
+			sb_revision_table_set_author (revisions, revision, line + 7);
+		} else if (HAS_PREFIX (line, length, "author-time ")) {
+			sb_revision_table_set_author_time (revisions, revision,
+							   g_ascii_strtoll (line + 12, NULL, 10));
+		}
+		break;
+	case 'c':
+		if (HAS_PREFIX (line, length, "committer-time ")) {
+			sb_revision_table_set_committer_time (revisions, revision,
+							      g_ascii_strtoll (line + 15, NULL, 10));
+		}
+		break;
+	case 's':
+		if (HAS_PREFIX (line, length, "summary ")) {
+			sb_revision_set_summary (sb_revision_table_get_revision (revisions, revision),
+						 line + 8);
+		}
+		break;
+	case 'p':
+		if (HAS_PREFIX (line, length, "previous ")) {
+			loader_parse_previous (self, line + 9, length - 9);
+		}
+		break;
+	case 'f':
+		if (HAS_PREFIX (line, length, "filename ")) {
+			/* the last line of every hunk */
+			sb_reference_set_filename (self->_private->reference, line + 9);
+			loader_add_reference (self, self->_private->reference, revision);
+			self->_private->reference = NULL;
+			self->_private->revision  = SB_REVISION_NONE;
+		}
+		break;
+	default:
+		/* author-mail, author-tz, committer, committer-mail,
+		 * committer-tz, boundary */
+		break;
+	}
+}
+
+static void
+loader_read_lines_cb (SbAsyncReader    * reader,
+		      SbLineBatch const* batch,
+		      SbHistoryLoader  * self)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_lines; i++) {
+		if (G_LIKELY (batch->lengths[i])) {
+			loader_parse_line (self, batch->lines[i], batch->lengths[i]);
+		}
+	}
+}
+
+static gint
+sort_refs_by_target_line (gconstpointer a,
+			  gconstpointer b)
+{
+	return sb_reference_get_current_start (a) - sb_reference_get_current_start (b);
+}
+
+/* a cancelled job can leave a hunk behind */
+static void
+loader_drop_hunk (SbHistoryLoader* self)
+{
+	if (self->_private->reference) {
+		g_object_unref (self->_private->reference);
+		self->_private->reference = NULL;
+	}
+	self->_private->revision = SB_REVISION_NONE;
+}
+
+static void
+loader_finish (SbHistoryLoader* self)
+{
+	loader_remove_contents (self);
+
+	self->_private->references = g_list_sort (self->_private->references,
+						  sort_refs_by_target_line);
+	self->_private->done = TRUE;
+
+	g_object_ref (self);
+	g_signal_emit (self, signals[DONE], 0);
+	g_object_unref (self);
+}
+
+/* appends the "-L" options for the pending lines within @first and @last */
+static void
+loader_add_ranges (SbHistoryLoader* self,
+		   GPtrArray      * argv,
+		   GPtrArray      * strings,
+		   guint            first,
+		   guint            last)
+{
+	guint i;
+
+	for (i = 0; i < self->_private->pending->len; i++) {
+		SbLineRange const* range = &g_array_index (self->_private->pending, SbLineRange, i);
+		gchar            * option;
+
+		if (range->end < first || range->start > last) {
+			continue;
+		}
+
+		option = g_strdup_printf ("%u,%u", MAX (range->start, first), MIN (range->end, last));
+		g_ptr_array_add (strings, option);
+		g_ptr_array_add (argv, "-L");
+		g_ptr_array_add (argv, option);
+	}
+}
+
+static gboolean
+loader_viewport_pending (SbHistoryLoader const* self)
+{
+	guint i;
+
+	if (!self->_private->pending || !self->_private->viewport.start) {
+		return FALSE;
+	}
+
+	for (i = 0; i < self->_private->pending->len; i++) {
+		SbLineRange const* range = &g_array_index (self->_private->pending, SbLineRange, i);
+
+		if (range->start <= self->_private->viewport.end && range->end >= self->_private->viewport.start) {
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+static void loader_job_done_cb (SbHistoryLoader* self,
+				SbJob          * job);
+
+/* starts the next blame: the pending lines of the viewport, else all the
+ * pending lines (or the whole file) */
+static gboolean
+loader_run (SbHistoryLoader* self,
+	    GError         **error)
+{
+	gchar      * working_folder = NULL;
+	gchar const* toplevel;
+	gchar const* path;
+	GPtrArray  * argv = g_ptr_array_new ();
+	GPtrArray  * strings = g_ptr_array_new ();
+
+	if (G_LIKELY (self->_private->repository)) {
+		toplevel = sb_repository_get_toplevel (self->_private->repository);
+		path = sb_repository_get_relative_path (self->_private->repository, self->_private->file_path);
+	} else {
+		/* not in a repository, let git complain about it */
+		working_folder = g_path_get_dirname (self->_private->file_path);
+		toplevel = working_folder;
+		path = self->_private->file_path + strlen (working_folder) + 1;
+	}
+
+	g_ptr_array_add (argv, "blame");
+	g_ptr_array_add (argv, "--incremental");
+
+	if (self->_private->flags & SB_SETTINGS_FOLLOW_MOVES) {
+		g_ptr_array_add (argv, "-M");
+	}
+	if (self->_private->flags & SB_SETTINGS_FOLLOW_COPIES) {
+		g_ptr_array_add (argv, "-C");
+	}
+	if (self->_private->flags & SB_SETTINGS_IGNORE_WHITESPACES) {
+		g_ptr_array_add (argv, "-w");
+	}
+
+	self->_private->in_viewport = loader_viewport_pending (self);
+	if (self->_private->in_viewport) {
+		self->_private->job_lines = self->_private->viewport;
+		loader_add_ranges (self, argv, strings,
+				   self->_private->viewport.start,
+				   self->_private->viewport.end);
+	} else if (self->_private->pending) {
+		loader_add_ranges (self, argv, strings, 1, G_MAXUINT);
+	}
+
+	if (self->_private->contents_path) {
+		g_ptr_array_add (argv, "--contents");
+		g_ptr_array_add (argv, self->_private->contents_path);
+	}
+	if (self->_private->commit) {
+		g_ptr_array_add (argv, self->_private->commit);
+	}
+	g_ptr_array_add (argv, "--");
+	g_ptr_array_add (argv, (gpointer)path);
+	g_ptr_array_add (argv, NULL);
+
+	self->_private->job = sb_git_job_newv (toplevel, 0, (gchar const* const*)argv->pdata);
+	sb_job_set_priority (self->_private->job, self->_private->priority);
+	g_free (working_folder);
+	g_ptr_array_free (argv, TRUE);
+	g_ptr_array_foreach (strings, (GFunc)g_free, NULL);
+	g_ptr_array_free (strings, TRUE);
+
+	if (!sb_job_start (self->_private->job, error)) {
+		g_object_unref (self->_private->job);
+		self->_private->job = NULL;
+		return FALSE;
+	}
+
+	g_signal_connect (sb_job_get_reader (self->_private->job), "read-lines",
+			  G_CALLBACK (loader_read_lines_cb), self);
+	g_signal_connect_swapped (self->_private->job, "done",
+				  G_CALLBACK (loader_job_done_cb), self);
+
+	return TRUE;
+}
+
+static void
+loader_job_done_cb (SbHistoryLoader* self,
+		    SbJob          * job)
+{
+	gboolean failed = sb_job_get_exit_status (job) != 0;
+	GError * error = NULL;
+
+	if (failed && !self->_private->background) {
+		// FIXME: report the error to the user
+		g_warning ("git blame failed for %s", self->_private->file_path);
+	}
+
+	self->_private->runtime += sb_job_get_runtime (job);
+	self->_private->failed  |= failed;
+
+	loader_disconnect (self);
+	loader_drop_hunk (self);
+
+	if (!failed && self->_private->in_viewport) {
+		/* whatever git didn't report won't come with another try */
+		loader_cover (self, self->_private->job_lines.start, self->_private->job_lines.end);
+	}
+
+	if (!failed && self->_private->in_viewport && self->_private->pending->len) {
+		self->_private->references = g_list_sort (self->_private->references,
+							  sort_refs_by_target_line);
+		g_signal_emit (self, signals[PARTIAL], 0);
+
+		if (loader_run (self, &error)) {
+			return;
+		}
+
+		g_warning ("couldn't continue git blame: %s", error->message);
+		g_error_free (error);
+		self->_private->failed = TRUE;
+	}
+
+	loader_finish (self);
+}
+
+static gboolean
+loader_stat (SbHistoryLoader const* self,
+	     struct stat          * buf)
+{
+	return g_stat (self->_private->file_path, buf) == 0;
+}
+
+/* the number of lines as git counts them */
+guint
+sb_history_loader_count_lines (gchar const* contents,
+			       gsize        length)
+{
+	gchar const* end    = contents + length;
+	guint        result = 0;
+
+	for (; contents < end && (contents = memchr (contents, '\n', end - contents)); contents++) {
+		result++;
+	}
+	if (length && end[-1] != '\n') {
+		result++;
+	}
+
+	return result;
+}
+
+static guint
+loader_count_lines (SbHistoryLoader const* self)
+{
+	GMappedFile* file;
+	guint        result;
+
+	if (self->_private->n_lines) {
+		return self->_private->n_lines;
+	}
+
+	if (self->_private->contents) {
+		return sb_history_loader_count_lines (self->_private->contents,
+						      self->_private->contents_length);
+	}
+
+	if (self->_private->commit) {
+		/* the working copy says nothing about the lines in the past */
+		return 0;
+	}
+
+	file = g_mapped_file_new (self->_private->file_path, FALSE, NULL);
+	if (!file) {
+		return 0;
+	}
+
+	result = sb_history_loader_count_lines (g_mapped_file_get_contents (file),
+						g_mapped_file_get_length (file));
+	g_mapped_file_free (file);
+
+	return result;
+}
+
+static gboolean
+loader_write_contents (SbHistoryLoader* self,
+		       GError         **error)
+{
+	gchar  * path;
+	gboolean result;
+	gint     fd;
+
+	fd = g_file_open_tmp ("source-browser-XXXXXX", &path, error);
+	if (fd < 0) {
+		return FALSE;
+	}
+	close (fd);
+
+	result = g_file_set_contents (path,
+				      self->_private->contents,
+				      self->_private->contents_length,
+				      error);
+	if (!result) {
+		g_unlink (path);
+		g_free (path);
+		return FALSE;
+	}
+
+	self->_private->contents_path = path;
+
+	return TRUE;
+}
+
+/* the lines from @start to @end of @reference in the base, moved by @shift */
+static void
+loader_take_lines (SbHistoryLoader  * self,
+		   SbReference const* reference,
+		   guint              start,
+		   guint              end,
+		   gint               shift)
+{
+	SbRevision * revision = sb_reference_get_revision (reference);
+	SbReference* result;
+	guint        id;
+
+	if (start > end) {
+		return;
+	}
+
+	id = sb_revision_table_intern (self->_private->revisions, sb_revision_get_name (revision));
+	result = sb_reference_new (revision, start + shift, end + shift);
+	sb_reference_set_original_start (result,
+					 sb_reference_get_original_start (reference) +
+					 start - sb_reference_get_current_start (reference));
+	sb_reference_set_filename (result, sb_reference_get_filename (reference));
+
+	if (sb_reference_get_previous (reference)) {
+		sb_reference_set_previous (result,
+					   sb_reference_get_previous (reference),
+					   sb_reference_get_previous_filename (reference));
+		if (!g_hash_table_lookup (self->_private->previous, GUINT_TO_POINTER (id))) {
+			g_hash_table_insert (self->_private->previous,
+					     GUINT_TO_POINTER (id),
+					     g_strdup (sb_reference_get_previous_filename (reference)));
+		}
+	}
+
+	loader_see (self, id);
+	loader_add_reference (self, result, id);
+}
+
+/* the hunks of the base outside of the change, in the lines of the new text */
+static void
+loader_take_base (SbHistoryLoader* self)
+{
+	SbHunk const* change = &self->_private->change;
+	gint          shift  = (gint)change->new_count - (gint)change->old_count;
+	/* the old lines before and after the change; an addition comes after
+	 * its start line */
+	guint         last_before = change->old_count ? change->old_start - 1 : change->old_start;
+	guint         first_after = change->old_start + change->old_count + (change->old_count ? 0 : 1);
+	GList       * iter;
+
+	for (iter = sb_history_loader_get_references (self->_private->base); iter; iter = iter->next) {
+		guint start = sb_reference_get_current_start (iter->data);
+		guint end   = sb_reference_get_current_end (iter->data);
+
+		loader_take_lines (self, iter->data, start, MIN (end, last_before), 0);
+		loader_take_lines (self, iter->data, MAX (start, first_after), end, shift);
+	}
+
+	self->_private->references = g_list_sort (self->_private->references,
+						  sort_refs_by_target_line);
+
+	/* loads on top of loads mustn't keep each other */
+	g_object_unref (self->_private->base);
+	self->_private->base        = NULL;
+	self->_private->incremental = TRUE;
+}
+
+static gboolean
+loader_finish_idle_cb (gpointer data)
+{
+	SbHistoryLoader* self = SB_HISTORY_LOADER (data);
+
+	self->_private->finish_idle = 0;
+	loader_finish (self);
+
+	return FALSE;
+}
+
+gboolean
+sb_history_loader_start (SbHistoryLoader* self,
+			 GError         **error)
+{
+	struct stat buf;
+
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), FALSE);
+	g_return_val_if_fail (!self->_private->job && !self->_private->done, FALSE);
+
+	if (loader_stat (self, &buf)) {
+		self->_private->mtime = buf.st_mtime;
+		self->_private->size  = buf.st_size;
+	}
+	if (self->_private->repository) {
+		self->_private->head = g_strdup (sb_repository_get_head (self->_private->repository));
+	}
+
+	if (self->_private->contents && !loader_write_contents (self, error)) {
+		return FALSE;
+	}
+
+	if (self->_private->base) {
+		SbLineRange all = {1, loader_count_lines (self)};
+
+		self->_private->pending = g_array_new (FALSE, FALSE, sizeof (SbLineRange));
+		if (all.end) {
+			g_array_append_val (self->_private->pending, all);
+		}
+		loader_take_base (self);
+
+		if (!self->_private->pending->len) {
+			/* only lines went away; "done" mustn't come before start() returns */
+			self->_private->finish_idle = g_idle_add (loader_finish_idle_cb, self);
+			return TRUE;
+		}
+	} else if (self->_private->viewport.start) {
+		guint n_lines = loader_count_lines (self);
+
+		if (n_lines > VIEWPORT_MIN_LINES) {
+			SbLineRange all = {1, n_lines};
+
+			self->_private->pending = g_array_new (FALSE, FALSE, sizeof (SbLineRange));
+			g_array_append_val (self->_private->pending, all);
+		}
+	}
+
+	return loader_run (self, error);
+}
+
+/* the lines on screen (from 1, inclusive); they get blamed first, also
+ * when the viewport changes during the load */
+void
+sb_history_loader_set_viewport (SbHistoryLoader* self,
+				guint            first,
+				guint            last)
+{
+	GError* error = NULL;
+
+	g_return_if_fail (SB_IS_HISTORY_LOADER (self));
+	g_return_if_fail (first && first <= last);
+
+	self->_private->viewport.start = first;
+	self->_private->viewport.end   = last;
+
+	if (!self->_private->job || self->_private->in_viewport || !loader_viewport_pending (self)) {
+		/* not started, done, or the next job follows the viewport anyway */
+		return;
+	}
+
+	/* the rest can wait */
+	sb_job_cancel (self->_private->job);
+	loader_disconnect (self);
+	loader_drop_hunk (self);
+
+	if (!loader_run (self, &error)) {
+		g_warning ("couldn't restart git blame: %s", error->message);
+		g_error_free (error);
+		self->_private->failed = TRUE;
+		loader_finish (self);
+	}
+}
+
+/* the number of lines of the blamed text (see
+ * sb_history_loader_count_lines()); the viewport of a past revision needs
+ * it, because the "-L" ranges must not go beyond its end */
+void
+sb_history_loader_set_n_lines (SbHistoryLoader* self,
+			       guint            n_lines)
+{
+	g_return_if_fail (SB_IS_HISTORY_LOADER (self));
+	g_return_if_fail (!self->_private->job && !self->_private->done);
+
+	self->_private->n_lines = n_lines;
+}
+
+/* blames @contents (e.g. the edited text) instead of the file */
+void
+sb_history_loader_set_contents (SbHistoryLoader* self,
+				gchar const    * contents,
+				gsize            length)
+{
+	g_return_if_fail (SB_IS_HISTORY_LOADER (self));
+	g_return_if_fail (!self->_private->job && !self->_private->done);
+	g_return_if_fail (contents || !length);
+
+	g_free (self->_private->contents);
+	self->_private->contents        = g_malloc (length + 1);
+	self->_private->contents_length = length;
+	memcpy (self->_private->contents, contents, length);
+	self->_private->contents[length] = '\0';
+}
+
+/* takes over the hunks of @base (a finished load of the file before
+ * @change, with the same settings) outside of @change; only the lines the
+ * change added get blamed then */
+void
+sb_history_loader_set_base (SbHistoryLoader* self,
+			    SbHistoryLoader* base,
+			    SbHunk const   * change)
+{
+	g_return_if_fail (SB_IS_HISTORY_LOADER (self));
+	g_return_if_fail (!self->_private->job && !self->_private->done);
+	g_return_if_fail (SB_IS_HISTORY_LOADER (base) && sb_history_loader_is_done (base));
+	g_return_if_fail (change);
+
+	if (self->_private->base) {
+		g_object_unref (self->_private->base);
+	}
+	self->_private->base   = g_object_ref (base);
+	self->_private->change = *change;
+}
+
+void
+sb_history_loader_cancel (SbHistoryLoader* self)
+{
+	g_return_if_fail (SB_IS_HISTORY_LOADER (self));
+
+	if (!self->_private->job) {
+		return;
+	}
+
+	self->_private->cancelled = TRUE;
+	sb_job_cancel (self->_private->job);
+	loader_disconnect (self);
+}
+
+/* for speculative loads: at the lowest priority and without complaints */
+void
+sb_history_loader_set_background (SbHistoryLoader* self,
+				  gboolean         background)
+{
+	g_return_if_fail (SB_IS_HISTORY_LOADER (self));
+	g_return_if_fail (!self->_private->job && !self->_private->done);
+
+	self->_private->background = background;
+	self->_private->priority   = background ? SB_JOB_PRIORITY_PREFETCH : SB_JOB_PRIORITY_VISIBLE;
+}
+
+/* blames the file as it was in @revision instead of the working copy;
+ * the file doesn't need to exist anymore */
+void
+sb_history_loader_set_revision (SbHistoryLoader* self,
+				gchar const    * revision)
+{
+	g_return_if_fail (SB_IS_HISTORY_LOADER (self));
+	g_return_if_fail (!self->_private->job && !self->_private->done);
+
+	g_free (self->_private->commit);
+	self->_private->commit = g_strdup (revision);
+}
+
+/* for background loads which matter even less than prefetching */
+void
+sb_history_loader_set_priority (SbHistoryLoader* self,
+				SbJobPriority    priority)
+{
+	g_return_if_fail (SB_IS_HISTORY_LOADER (self));
+	g_return_if_fail (!self->_private->job && !self->_private->done);
+
+	self->_private->priority = priority;
+}
+
+gboolean
+sb_history_loader_is_done (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), FALSE);
+
+	return self->_private->done;
+}
+
+/* whether neither the file nor the history changed since the start */
+gboolean
+sb_history_loader_is_current (SbHistoryLoader const* self)
+{
+	struct stat buf;
+
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), FALSE);
+
+	if (self->_private->commit) {
+		/* the past doesn't change */
+		return TRUE;
+	}
+
+	if (!loader_stat (self, &buf) ||
+	    buf.st_mtime != self->_private->mtime ||
+	    buf.st_size  != self->_private->size)
+	{
+		return FALSE;
+	}
+
+	return !self->_private->repository ||
+	       !g_strcmp0 (sb_repository_get_head (self->_private->repository), self->_private->head);
+}
+
+/* whether git blame failed for some of the lines; such a load is shown,
+ * but not kept */
+gboolean
+sb_history_loader_has_failed (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), TRUE);
+
+	return self->_private->failed;
+}
+
+gchar const*
+sb_history_loader_get_file_path (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), NULL);
+
+	return self->_private->file_path;
+}
+
+guint
+sb_history_loader_get_flags (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), 0);
+
+	return self->_private->flags;
+}
+
+/* NULL for the working copy */
+gchar const*
+sb_history_loader_get_revision (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), NULL);
+
+	return self->_private->commit;
+}
+
+/* NULL when the file got blamed */
+gchar const*
+sb_history_loader_get_contents (SbHistoryLoader const* self,
+				gsize                * length)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), NULL);
+
+	if (length) {
+		*length = self->_private->contents_length;
+	}
+
+	return self->_private->contents;
+}
+
+/* whether only the changed lines got blamed (see
+ * sb_history_loader_set_base()) */
+gboolean
+sb_history_loader_is_incremental (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), FALSE);
+
+	return self->_private->incremental;
+}
+
+gdouble
+sb_history_loader_get_runtime (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), 0.0);
+
+	return self->_private->runtime;
+}
+
+/* like sb_history_loader_get_runtime(), while the blame is running */
+gdouble
+sb_history_loader_get_elapsed (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), 0.0);
+
+	if (self->_private->job && !sb_job_is_done (self->_private->job)) {
+		return self->_private->runtime + sb_job_get_elapsed (self->_private->job);
+	}
+
+	return self->_private->runtime;
+}
+
+SbRepository*
+sb_history_loader_get_repository (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), NULL);
+
+	return self->_private->repository;
+}
+
+SbRevisionTable*
+sb_history_loader_get_revisions (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), NULL);
+
+	return self->_private->revisions;
+}
+
+/* sorted by the line numbers; only complete after "done" */
+GList*
+sb_history_loader_get_references (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), NULL);
+
+	return self->_private->references;
+}
+
+guint const*
+sb_history_loader_get_revision_ids (SbHistoryLoader const* self,
+				    guint                * n_ids)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), NULL);
+	g_return_val_if_fail (n_ids, NULL);
+
+	*n_ids = self->_private->ids->len;
+
+	return (guint const*)self->_private->ids->data;
+}
+
+/* the lines of every revision and author */
+SbLineIndex const*
+sb_history_loader_get_lines (SbHistoryLoader const* self)
+{
+	g_return_val_if_fail (SB_IS_HISTORY_LOADER (self), NULL);
+
+	return self->_private->lines;
+}
@@ -0,0 +1,107 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_HISTORY_LOADER_H
+#define SB_HISTORY_LOADER_H
+
+#include "sb-hunk.h"
+#include "sb-job.h"
+#include "sb-line-index.h"
+#include "sb-reference.h"
+#include "sb-repository.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbHistoryLoader        SbHistoryLoader;
+typedef struct _SbHistoryLoaderPrivate SbHistoryLoaderPrivate;
+typedef struct _SbHistoryLoaderClass   SbHistoryLoaderClass;
+
+#define SB_TYPE_HISTORY_LOADER         (sb_history_loader_get_type ())
+#define SB_HISTORY_LOADER(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_HISTORY_LOADER, SbHistoryLoader))
+#define SB_HISTORY_LOADER_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_HISTORY_LOADER, SbHistoryLoaderClass))
+#define SB_IS_HISTORY_LOADER(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_HISTORY_LOADER))
+#define SB_IS_HISTORY_LOADER_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_HISTORY_LOADER))
+#define SB_HISTORY_LOADER_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_HISTORY_LOADER, SbHistoryLoaderClass))
+
+GType              sb_history_loader_get_type         (void);
+SbHistoryLoader*   sb_history_loader_new              (gchar const          * file_path,
+						       guint                  flags);
+void               sb_history_loader_set_background   (SbHistoryLoader      * self,
+						       gboolean               background);
+void               sb_history_loader_set_revision     (SbHistoryLoader      * self,
+						       gchar const          * revision);
+void               sb_history_loader_set_priority     (SbHistoryLoader      * self,
+						       SbJobPriority          priority);
+void               sb_history_loader_set_viewport     (SbHistoryLoader      * self,
+						       guint                  first,
+						       guint                  last);
+void               sb_history_loader_set_n_lines      (SbHistoryLoader      * self,
+						       guint                  n_lines);
+void               sb_history_loader_set_contents     (SbHistoryLoader      * self,
+						       gchar const          * contents,
+						       gsize                  length);
+void               sb_history_loader_set_base         (SbHistoryLoader      * self,
+						       SbHistoryLoader      * base,
+						       SbHunk const         * change);
+gboolean           sb_history_loader_start            (SbHistoryLoader      * self,
+						       GError              ** error);
+void               sb_history_loader_cancel           (SbHistoryLoader      * self);
+gboolean           sb_history_loader_is_done          (SbHistoryLoader const* self);
+gboolean           sb_history_loader_is_current       (SbHistoryLoader const* self);
+gboolean           sb_history_loader_has_failed       (SbHistoryLoader const* self);
+gboolean           sb_history_loader_is_incremental   (SbHistoryLoader const* self);
+gchar const*       sb_history_loader_get_file_path    (SbHistoryLoader const* self);
+guint              sb_history_loader_get_flags        (SbHistoryLoader const* self);
+gchar const*       sb_history_loader_get_revision     (SbHistoryLoader const* self);
+gchar const*       sb_history_loader_get_contents     (SbHistoryLoader const* self,
+						       gsize                * length);
+gdouble            sb_history_loader_get_runtime      (SbHistoryLoader const* self);
+gdouble            sb_history_loader_get_elapsed      (SbHistoryLoader const* self);
+SbRepository*      sb_history_loader_get_repository   (SbHistoryLoader const* self);
+SbRevisionTable*   sb_history_loader_get_revisions    (SbHistoryLoader const* self);
+GList*             sb_history_loader_get_references   (SbHistoryLoader const* self);
+guint const*       sb_history_loader_get_revision_ids (SbHistoryLoader const* self,
+						       guint                * n_ids);
+SbLineIndex const* sb_history_loader_get_lines        (SbHistoryLoader const* self);
+
+guint              sb_history_loader_count_lines      (gchar const          * contents,
+						       gsize                  length);
+
+struct _SbHistoryLoader {
+	GObject                 base_instance;
+	SbHistoryLoaderPrivate* _private;
+};
+
+struct _SbHistoryLoaderClass {
+	GObjectClass            base_class;
+
+	/* signals */
+	void (*progress) (SbHistoryLoader* self,
+			  guint            n_lines);
+	void (*partial)  (SbHistoryLoader* self);
+	void (*done)     (SbHistoryLoader* self);
+};
+
+G_END_DECLS
+
+#endif /* !SB_HISTORY_LOADER_H */
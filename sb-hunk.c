@@ -0,0 +1,99 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-hunk.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* The hunk headers of "git diff -U0", for following lines from the new
+ * side of a diff to its old side.
+ */
+
+/* "@@ -old_start[,old_count] +new_start[,new_count] @@" */
+gboolean
+sb_hunk_parse (gchar const* line,
+	       SbHunk     * hunk)
+{
+	gchar* end;
+
+	g_return_val_if_fail (line && hunk, FALSE);
+
+	if (strncmp (line, "@@ -", 4)) {
+		return FALSE;
+	}
+
+	line = line + 4;
+	hunk->old_start = strtoul (line, &end, 10);
+	hunk->old_count = *end == ',' ? strtoul (end + 1, &end, 10) : 1;
+	if (strncmp (end, " +", 2)) {
+		return FALSE;
+	}
+
+	hunk->new_start = strtoul (end + 2, &end, 10);
+	hunk->new_count = *end == ',' ? strtoul (end + 1, &end, 10) : 1;
+
+	return TRUE;
+}
+
+/* the last line of the hunk on the new side; a deletion comes after its
+ * start line */
+guint
+sb_hunk_get_last (SbHunk const* hunk)
+{
+	g_return_val_if_fail (hunk, 0);
+
+	return hunk->new_count ? hunk->new_start + hunk->new_count - 1 : hunk->new_start;
+}
+
+/* where @line (from 1) of the new side was on the old side; @hunks are
+ * sorted by position. A changed line keeps its offset in the hunk; an
+ * added one goes to the last line the hunk replaced, or to the line it
+ * was added after. */
+guint
+sb_hunk_map_to_old (SbHunk const* hunks,
+		    guint         n_hunks,
+		    guint         line)
+{
+	gint  delta = 0;  /* new minus old lines of the hunks passed */
+	guint h;
+
+	g_return_val_if_fail (hunks || !n_hunks, line);
+
+	for (h = 0; h < n_hunks && sb_hunk_get_last (&hunks[h]) < line; h++) {
+		delta += (gint)hunks[h].new_count - (gint)hunks[h].old_count;
+	}
+
+	if (h < n_hunks && hunks[h].new_count && hunks[h].new_start <= line) {
+		SbHunk const* hunk   = &hunks[h];
+		guint         offset = line - hunk->new_start;
+
+		if (offset < hunk->old_count) {
+			return hunk->old_start + offset;
+		}
+
+		return MAX (hunk->old_count ? hunk->old_start + hunk->old_count - 1 : hunk->old_start, 1);
+	}
+
+	return MAX ((gint)line - delta, 1);
+}
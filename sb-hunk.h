@@ -0,0 +1,48 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_HUNK_H
+#define SB_HUNK_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* "@@ -old_start,old_count +new_start,new_count @@" of a unified diff */
+typedef struct {
+	guint old_start;
+	guint old_count;
+	guint new_start;
+	guint new_count;
+} SbHunk;
+
+gboolean sb_hunk_parse      (gchar const * line,
+			     SbHunk      * hunk);
+guint    sb_hunk_get_last   (SbHunk const* hunk);
+guint    sb_hunk_map_to_old (SbHunk const* hunks,
+			     guint         n_hunks,
+			     guint         line);
+
+G_END_DECLS
+
+#endif /* !SB_HUNK_H */
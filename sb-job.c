@@ -0,0 +1,553 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-job.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "sb-scheduler.h"
+
+/* An external process with its stdout read through an SbAsyncReader.
+ *
+ * Children are started with posix_spawn() (using vfork() semantics where
+ * the C library supports that), so starting a job doesn't copy the page
+ * tables of the whole application. The SbScheduler decides when that
+ * happens. Every job measures the time it waited for the scheduler and
+ * the time from the spawn to its first output and to its exit.
+ */
+
+extern char** environ;
+
+#define BACKGROUND_NICENESS 19
+
+struct _SbJobPrivate {
+	gchar        ** argv;
+	SbJobFlags      flags;
+	SbJobPriority   priority;
+
+	GPid            pid;
+	gint            in_fd;
+	gint            child_in;    /* the child's ends until the spawn */
+	gint            child_out;
+	SbAsyncReader * reader;
+	guint           child_watch;
+
+	GTimer        * timer;
+	gdouble         wait;
+	gdouble         stopped;     /* seconds of suspension, see sb_job_get_elapsed() */
+	gdouble         stopped_at;
+	gdouble         first_output;
+	gdouble         runtime;
+	gint            exit_status;
+
+	guint           started : 1;
+	guint           spawned : 1;
+	guint           suspended : 1;
+	guint           exited : 1;
+	guint           done : 1;
+	guint           cancelled : 1;
+};
+
+enum {
+	DONE,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+G_DEFINE_TYPE (SbJob, sb_job, G_TYPE_OBJECT);
+
+static void
+sb_job_init (SbJob* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_JOB,
+						      SbJobPrivate);
+
+	self->_private->in_fd        = -1;
+	self->_private->child_in     = -1;
+	self->_private->child_out    = -1;
+	self->_private->first_output = -1.0;
+	self->_private->runtime      = -1.0;
+	self->_private->timer        = g_timer_new ();
+}
+
+static void
+job_close_stdin (SbJob* self)
+{
+	if (self->_private->in_fd >= 0) {
+		close (self->_private->in_fd);
+		self->_private->in_fd = -1;
+	}
+}
+
+/* hands our ends of the child's pipes to nobody: the reader sees EOF */
+static void
+job_close_child_fds (SbJob* self)
+{
+	if (self->_private->child_out >= 0) {
+		close (self->_private->child_out);
+		self->_private->child_out = -1;
+	}
+	if (self->_private->child_in >= 0) {
+		close (self->_private->child_in);
+		self->_private->child_in = -1;
+	}
+}
+
+static void
+job_finalize (GObject* object)
+{
+	SbJob* self = SB_JOB (object);
+
+	if (self->_private->reader) {
+		g_signal_handlers_disconnect_matched (self->_private->reader, G_SIGNAL_MATCH_DATA,
+						      0, 0, NULL, NULL, self);
+		g_object_unref (self->_private->reader);
+	}
+	job_close_stdin (self);
+	job_close_child_fds (self);
+
+	g_strfreev      (self->_private->argv);
+	g_timer_destroy (self->_private->timer);
+
+	G_OBJECT_CLASS (sb_job_parent_class)->finalize (object);
+}
+
+static void
+sb_job_class_init (SbJobClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = job_finalize;
+
+	signals[DONE] = g_signal_new ("done",
+				      SB_TYPE_JOB,
+				      G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbJobClass, done),
+				      NULL, NULL,
+				      g_cclosure_marshal_VOID__VOID,
+				      G_TYPE_NONE, 0);
+
+	g_type_class_add_private (self_class, sizeof (SbJobPrivate));
+}
+
+SbJob*
+sb_job_new (gchar const* const* argv,
+	    SbJobFlags          flags)
+{
+	SbJob* self;
+
+	g_return_val_if_fail (argv && argv[0], NULL);
+	g_return_val_if_fail (g_path_is_absolute (argv[0]), NULL);
+
+	self = g_object_new (SB_TYPE_JOB, NULL);
+	self->_private->argv  = g_strdupv ((gchar**)argv);
+	self->_private->flags = flags;
+
+	return self;
+}
+
+static void
+job_check_done (SbJob* self)
+{
+	if (self->_private->done ||
+	    !self->_private->exited ||
+	    !sb_async_reader_is_done (self->_private->reader))
+	{
+		return;
+	}
+
+	self->_private->runtime = sb_job_get_elapsed (self);
+	self->_private->done    = TRUE;
+
+	/* the handlers might drop the last reference */
+	g_object_ref (self);
+	g_signal_emit (self, signals[DONE], 0);
+	g_object_unref (self);
+}
+
+static void
+job_read_lines_cb (SbAsyncReader    * reader,
+		   SbLineBatch const* batch,
+		   SbJob            * self)
+{
+	if (G_UNLIKELY (self->_private->first_output < 0.0)) {
+		self->_private->first_output = g_timer_elapsed (self->_private->timer, NULL) - self->_private->wait;
+	}
+}
+
+static void
+job_reader_done_cb (SbAsyncReader* reader,
+		    SbJob        * self)
+{
+	job_check_done (self);
+}
+
+static void
+job_child_watch_cb (GPid     pid,
+		    gint     status,
+		    gpointer data)
+{
+	SbJob* self = SB_JOB (data);
+
+	g_spawn_close_pid (pid);
+
+	self->_private->child_watch = 0;
+	self->_private->exit_status = status;
+	self->_private->exited      = TRUE;
+
+	job_close_stdin (self);
+	job_check_done (self);
+}
+
+static inline gboolean
+pipe_cloexec (gint   fds[2],
+	      GError**error)
+{
+	if (pipe (fds) < 0) {
+		g_set_error (error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED,
+			     "couldn't create a pipe: %s", g_strerror (errno));
+		return FALSE;
+	}
+
+	/* don't leak our ends into other children (that would break EOF
+	 * detection); dup2() in the child clears the flag again */
+	fcntl (fds[0], F_SETFD, FD_CLOEXEC);
+	fcntl (fds[1], F_SETFD, FD_CLOEXEC);
+
+	return TRUE;
+}
+
+gboolean
+sb_job_start (SbJob  * self,
+	      GError **error)
+{
+	gint out_fds[2];
+	gint in_fds[2] = {-1, -1};
+
+	g_return_val_if_fail (SB_IS_JOB (self), FALSE);
+	g_return_val_if_fail (!self->_private->started, FALSE);
+
+	if (!pipe_cloexec (out_fds, error)) {
+		return FALSE;
+	}
+	if ((self->_private->flags & SB_JOB_PIPE_STDIN) && !pipe_cloexec (in_fds, error)) {
+		close (out_fds[0]);
+		close (out_fds[1]);
+		return FALSE;
+	}
+
+	self->_private->started    = TRUE;
+	self->_private->child_out  = out_fds[1];
+	self->_private->child_in   = in_fds[0];
+	self->_private->in_fd      = in_fds[1];
+	g_timer_start (self->_private->timer);
+
+	/* the reader exists from the start, so the output can be connected to
+	 * while the job waits for the scheduler */
+	self->_private->reader = sb_async_reader_new (out_fds[0]);
+	g_signal_connect (self->_private->reader, "read-lines",
+			  G_CALLBACK (job_read_lines_cb), self);
+	g_signal_connect (self->_private->reader, "done",
+			  G_CALLBACK (job_reader_done_cb), self);
+
+	/* co-processes wait for requests most of the time, they don't take
+	 * a slot */
+	if (self->_private->flags & SB_JOB_PIPE_STDIN) {
+		return sb_job_spawn (self, error);
+	}
+
+	return sb_scheduler_submit (self, error);
+}
+
+/* finish a job that never ran */
+static void
+job_abort (SbJob* self)
+{
+	job_close_child_fds (self);
+	job_close_stdin (self);
+
+	self->_private->exit_status = -1;
+	self->_private->exited      = TRUE;
+	job_check_done (self);
+}
+
+/* starts the process; only for sb_job_start() and the scheduler */
+gboolean
+sb_job_spawn (SbJob  * self,
+	      GError **error)
+{
+	posix_spawn_file_actions_t actions;
+	posix_spawnattr_t          attr;
+	sigset_t                   sigpipe;
+	pid_t                      pid;
+	gint                       result;
+
+	g_return_val_if_fail (SB_IS_JOB (self), FALSE);
+	g_return_val_if_fail (self->_private->started && !self->_private->spawned, FALSE);
+
+	self->_private->spawned = TRUE;
+	self->_private->wait    = g_timer_elapsed (self->_private->timer, NULL);
+
+	posix_spawn_file_actions_init (&actions);
+	posix_spawn_file_actions_adddup2 (&actions, self->_private->child_out, STDOUT_FILENO);
+	if (self->_private->child_in >= 0) {
+		posix_spawn_file_actions_adddup2 (&actions, self->_private->child_in, STDIN_FILENO);
+	} else {
+		posix_spawn_file_actions_addopen (&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+	}
+
+	/* we ignore SIGPIPE, the children shouldn't */
+	sigemptyset (&sigpipe);
+	sigaddset   (&sigpipe, SIGPIPE);
+
+	posix_spawnattr_init (&attr);
+	posix_spawnattr_setsigdefault (&attr, &sigpipe);
+#ifdef POSIX_SPAWN_USEVFORK
+	posix_spawnattr_setflags (&attr, POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_USEVFORK);
+#else
+	posix_spawnattr_setflags (&attr, POSIX_SPAWN_SETSIGDEF);
+#endif
+
+	result = posix_spawn (&pid,
+			      self->_private->argv[0],
+			      &actions,
+			      &attr,
+			      self->_private->argv,
+			      environ);
+
+	posix_spawnattr_destroy (&attr);
+	posix_spawn_file_actions_destroy (&actions);
+
+	if (result) {
+		g_set_error (error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED,
+			     "couldn't start \"%s\": %s",
+			     self->_private->argv[0],
+			     g_strerror (result));
+		job_abort (self);
+		return FALSE;
+	}
+
+	job_close_child_fds (self);
+	self->_private->pid = pid;
+
+	/* posix_spawn() can't do this; the child runs a few instructions at
+	 * our priority, and can't get back up without privileges */
+	if (self->_private->priority >= SB_JOB_PRIORITY_PREFETCH) {
+		setpriority (PRIO_PROCESS, pid, BACKGROUND_NICENESS);
+	}
+
+	/* keep the job alive until the child is gone */
+	self->_private->child_watch = g_child_watch_add_full (G_PRIORITY_DEFAULT,
+							      pid,
+							      job_child_watch_cb,
+							      g_object_ref (self),
+							      g_object_unref);
+
+	return TRUE;
+}
+
+/* stop the process without losing its work, for more important jobs */
+void
+sb_job_suspend (SbJob* self)
+{
+	g_return_if_fail (SB_IS_JOB (self));
+	g_return_if_fail (self->_private->spawned);
+	g_return_if_fail (sb_job_can_suspend (self));
+
+	if (!self->_private->exited && !self->_private->suspended) {
+		kill (self->_private->pid, SIGSTOP);
+		self->_private->suspended  = TRUE;
+		self->_private->stopped_at = g_timer_elapsed (self->_private->timer, NULL);
+	}
+}
+
+void
+sb_job_resume (SbJob* self)
+{
+	g_return_if_fail (SB_IS_JOB (self));
+
+	if (self->_private->suspended) {
+		self->_private->suspended = FALSE;
+		self->_private->stopped  += g_timer_elapsed (self->_private->timer, NULL) - self->_private->stopped_at;
+		if (!self->_private->exited) {
+			kill (self->_private->pid, SIGCONT);
+		}
+	}
+}
+
+void
+sb_job_cancel (SbJob* self)
+{
+	g_return_if_fail (SB_IS_JOB (self));
+
+	if (self->_private->cancelled || self->_private->done) {
+		return;
+	}
+
+	self->_private->cancelled = TRUE;
+
+	if (!self->_private->started) {
+		return;
+	}
+
+	if (!self->_private->spawned) {
+		/* still waiting for the scheduler */
+		job_abort (self);
+	} else if (!self->_private->exited) {
+		kill (self->_private->pid, SIGTERM);
+		/* stopped processes only see the signal once they continue */
+		sb_job_resume (self);
+	}
+}
+
+void
+sb_job_set_priority (SbJob        * self,
+		     SbJobPriority  priority)
+{
+	g_return_if_fail (SB_IS_JOB (self));
+	g_return_if_fail (!self->_private->started);
+	g_return_if_fail (priority < SB_JOB_N_PRIORITIES);
+
+	self->_private->priority = priority;
+}
+
+SbJobPriority
+sb_job_get_priority (SbJob const* self)
+{
+	g_return_val_if_fail (SB_IS_JOB (self), SB_JOB_PRIORITY_VISIBLE);
+
+	return self->_private->priority;
+}
+
+SbAsyncReader*
+sb_job_get_reader (SbJob const* self)
+{
+	g_return_val_if_fail (SB_IS_JOB (self), NULL);
+
+	return self->_private->reader;
+}
+
+gint
+sb_job_get_stdin (SbJob const* self)
+{
+	g_return_val_if_fail (SB_IS_JOB (self), -1);
+
+	return self->_private->in_fd;
+}
+
+/* a stopped git mustn't keep other gits from the repository */
+gboolean
+sb_job_can_suspend (SbJob const* self)
+{
+	g_return_val_if_fail (SB_IS_JOB (self), FALSE);
+
+	return !(self->_private->flags & SB_JOB_NO_SUSPEND);
+}
+
+gboolean
+sb_job_is_running (SbJob const* self)
+{
+	g_return_val_if_fail (SB_IS_JOB (self), FALSE);
+
+	return self->_private->started && !self->_private->done;
+}
+
+gboolean
+sb_job_is_done (SbJob const* self)
+{
+	g_return_val_if_fail (SB_IS_JOB (self), FALSE);
+
+	return self->_private->done;
+}
+
+gboolean
+sb_job_is_cancelled (SbJob const* self)
+{
+	g_return_val_if_fail (SB_IS_JOB (self), FALSE);
+
+	return self->_private->cancelled;
+}
+
+gint
+sb_job_get_exit_status (SbJob const* self)
+{
+	g_return_val_if_fail (SB_IS_JOB (self), -1);
+
+	return self->_private->exit_status;
+}
+
+/* the time between sb_job_start() and the spawn */
+gdouble
+sb_job_get_wait (SbJob const* self)
+{
+	g_return_val_if_fail (SB_IS_JOB (self), -1.0);
+
+	return self->_private->wait;
+}
+
+gdouble
+sb_job_get_first_output (SbJob const* self)
+{
+	g_return_val_if_fail (SB_IS_JOB (self), -1.0);
+
+	return self->_private->first_output;
+}
+
+/* the seconds the process got to run so far: from the spawn on, without
+ * the time it was suspended for more important jobs */
+gdouble
+sb_job_get_elapsed (SbJob const* self)
+{
+	gdouble result;
+
+	g_return_val_if_fail (SB_IS_JOB (self), 0.0);
+
+	if (self->_private->done) {
+		return self->_private->runtime;
+	}
+	if (!self->_private->spawned) {
+		return 0.0;
+	}
+
+	result = g_timer_elapsed (self->_private->timer, NULL) - self->_private->wait - self->_private->stopped;
+	if (self->_private->suspended) {
+		result -= g_timer_elapsed (self->_private->timer, NULL) - self->_private->stopped_at;
+	}
+
+	return MAX (result, 0.0);
+}
+
+gdouble
+sb_job_get_runtime (SbJob const* self)
+{
+	g_return_val_if_fail (SB_IS_JOB (self), -1.0);
+
+	return self->_private->runtime;
+}
+
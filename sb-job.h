@@ -0,0 +1,95 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_JOB_H
+#define SB_JOB_H
+
+#include "sb-async-reader.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbJob        SbJob;
+typedef struct _SbJobPrivate SbJobPrivate;
+typedef struct _SbJobClass   SbJobClass;
+
+#define SB_TYPE_JOB         (sb_job_get_type ())
+#define SB_JOB(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_JOB, SbJob))
+#define SB_JOB_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_JOB, SbJobClass))
+#define SB_IS_JOB(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_JOB))
+#define SB_IS_JOB_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_JOB))
+#define SB_JOB_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_JOB, SbJobClass))
+
+typedef enum {
+	SB_JOB_PIPE_STDIN  = 1 << 0,
+	SB_JOB_NO_SUSPEND  = 1 << 1   /* holds locks of the repository, e.g. writes */
+} SbJobFlags;
+
+/* most important first; prefetching and indexing run niced */
+typedef enum {
+	SB_JOB_PRIORITY_VISIBLE,  /* the file on screen */
+	SB_JOB_PRIORITY_DETAILS,  /* metadata of the shown revisions */
+	SB_JOB_PRIORITY_PREFETCH,
+	SB_JOB_PRIORITY_INDEX,
+	SB_JOB_N_PRIORITIES
+} SbJobPriority;
+
+GType          sb_job_get_type          (void);
+SbJob*         sb_job_new               (gchar const* const* argv,
+					 SbJobFlags          flags);
+void           sb_job_set_priority      (SbJob             * self,
+					 SbJobPriority       priority);
+SbJobPriority  sb_job_get_priority      (SbJob const       * self);
+gboolean       sb_job_start             (SbJob             * self,
+					 GError           ** error);
+gboolean       sb_job_spawn             (SbJob             * self,
+					 GError           ** error);
+void           sb_job_suspend           (SbJob             * self);
+void           sb_job_resume            (SbJob             * self);
+void           sb_job_cancel            (SbJob             * self);
+SbAsyncReader* sb_job_get_reader        (SbJob const       * self);
+gint           sb_job_get_stdin         (SbJob const       * self);
+gboolean       sb_job_can_suspend       (SbJob const       * self);
+gboolean       sb_job_is_running        (SbJob const       * self);
+gboolean       sb_job_is_done           (SbJob const       * self);
+gboolean       sb_job_is_cancelled      (SbJob const       * self);
+gint           sb_job_get_exit_status   (SbJob const       * self);
+gdouble        sb_job_get_wait          (SbJob const       * self);
+gdouble        sb_job_get_first_output  (SbJob const       * self);
+gdouble        sb_job_get_elapsed       (SbJob const       * self);
+gdouble        sb_job_get_runtime       (SbJob const       * self);
+
+struct _SbJob {
+	GObject       base_instance;
+	SbJobPrivate* _private;
+};
+
+struct _SbJobClass {
+	GObjectClass  base_class;
+
+	/* signals */
+	void (*done) (SbJob* self);
+};
+
+G_END_DECLS
+
+#endif /* !SB_JOB_H */
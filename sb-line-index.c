@@ -0,0 +1,192 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-line-index.h"
+
+/* For every revision and every author, the lines of the file they're
+ * responsible for. The lines are kept as sorted runs of consecutive lines
+ * (most hunks are longer than one line and neighbouring hunks of the same
+ * revision get merged), so a lookup hands out the runs ready to be
+ * applied to the text buffer.
+ */
+
+struct _SbLineIndex {
+	GPtrArray* revisions; /* revision id => GArray of SbLineRange */
+	GPtrArray* authors;   /* author id => GArray of SbLineRange */
+};
+
+SbLineIndex*
+sb_line_index_new (void)
+{
+	SbLineIndex* self = g_slice_new (SbLineIndex);
+
+	self->revisions = g_ptr_array_new ();
+	self->authors   = g_ptr_array_new ();
+
+	return self;
+}
+
+static void
+line_index_free_ranges (GPtrArray* ranges)
+{
+	guint i;
+
+	for (i = 0; i < ranges->len; i++) {
+		if (g_ptr_array_index (ranges, i)) {
+			g_array_free (g_ptr_array_index (ranges, i), TRUE);
+		}
+	}
+
+	g_ptr_array_free (ranges, TRUE);
+}
+
+void
+sb_line_index_free (SbLineIndex* self)
+{
+	g_return_if_fail (self);
+
+	line_index_free_ranges (self->revisions);
+	line_index_free_ranges (self->authors);
+
+	g_slice_free (SbLineIndex, self);
+}
+
+static void
+line_index_insert (GPtrArray* index,
+		   guint      key,
+		   guint      start,
+		   guint      end)
+{
+	GArray     * ranges;
+	SbLineRange* data;
+	guint        low = 0;
+	guint        high;
+
+	if (index->len <= key) {
+		g_ptr_array_set_size (index, key + 1);
+	}
+
+	ranges = g_ptr_array_index (index, key);
+	if (!ranges) {
+		ranges = g_array_new (FALSE, FALSE, sizeof (SbLineRange));
+		g_ptr_array_index (index, key) = ranges;
+	}
+
+	/* find the first range starting after @start */
+	data = (SbLineRange*)ranges->data;
+	high = ranges->len;
+	while (low < high) {
+		guint middle = low + (high - low) / 2;
+
+		if (data[middle].start <= start) {
+			low = middle + 1;
+		} else {
+			high = middle;
+		}
+	}
+
+	if (low > 0 && data[low - 1].end + 1 >= start) {
+		low--;
+		data[low].end = MAX (data[low].end, end);
+	} else {
+		SbLineRange range = {start, end};
+
+		g_array_insert_val (ranges, low, range);
+		data = (SbLineRange*)ranges->data;
+	}
+
+	/* swallow the ranges which touch the grown one */
+	while (low + 1 < ranges->len && data[low + 1].start <= data[low].end + 1) {
+		data[low].end = MAX (data[low].end, data[low + 1].end);
+		g_array_remove_index (ranges, low + 1);
+	}
+}
+
+void
+sb_line_index_add (SbLineIndex* self,
+		   guint        revision,
+		   guint        author,
+		   guint        start,
+		   guint        end)
+{
+	g_return_if_fail (self);
+	g_return_if_fail (start <= end);
+
+	line_index_insert (self->revisions, revision, start, end);
+
+	if (author != G_MAXUINT) {
+		line_index_insert (self->authors, author, start, end);
+	}
+}
+
+static SbLineRange const*
+line_index_lookup (GPtrArray const* index,
+		   guint            key,
+		   guint          * n_ranges)
+{
+	GArray* ranges = key < index->len ? g_ptr_array_index (index, key) : NULL;
+
+	if (!ranges) {
+		*n_ranges = 0;
+		return NULL;
+	}
+
+	*n_ranges = ranges->len;
+	return (SbLineRange const*)ranges->data;
+}
+
+SbLineRange const*
+sb_line_index_get_revision_lines (SbLineIndex const* self,
+				  guint              revision,
+				  guint            * n_ranges)
+{
+	g_return_val_if_fail (self, NULL);
+	g_return_val_if_fail (n_ranges, NULL);
+
+	return line_index_lookup (self->revisions, revision, n_ranges);
+}
+
+SbLineRange const*
+sb_line_index_get_author_lines (SbLineIndex const* self,
+				guint              author,
+				guint            * n_ranges)
+{
+	g_return_val_if_fail (self, NULL);
+	g_return_val_if_fail (n_ranges, NULL);
+
+	return line_index_lookup (self->authors, author, n_ranges);
+}
+
+guint
+sb_line_index_count_lines (SbLineRange const* ranges,
+			   guint              n_ranges)
+{
+	guint result = 0;
+	guint i;
+
+	for (i = 0; i < n_ranges; i++) {
+		result += ranges[i].end - ranges[i].start + 1;
+	}
+
+	return result;
+}
@@ -0,0 +1,57 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_LINE_INDEX_H
+#define SB_LINE_INDEX_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _SbLineIndex SbLineIndex;
+typedef struct _SbLineRange SbLineRange;
+
+struct _SbLineRange {
+	guint start;
+	guint end;   /* inclusive */
+};
+
+SbLineIndex*       sb_line_index_new                (void);
+void               sb_line_index_free               (SbLineIndex      * self);
+void               sb_line_index_add                (SbLineIndex      * self,
+						     guint              revision,
+						     guint              author,
+						     guint              start,
+						     guint              end);
+SbLineRange const* sb_line_index_get_revision_lines (SbLineIndex const* self,
+						     guint              revision,
+						     guint            * n_ranges);
+SbLineRange const* sb_line_index_get_author_lines   (SbLineIndex const* self,
+						     guint              author,
+						     guint            * n_ranges);
+guint              sb_line_index_count_lines        (SbLineRange const* ranges,
+						     guint              n_ranges);
+
+G_END_DECLS
+
+#endif /* !SB_LINE_INDEX_H */
@@ -0,0 +1,159 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-line-map.h"
+
+/* Maps the lines of the file as it was loaded (and blamed) to the lines
+ * of the edited buffer. An edit shifts every line behind it, so the shifts
+ * are kept in a Fenwick tree: both the edits and the lookups touch
+ * O(log n) nodes, whatever the size of the file.
+ *
+ * All lines count from 1. The current line of an original line is the
+ * line plus the sum of the shifts up to it; that sum never decreases
+ * between neighbours, so the tree can also be searched the other way.
+ */
+
+struct _SbLineMap {
+	guint  n_lines;
+	guint  top;    /* the highest power of two <= n_lines */
+	gint * tree;   /* 1-based */
+};
+
+SbLineMap*
+sb_line_map_new (guint n_lines)
+{
+	SbLineMap* self = g_slice_new (SbLineMap);
+
+	self->n_lines = n_lines;
+	self->tree    = g_new0 (gint, n_lines + 1);
+	for (self->top = 1; self->top <= n_lines / 2; self->top <<= 1) {
+		/* find the top */
+	}
+
+	return self;
+}
+
+void
+sb_line_map_free (SbLineMap* self)
+{
+	g_return_if_fail (self);
+
+	g_free (self->tree);
+	g_slice_free (SbLineMap, self);
+}
+
+/* shift @original and all lines behind it by @delta */
+static void
+line_map_shift (SbLineMap* self,
+		guint      original,
+		gint       delta)
+{
+	for (; original <= self->n_lines; original += original & -original) {
+		self->tree[original] += delta;
+	}
+}
+
+guint
+sb_line_map_get_line (SbLineMap const* self,
+		      guint            original)
+{
+	gint  result;
+
+	g_return_val_if_fail (self, original);
+
+	original = MIN (original, self->n_lines);
+	for (result = original; original; original -= original & -original) {
+		result += self->tree[original];
+	}
+
+	return result;
+}
+
+guint
+sb_line_map_get_original (SbLineMap const* self,
+			  guint            line)
+{
+	guint step;
+	guint original = 0;
+	gint  shift = 0;
+
+	g_return_val_if_fail (self, line);
+
+	/* the last original line ending up at or before @line */
+	for (step = self->n_lines ? self->top : 0; step; step >>= 1) {
+		if (original + step <= self->n_lines &&
+		    (gint)(original + step) + shift + self->tree[original + step] <= (gint)line)
+		{
+			original += step;
+			shift    += self->tree[original];
+		}
+	}
+
+	return original;
+}
+
+void
+sb_line_map_insert (SbLineMap* self,
+		    guint      line,
+		    guint      n_lines)
+{
+	guint original;
+
+	g_return_if_fail (self);
+
+	/* the lines behind @line move down */
+	original = sb_line_map_get_original (self, line) + 1;
+	if (n_lines && original <= self->n_lines) {
+		line_map_shift (self, original, n_lines);
+	}
+}
+
+void
+sb_line_map_delete (SbLineMap* self,
+		    guint      line,
+		    guint      n_lines)
+{
+	guint original;
+	gint  shifted = 0;
+
+	g_return_if_fail (self);
+
+	if (!n_lines) {
+		return;
+	}
+
+	/* the lines after @line get joined into it; the cost grows with the
+	 * number of deleted lines only */
+	for (original = sb_line_map_get_original (self, line) + 1; original <= self->n_lines; original++) {
+		gint current = sb_line_map_get_line (self, original);
+
+		/* the joined lines dragged this one along */
+		if (current - shifted > (gint)(line + n_lines)) {
+			line_map_shift (self, original, -(gint)n_lines - shifted);
+			break;
+		}
+
+		line_map_shift (self, original, (gint)line - current);
+		shifted += (gint)line - current;
+	}
+}
@@ -0,0 +1,48 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_LINE_MAP_H
+#define SB_LINE_MAP_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _SbLineMap SbLineMap;
+
+SbLineMap* sb_line_map_new          (guint            n_lines);
+void       sb_line_map_free         (SbLineMap      * self);
+void       sb_line_map_insert       (SbLineMap      * self,
+				     guint            line,
+				     guint            n_lines);
+void       sb_line_map_delete       (SbLineMap      * self,
+				     guint            line,
+				     guint            n_lines);
+guint      sb_line_map_get_line     (SbLineMap const* self,
+				     guint            original);
+guint      sb_line_map_get_original (SbLineMap const* self,
+				     guint            line);
+
+G_END_DECLS
+
+#endif /* !SB_LINE_MAP_H */
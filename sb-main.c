@@ -21,8 +21,10 @@
  * USA
  */
 
+#include "sb-settings.h"
 #include "sb-window.h"
 
+#include <signal.h>
 #include <gio/gio.h>
 #include <glib/gi18n.h>
 
@@ -31,9 +33,11 @@ main (int   argc,
       char**argv)
 {
 	gchar** files = NULL;
+	gchar * settings = NULL;
 	GError* error = NULL;
 	GOptionContext* context = g_option_context_new (_("[FILE]"));
 	GOptionEntry entries[] = {
+		{"settings", '\0', 0, G_OPTION_ARG_FILENAME, &settings, N_("Read the settings from a key file instead of GConf"), N_("KEYFILE")},
 		{G_OPTION_REMAINING, '\0', 0, G_OPTION_ARG_FILENAME_ARRAY, &files, "", ""},
 		{NULL}
 	};
@@ -63,6 +67,14 @@ main (int   argc,
 	}
 	g_option_context_free (context);
 
+	/* writing to a co-process that died is reported through EPIPE */
+	signal (SIGPIPE, SIG_IGN);
+
+	if (settings) {
+		sb_settings_use_key_file (settings);
+		g_free (settings);
+	}
+
 	GtkWidget* window = sb_window_new ();
 	gtk_widget_show (window);
 
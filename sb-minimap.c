@@ -0,0 +1,196 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-minimap.h"
+
+#include <string.h>
+
+#include "sb-reference.h"
+
+/* An overview of the whole file next to the text: every line knows the
+ * revision it comes from, and the lines are downsampled into a fixed
+ * number of buckets showing the newest revision in their range. Drawing
+ * costs the same for ten lines and for a million.
+ */
+
+#define N_BUCKETS 512
+#define WIDTH     12
+
+struct _SbMinimapPrivate {
+	SbColorMap* colors;
+
+	guint     * lines;   /* revision id per line */
+	guint       n_lines;
+
+	guint       buckets[N_BUCKETS];
+	guint       n_buckets;
+};
+
+G_DEFINE_TYPE (SbMinimap, sb_minimap, GTK_TYPE_DRAWING_AREA);
+
+static void
+sb_minimap_init (SbMinimap* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_MINIMAP,
+						      SbMinimapPrivate);
+
+	gtk_widget_set_size_request (GTK_WIDGET (self), WIDTH, -1);
+}
+
+static void
+minimap_downsample (SbMinimap* self)
+{
+	guint i;
+
+	self->_private->n_buckets = MIN (self->_private->n_lines, N_BUCKETS);
+
+	for (i = 0; i < self->_private->n_buckets; i++) {
+		guint  first = (guint64)i * self->_private->n_lines / self->_private->n_buckets;
+		guint  last  = (guint64)(i + 1) * self->_private->n_lines / self->_private->n_buckets;
+		guint  best  = self->_private->lines[first];
+		gfloat age   = sb_color_map_get_age (self->_private->colors, best);
+		guint  line;
+
+		for (line = first + 1; line < last; line++) {
+			guint id = self->_private->lines[line];
+
+			if (id != best && sb_color_map_get_age (self->_private->colors, id) > age) {
+				best = id;
+				age  = sb_color_map_get_age (self->_private->colors, id);
+			}
+		}
+
+		self->_private->buckets[i] = best;
+	}
+
+	gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+static void
+minimap_finalize (GObject* object)
+{
+	SbMinimap* self = SB_MINIMAP (object);
+
+	g_signal_handlers_disconnect_by_func (self->_private->colors, minimap_downsample, self);
+	g_object_unref (self->_private->colors);
+	g_free (self->_private->lines);
+
+	G_OBJECT_CLASS (sb_minimap_parent_class)->finalize (object);
+}
+
+static gboolean
+minimap_expose_event (GtkWidget     * widget,
+		      GdkEventExpose* event)
+{
+	SbMinimap* self = SB_MINIMAP (widget);
+	cairo_t  * cr;
+	gdouble    height;
+	guint      i;
+
+	if (!self->_private->n_buckets) {
+		return FALSE;
+	}
+
+	cr = gdk_cairo_create (widget->window);
+	gdk_cairo_rectangle (cr, &event->area);
+	cairo_clip (cr);
+
+	height = (gdouble)widget->allocation.height / self->_private->n_buckets;
+
+	for (i = 0; i < self->_private->n_buckets; ) {
+		guint first = i;
+
+		/* one rectangle per run of the same revision */
+		for (i++; i < self->_private->n_buckets && self->_private->buckets[i] == self->_private->buckets[first]; i++) {
+			;
+		}
+
+		gdk_cairo_set_source_color (cr, sb_color_map_lookup (self->_private->colors,
+								     self->_private->buckets[first]));
+		cairo_rectangle (cr,
+				 0.0, first * height,
+				 widget->allocation.width, (i - first) * height);
+		cairo_fill (cr);
+	}
+
+	cairo_destroy (cr);
+
+	return FALSE;
+}
+
+static void
+sb_minimap_class_init (SbMinimapClass* self_class)
+{
+	GObjectClass  * object_class = G_OBJECT_CLASS (self_class);
+	GtkWidgetClass* widget_class = GTK_WIDGET_CLASS (self_class);
+
+	object_class->finalize     = minimap_finalize;
+
+	widget_class->expose_event = minimap_expose_event;
+
+	g_type_class_add_private (self_class, sizeof (SbMinimapPrivate));
+}
+
+GtkWidget*
+sb_minimap_new (SbColorMap* colors)
+{
+	SbMinimap* self;
+
+	g_return_val_if_fail (SB_IS_COLOR_MAP (colors), NULL);
+
+	self = g_object_new (SB_TYPE_MINIMAP, NULL);
+	self->_private->colors = g_object_ref (colors);
+	g_signal_connect_swapped (colors, "changed",
+				  G_CALLBACK (minimap_downsample), self);
+
+	return GTK_WIDGET (self);
+}
+
+void
+sb_minimap_set_references (SbMinimap* self,
+			   GList    * references,
+			   guint      n_lines)
+{
+	GList* iter;
+
+	g_return_if_fail (SB_IS_MINIMAP (self));
+
+	self->_private->lines   = g_renew (guint, self->_private->lines, n_lines);
+	self->_private->n_lines = n_lines;
+	memset (self->_private->lines, 0xff, n_lines * sizeof (guint)); /* SB_REVISION_NONE */
+
+	for (iter = references; iter; iter = iter->next) {
+		guint id    = sb_revision_get_id (sb_reference_get_revision (iter->data));
+		guint start = MAX (sb_reference_get_current_start (iter->data), 1);
+		guint end   = MIN (sb_reference_get_current_end (iter->data), n_lines);
+		guint line;
+
+		/* the references count from 1 */
+		for (line = start; line <= end; line++) {
+			self->_private->lines[line - 1] = id;
+		}
+	}
+
+	minimap_downsample (self);
+}
@@ -0,0 +1,59 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_MINIMAP_H
+#define SB_MINIMAP_H
+
+#include "sb-color-map.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbMinimap        SbMinimap;
+typedef struct _SbMinimapPrivate SbMinimapPrivate;
+typedef struct _SbMinimapClass   SbMinimapClass;
+
+#define SB_TYPE_MINIMAP         (sb_minimap_get_type ())
+#define SB_MINIMAP(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_MINIMAP, SbMinimap))
+#define SB_MINIMAP_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_MINIMAP, SbMinimapClass))
+#define SB_IS_MINIMAP(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_MINIMAP))
+#define SB_IS_MINIMAP_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_MINIMAP))
+#define SB_MINIMAP_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_MINIMAP, SbMinimapClass))
+
+GType      sb_minimap_get_type       (void);
+GtkWidget* sb_minimap_new            (SbColorMap* colors);
+void       sb_minimap_set_references (SbMinimap * self,
+				      GList     * references,
+				      guint       n_lines);
+
+struct _SbMinimap {
+	GtkDrawingArea    base_instance;
+	SbMinimapPrivate* _private;
+};
+
+struct _SbMinimapClass {
+	GtkDrawingAreaClass base_class;
+};
+
+G_END_DECLS
+
+#endif /* !SB_MINIMAP_H */
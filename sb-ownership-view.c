@@ -0,0 +1,287 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-ownership-view.h"
+
+#include <glib/gi18n.h>
+
+/* The numbers of an SbContributor as a table: one row per author with
+ * the lines and files they own and their share of all lines. Every
+ * column sorts; the most lines come first. On each "changed" of the
+ * contributor, which arrives a few times per second during a scan, the
+ * row of each author gets updated where it is, so the selection, the
+ * scroll position and the focus stay.
+ */
+
+enum {
+	COL_AUTHOR,
+	COL_LINES,
+	COL_FILES,
+	COL_SHARE,
+	N_COLUMNS
+};
+
+typedef struct {
+	gboolean    present;
+	GtkTreeIter iter;    /* the list store keeps them valid */
+} Row;
+
+struct _SbOwnershipViewPrivate {
+	SbContributor  * contributor;
+	GtkListStore   * store;
+
+	/* author id => Row */
+	GArray         * rows;
+	SbRevisionTable* revisions;   /* the one the ids belong to */
+};
+
+enum {
+	AUTHOR_ACTIVATED,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+G_DEFINE_TYPE (SbOwnershipView, sb_ownership_view, GTK_TYPE_TREE_VIEW);
+
+static void
+share_data_func (GtkTreeViewColumn* column,
+		 GtkCellRenderer  * renderer,
+		 GtkTreeModel     * model,
+		 GtkTreeIter      * iter,
+		 gpointer           unused)
+{
+	gdouble share;
+	gchar * text;
+
+	gtk_tree_model_get (model, iter, COL_SHARE, &share, -1);
+
+	text = g_strdup_printf ("%.1f%%", share);
+	g_object_set (renderer, "text", text, NULL);
+	g_free (text);
+}
+
+static void
+ownership_view_append_column (SbOwnershipView* self,
+			      gchar const    * title,
+			      gint             column)
+{
+	GtkCellRenderer  * renderer = gtk_cell_renderer_text_new ();
+	GtkTreeViewColumn* result;
+
+	if (column == COL_SHARE) {
+		result = gtk_tree_view_column_new_with_attributes (title, renderer, NULL);
+		gtk_tree_view_column_set_cell_data_func (result, renderer,
+							 share_data_func, NULL, NULL);
+	} else {
+		result = gtk_tree_view_column_new_with_attributes (title, renderer,
+								   "text", column,
+								   NULL);
+	}
+
+	if (column != COL_AUTHOR) {
+		g_object_set (renderer, "xalign", 1.0, NULL);
+	} else {
+		gtk_tree_view_column_set_expand (result, TRUE);
+	}
+
+	gtk_tree_view_column_set_sort_column_id (result, column);
+	gtk_tree_view_append_column (GTK_TREE_VIEW (self), result);
+}
+
+static void
+sb_ownership_view_init (SbOwnershipView* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_OWNERSHIP_VIEW,
+						      SbOwnershipViewPrivate);
+
+	self->_private->rows  = g_array_new (FALSE, TRUE, sizeof (Row));
+	self->_private->store = gtk_list_store_new (N_COLUMNS,
+						    G_TYPE_STRING,
+						    G_TYPE_UINT,
+						    G_TYPE_UINT,
+						    G_TYPE_DOUBLE);
+	gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (self->_private->store),
+					      COL_LINES, GTK_SORT_DESCENDING);
+	gtk_tree_view_set_model (GTK_TREE_VIEW (self), GTK_TREE_MODEL (self->_private->store));
+
+	ownership_view_append_column (self, _("Author"), COL_AUTHOR);
+	ownership_view_append_column (self, _("Lines"),  COL_LINES);
+	ownership_view_append_column (self, _("Files"),  COL_FILES);
+	ownership_view_append_column (self, _("Share"),  COL_SHARE);
+
+	gtk_tree_view_set_search_column (GTK_TREE_VIEW (self), COL_AUTHOR);
+}
+
+static void
+ownership_view_clear (SbOwnershipView* self)
+{
+	gtk_list_store_clear (self->_private->store);
+	g_array_set_size (self->_private->rows, 0);
+}
+
+static void
+ownership_view_update (SbOwnershipView* self)
+{
+	SbRevisionTable* revisions = sb_contributor_get_revisions (self->_private->contributor);
+	guint const    * lines = NULL;
+	guint const    * files = NULL;
+	guint            n_authors = 0;
+	guint            n_files = 0;
+	guint            total = sb_contributor_get_n_lines (self->_private->contributor);
+	guint            i;
+
+	if (revisions != self->_private->revisions) {
+		/* the ids mean other authors now */
+		ownership_view_clear (self);
+		self->_private->revisions = revisions;
+	}
+
+	if (revisions && total) {
+		lines = sb_contributor_get_author_lines (self->_private->contributor, &n_authors);
+		files = sb_contributor_get_author_files (self->_private->contributor, &n_files);
+	}
+
+	if (self->_private->rows->len < n_authors) {
+		g_array_set_size (self->_private->rows, n_authors);
+	}
+
+	for (i = 0; i < self->_private->rows->len; i++) {
+		Row    * row = &g_array_index (self->_private->rows, Row, i);
+		guint    n_lines;
+		guint    n_owned;
+		gdouble  share;
+
+		if (i >= n_authors || !lines[i]) {
+			if (row->present) {
+				gtk_list_store_remove (self->_private->store, &row->iter);
+				row->present = FALSE;
+			}
+			continue;
+		}
+
+		if (!row->present) {
+			gtk_list_store_insert_with_values (self->_private->store, &row->iter, -1,
+							   COL_AUTHOR, sb_revision_table_get_author_name (revisions, i),
+							   COL_LINES,  lines[i],
+							   COL_FILES,  i < n_files ? files[i] : 0,
+							   COL_SHARE,  100.0 * lines[i] / total,
+							   -1);
+			row->present = TRUE;
+			continue;
+		}
+
+		/* the total grows during a scan, so the shares change as well */
+		gtk_tree_model_get (GTK_TREE_MODEL (self->_private->store), &row->iter,
+				    COL_LINES, &n_lines,
+				    COL_FILES, &n_owned,
+				    COL_SHARE, &share,
+				    -1);
+		if (n_lines != lines[i] || n_owned != (i < n_files ? files[i] : 0) ||
+		    share != 100.0 * lines[i] / total)
+		{
+			gtk_list_store_set (self->_private->store, &row->iter,
+					    COL_LINES, lines[i],
+					    COL_FILES, i < n_files ? files[i] : 0,
+					    COL_SHARE, 100.0 * lines[i] / total,
+					    -1);
+		}
+	}
+}
+
+static void
+ownership_view_row_activated (GtkTreeView      * view,
+			      GtkTreePath      * path,
+			      GtkTreeViewColumn* column)
+{
+	GtkTreeModel* model = gtk_tree_view_get_model (view);
+	GtkTreeIter   iter;
+	gchar       * author;
+
+	if (!gtk_tree_model_get_iter (model, &iter, path)) {
+		return;
+	}
+
+	gtk_tree_model_get (model, &iter, COL_AUTHOR, &author, -1);
+	g_signal_emit (view, signals[AUTHOR_ACTIVATED], 0, author);
+	g_free (author);
+}
+
+static void
+ownership_view_finalize (GObject* object)
+{
+	SbOwnershipView* self = SB_OWNERSHIP_VIEW (object);
+
+	g_signal_handlers_disconnect_by_func (self->_private->contributor, ownership_view_update, self);
+	g_object_unref (self->_private->contributor);
+	g_object_unref (self->_private->store);
+	g_array_free (self->_private->rows, TRUE);
+
+	G_OBJECT_CLASS (sb_ownership_view_parent_class)->finalize (object);
+}
+
+static void
+sb_ownership_view_class_init (SbOwnershipViewClass* self_class)
+{
+	GObjectClass    * object_class    = G_OBJECT_CLASS (self_class);
+	GtkTreeViewClass* tree_view_class = GTK_TREE_VIEW_CLASS (self_class);
+
+	object_class->finalize = ownership_view_finalize;
+
+	tree_view_class->row_activated = ownership_view_row_activated;
+
+	signals[AUTHOR_ACTIVATED] = g_signal_new ("author-activated",
+						  SB_TYPE_OWNERSHIP_VIEW,
+						  G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbOwnershipViewClass, author_activated),
+						  NULL, NULL,
+						  g_cclosure_marshal_VOID__STRING,
+						  G_TYPE_NONE, 1,
+						  G_TYPE_STRING);
+
+	g_type_class_add_private (self_class, sizeof (SbOwnershipViewPrivate));
+}
+
+GtkWidget*
+sb_ownership_view_new (SbContributor* contributor)
+{
+	SbOwnershipView* self;
+
+	g_return_val_if_fail (SB_IS_CONTRIBUTOR (contributor), NULL);
+
+	self = g_object_new (SB_TYPE_OWNERSHIP_VIEW, NULL);
+	self->_private->contributor = g_object_ref (contributor);
+	g_signal_connect_swapped (contributor, "changed",
+				  G_CALLBACK (ownership_view_update), self);
+	ownership_view_update (self);
+
+	return GTK_WIDGET (self);
+}
+
+SbContributor*
+sb_ownership_view_get_contributor (SbOwnershipView* self)
+{
+	g_return_val_if_fail (SB_IS_OWNERSHIP_VIEW (self), NULL);
+
+	return self->_private->contributor;
+}
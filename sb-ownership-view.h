@@ -0,0 +1,62 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_OWNERSHIP_VIEW_H
+#define SB_OWNERSHIP_VIEW_H
+
+#include <gtk/gtk.h>
+#include "sb-contributor.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbOwnershipView        SbOwnershipView;
+typedef struct _SbOwnershipViewPrivate SbOwnershipViewPrivate;
+typedef struct _SbOwnershipViewClass   SbOwnershipViewClass;
+
+#define SB_TYPE_OWNERSHIP_VIEW         (sb_ownership_view_get_type ())
+#define SB_OWNERSHIP_VIEW(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_OWNERSHIP_VIEW, SbOwnershipView))
+#define SB_OWNERSHIP_VIEW_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_OWNERSHIP_VIEW, SbOwnershipViewClass))
+#define SB_IS_OWNERSHIP_VIEW(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_OWNERSHIP_VIEW))
+#define SB_IS_OWNERSHIP_VIEW_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_OWNERSHIP_VIEW))
+#define SB_OWNERSHIP_VIEW_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_OWNERSHIP_VIEW, SbOwnershipViewClass))
+
+GType          sb_ownership_view_get_type        (void);
+GtkWidget*     sb_ownership_view_new             (SbContributor  * contributor);
+SbContributor* sb_ownership_view_get_contributor (SbOwnershipView* self);
+
+struct _SbOwnershipView {
+	GtkTreeView             base_instance;
+	SbOwnershipViewPrivate* _private;
+};
+
+struct _SbOwnershipViewClass {
+	GtkTreeViewClass        base_class;
+
+	/* signals */
+	void (*author_activated) (SbOwnershipView* self,
+				  gchar const    * author);
+};
+
+G_END_DECLS
+
+#endif /* !SB_OWNERSHIP_VIEW_H */
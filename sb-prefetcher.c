@@ -0,0 +1,267 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-prefetcher.h"
+
+#include <string.h>
+#include <sys/stat.h>
+#include <glib/gstdio.h>
+
+#include "sb-annotation-cache.h"
+
+/* Annotates the files the user is likely to open next into the
+ * SbAnnotationCache: the recently shown ones and the neighbours of the
+ * current one in its folder.
+ *
+ * This must never slow down the foreground. The blames run at the
+ * lowest CPU priority, only MAX_RUNNING of them at once, and a round
+ * stops after MAX_FILES files or BUDGET seconds. A foreground load
+ * cancels everything at once: a niced process can't get its priority
+ * back, so taking over a running prefetch isn't worth it.
+ */
+
+#define MAX_RUNNING   1
+#define MAX_FILES     8
+#define MAX_RECENT    8
+#define MAX_SIZE      (1 << 20)  /* bytes; larger files take too long */
+#define BUDGET        30.0       /* seconds per round */
+
+static struct {
+	GQueue * pending;   /* of gchar* paths */
+	GList  * running;   /* of SbHistoryLoader */
+	GList  * recent;    /* of gchar* paths, most recent first */
+	guint    flags;
+	GTimer * timer;
+} prefetcher = {NULL, NULL, NULL, 0, NULL};
+
+static void prefetcher_run (void);
+
+static void
+prefetcher_ensure (void)
+{
+	if (G_LIKELY (prefetcher.pending)) {
+		return;
+	}
+
+	prefetcher.pending = g_queue_new ();
+	prefetcher.timer   = g_timer_new ();
+}
+
+static void
+prefetcher_clear_pending (void)
+{
+	gchar* path;
+
+	while ((path = g_queue_pop_head (prefetcher.pending))) {
+		g_free (path);
+	}
+}
+
+static void
+loader_done_cb (SbHistoryLoader* loader,
+		gpointer         unused)
+{
+	prefetcher.running = g_list_remove (prefetcher.running, loader);
+
+	/* nothing to cache if blame failed (e.g. for files not in git) */
+	if (sb_history_loader_get_references (loader)) {
+		sb_annotation_cache_insert (loader);
+	}
+	g_object_unref (loader);
+
+	prefetcher_run ();
+}
+
+static void
+prefetcher_run (void)
+{
+	while (g_list_length (prefetcher.running) < MAX_RUNNING &&
+	       g_timer_elapsed (prefetcher.timer, NULL) < BUDGET)
+	{
+		gchar          * path = g_queue_pop_head (prefetcher.pending);
+		SbHistoryLoader* loader;
+
+		if (!path) {
+			break;
+		}
+
+		loader = sb_history_loader_new (path, prefetcher.flags);
+		g_free (path);
+
+		sb_history_loader_set_background (loader, TRUE);
+		if (!sb_history_loader_start (loader, NULL)) {
+			g_object_unref (loader);
+			continue;
+		}
+
+		g_signal_connect (loader, "done",
+				  G_CALLBACK (loader_done_cb), NULL);
+		prefetcher.running = g_list_prepend (prefetcher.running, loader);
+	}
+}
+
+static gboolean
+prefetcher_wants (gchar const* path)
+{
+	struct stat buf;
+
+	if (g_queue_get_length (prefetcher.pending) >= MAX_FILES ||
+	    g_queue_find_custom (prefetcher.pending, path, (GCompareFunc)strcmp))
+	{
+		return FALSE;
+	}
+
+	return g_stat (path, &buf) == 0 && S_ISREG (buf.st_mode) && buf.st_size <= MAX_SIZE &&
+	       !sb_annotation_cache_contains (path, prefetcher.flags);
+}
+
+static gint
+compare_names (gconstpointer a,
+	       gconstpointer b)
+{
+	return strcmp (*(gchar const* const*)a, *(gchar const* const*)b);
+}
+
+/* the files next to @file_path, the closest first */
+static void
+prefetcher_add_neighbours (gchar const* file_path)
+{
+	gchar      * folder = g_path_get_dirname (file_path);
+	gchar      * name   = g_path_get_basename (file_path);
+	GDir       * dir    = g_dir_open (folder, 0, NULL);
+	GPtrArray  * names;
+	gchar const* entry;
+	guint        current;
+	guint        distance;
+
+	if (!dir) {
+		g_free (folder);
+		g_free (name);
+		return;
+	}
+
+	names = g_ptr_array_new ();
+	while ((entry = g_dir_read_name (dir))) {
+		if (entry[0] != '.') {
+			g_ptr_array_add (names, g_strdup (entry));
+		}
+	}
+	g_dir_close (dir);
+	g_ptr_array_sort (names, compare_names);
+
+	for (current = 0; current < names->len && strcmp (g_ptr_array_index (names, current), name); current++) {
+		/* find the file itself */
+	}
+
+	for (distance = 1; distance < names->len && g_queue_get_length (prefetcher.pending) < MAX_FILES; distance++) {
+		guint  indices[2] = {current + distance, current - distance};
+		guint  i;
+
+		for (i = 0; i < G_N_ELEMENTS (indices); i++) {
+			gchar* path;
+
+			if (indices[i] >= names->len) {
+				/* past either end (the subtraction wraps) */
+				continue;
+			}
+
+			path = g_build_filename (folder, g_ptr_array_index (names, indices[i]), NULL);
+			if (prefetcher_wants (path)) {
+				g_queue_push_tail (prefetcher.pending, path);
+			} else {
+				g_free (path);
+			}
+		}
+	}
+
+	g_ptr_array_foreach (names, (GFunc)g_free, NULL);
+	g_ptr_array_free (names, TRUE);
+	g_free (folder);
+	g_free (name);
+}
+
+static void
+prefetcher_add_recent (gchar const* file_path)
+{
+	GList* iter = g_list_find_custom (prefetcher.recent, file_path, (GCompareFunc)strcmp);
+
+	if (iter) {
+		prefetcher.recent = g_list_remove_link (prefetcher.recent, iter);
+		prefetcher.recent = g_list_concat (iter, prefetcher.recent);
+	} else {
+		prefetcher.recent = g_list_prepend (prefetcher.recent, g_strdup (file_path));
+	}
+
+	if (g_list_length (prefetcher.recent) > MAX_RECENT) {
+		iter = g_list_last (prefetcher.recent);
+		g_free (iter->data);
+		prefetcher.recent = g_list_delete_link (prefetcher.recent, iter);
+	}
+
+	/* the recent files only need a refresh if their cache got invalid */
+	for (iter = prefetcher.recent->next; iter; iter = iter->next) {
+		if (prefetcher_wants (iter->data)) {
+			g_queue_push_tail (prefetcher.pending, g_strdup (iter->data));
+		}
+	}
+}
+
+/* start a round for the files around @file_path; call this once the
+ * foreground is idle */
+void
+sb_prefetcher_queue (gchar const* file_path,
+		     guint        flags)
+{
+	g_return_if_fail (file_path && g_path_is_absolute (file_path));
+
+	prefetcher_ensure ();
+	sb_prefetcher_preempt ();
+
+	prefetcher.flags = flags;
+	g_timer_start (prefetcher.timer);
+
+	prefetcher_add_recent (file_path);
+	prefetcher_add_neighbours (file_path);
+
+	prefetcher_run ();
+}
+
+/* the foreground needs the machine */
+void
+sb_prefetcher_preempt (void)
+{
+	if (!prefetcher.pending) {
+		return;
+	}
+
+	prefetcher_clear_pending ();
+
+	while (prefetcher.running) {
+		SbHistoryLoader* loader = prefetcher.running->data;
+
+		g_signal_handlers_disconnect_by_func (loader, loader_done_cb, NULL);
+		sb_history_loader_cancel (loader);
+		g_object_unref (loader);
+		prefetcher.running = g_list_delete_link (prefetcher.running, prefetcher.running);
+	}
+}
@@ -25,9 +25,24 @@
 
 #include <glib/gi18n.h>
 
+/* redraw at most once per frame, no matter how often the status changes */
+#define FRAME_INTERVAL 16 /* milliseconds */
+
 struct _SbProgressPrivate {
-	gulong status;
-	gulong target;
+	gulong  status;
+	gulong  target;
+
+	guint   update_source;
+
+	/* throughput measurement, restarted with each new target */
+	GTimer* timer;
+	gdouble last_elapsed;
+	gulong  last_status;
+	gdouble rate; /* lines per second */
+
+	/* what's currently on screen */
+	gulong  shown_status;
+	gulong  shown_target;
 };
 
 G_DEFINE_TYPE (SbProgress, sb_progress, GTK_TYPE_PROGRESS_BAR);
@@ -39,12 +54,34 @@ sb_progress_init (SbProgress* self)
 						      SB_TYPE_PROGRESS,
 						      SbProgressPrivate);
 
+	self->_private->timer = g_timer_new ();
+	self->_private->shown_status = G_MAXULONG;
+	self->_private->shown_target = G_MAXULONG;
+
 	sb_progress_set_target (self, 0);
 }
 
+static void
+progress_finalize (GObject* object)
+{
+	SbProgress* self = SB_PROGRESS (object);
+
+	if (self->_private->update_source) {
+		g_source_remove (self->_private->update_source);
+		self->_private->update_source = 0;
+	}
+	g_timer_destroy (self->_private->timer);
+
+	G_OBJECT_CLASS (sb_progress_parent_class)->finalize (object);
+}
+
 static void
 sb_progress_class_init (SbProgressClass* self_class)
 {
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = progress_finalize;
+
 	g_type_class_add_private (self_class, sizeof (SbProgressPrivate));
 }
 
@@ -54,20 +91,95 @@ sb_progress_new (void)
 	return g_object_new (SB_TYPE_PROGRESS, NULL);
 }
 
-static inline void
-progress_update (SbProgress* self)
+static void
+progress_measure (SbProgress* self)
+{
+	gdouble elapsed = g_timer_elapsed (self->_private->timer, NULL);
+	gdouble delta   = elapsed - self->_private->last_elapsed;
+	gdouble rate;
+
+	if (G_UNLIKELY (self->_private->status < self->_private->last_status)) {
+		/* the status was reset, start over */
+		self->_private->last_elapsed = elapsed;
+		self->_private->last_status  = self->_private->status;
+		return;
+	}
+
+	if (delta < 0.25) {
+		/* too short to tell anything yet */
+		return;
+	}
+
+	rate = (self->_private->status - self->_private->last_status) / delta;
+
+	/* smooth the rate, the blame stream is rather bursty */
+	if (self->_private->rate > 0.0) {
+		self->_private->rate = 0.7 * self->_private->rate + 0.3 * rate;
+	} else {
+		self->_private->rate = rate;
+	}
+
+	self->_private->last_elapsed = elapsed;
+	self->_private->last_status  = self->_private->status;
+}
+
+static gboolean
+progress_flush (gpointer data)
 {
-	// FIXME: perform this in an idle handler
-	gchar* message = g_strdup_printf (_("%d / %d"),
-					  self->_private->status,
-					  self->_private->target);
+	SbProgress* self = SB_PROGRESS (data);
+	gchar       message[128];
+
+	self->_private->update_source = 0;
+
+	progress_measure (self);
+
+	if (self->_private->shown_status == self->_private->status &&
+	    self->_private->shown_target == self->_private->target)
+	{
+		return FALSE;
+	}
+
+	if (self->_private->rate >= 1.0 && self->_private->status < self->_private->target) {
+		gulong eta = (self->_private->target - self->_private->status) / self->_private->rate;
+		g_snprintf (message, sizeof (message),
+			    _("%lu / %lu (%.0f lines/s, %lu:%02lu left)"),
+			    self->_private->status,
+			    self->_private->target,
+			    self->_private->rate,
+			    eta / 60,
+			    eta % 60);
+	} else {
+		g_snprintf (message, sizeof (message),
+			    _("%lu / %lu"),
+			    self->_private->status,
+			    self->_private->target);
+	}
+
 	gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (self),
 				       G_LIKELY (self->_private->target) ?
 					          1.0 * self->_private->status / self->_private->target :
 						  0.0);
 	gtk_progress_bar_set_text     (GTK_PROGRESS_BAR (self),
 				       message);
-	g_free (message);
+
+	self->_private->shown_status = self->_private->status;
+	self->_private->shown_target = self->_private->target;
+
+	return FALSE;
+}
+
+static inline void
+progress_update (SbProgress* self)
+{
+	if (G_LIKELY (self->_private->update_source)) {
+		return;
+	}
+
+	self->_private->update_source = g_timeout_add_full (GDK_PRIORITY_REDRAW,
+							    FRAME_INTERVAL,
+							    progress_flush,
+							    self,
+							    NULL);
 }
 
 gulong
@@ -116,6 +228,12 @@ sb_progress_set_target (SbProgress* self,
 
 	self->_private->target = target;
 
+	/* a new target means a new load, restart the throughput measurement */
+	g_timer_start (self->_private->timer);
+	self->_private->last_elapsed = 0.0;
+	self->_private->last_status  = self->_private->status;
+	self->_private->rate         = 0.0;
+
 	if (G_UNLIKELY (self->_private->status > self->_private->target)) {
 		sb_progress_set_status (self, self->_private->target);
 		g_assert (self->_private->status <= self->_private->target); // FIXME: g_warn_if_fail()
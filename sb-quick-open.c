@@ -0,0 +1,191 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-quick-open.h"
+
+#include <glib/gi18n.h>
+
+/* Finds a file of the repository by a few letters of its path. Every
+ * keystroke asks the file index for the best MAX_RESULTS matches; Enter
+ * or a double click take the selected one.
+ */
+
+#define MAX_RESULTS 100
+
+struct _SbQuickOpenPrivate {
+	SbFileIndex * index;
+	GtkWidget   * entry;
+	GtkWidget   * view;
+	GtkListStore* store;
+};
+
+G_DEFINE_TYPE (SbQuickOpen, sb_quick_open, GTK_TYPE_DIALOG);
+
+static void
+quick_open_search (SbQuickOpen* self)
+{
+	guint       results[MAX_RESULTS];
+	guint       n_results;
+	guint       i;
+	GtkTreeIter iter;
+
+	gtk_list_store_clear (self->_private->store);
+
+	n_results = sb_file_index_search (self->_private->index,
+					  gtk_entry_get_text (GTK_ENTRY (self->_private->entry)),
+					  results, G_N_ELEMENTS (results));
+	for (i = 0; i < n_results; i++) {
+		gtk_list_store_insert_with_values (self->_private->store, NULL, -1,
+						   0, sb_file_index_get_path (self->_private->index, results[i]),
+						   -1);
+	}
+
+	if (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (self->_private->store), &iter)) {
+		gtk_tree_selection_select_iter (gtk_tree_view_get_selection (GTK_TREE_VIEW (self->_private->view)),
+						&iter);
+	}
+
+	gtk_dialog_set_response_sensitive (GTK_DIALOG (self), GTK_RESPONSE_ACCEPT, n_results > 0);
+}
+
+static void
+quick_open_row_activated_cb (GtkDialog* dialog)
+{
+	gtk_dialog_response (dialog, GTK_RESPONSE_ACCEPT);
+}
+
+static void
+sb_quick_open_init (SbQuickOpen* self)
+{
+	GtkWidget* scrolled;
+
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_QUICK_OPEN,
+						      SbQuickOpenPrivate);
+
+	gtk_window_set_title (GTK_WINDOW (self), _("Open File"));
+	gtk_window_set_default_size (GTK_WINDOW (self), 500, 400);
+	gtk_dialog_add_buttons (GTK_DIALOG (self),
+				GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+				GTK_STOCK_OPEN,   GTK_RESPONSE_ACCEPT,
+				NULL);
+	gtk_dialog_set_default_response (GTK_DIALOG (self), GTK_RESPONSE_ACCEPT);
+
+	self->_private->entry = gtk_entry_new ();
+	gtk_entry_set_activates_default (GTK_ENTRY (self->_private->entry), TRUE);
+	g_signal_connect_swapped (self->_private->entry, "changed",
+				  G_CALLBACK (quick_open_search), self);
+	gtk_widget_show (self->_private->entry);
+	gtk_box_pack_start (GTK_BOX (GTK_DIALOG (self)->vbox),
+			    self->_private->entry,
+			    FALSE,
+			    FALSE,
+			    0);
+
+	scrolled = gtk_scrolled_window_new (NULL, NULL);
+	gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled),
+					GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
+	gtk_widget_show (scrolled);
+	gtk_box_pack_start_defaults (GTK_BOX (GTK_DIALOG (self)->vbox),
+				     scrolled);
+
+	self->_private->store = gtk_list_store_new (1, G_TYPE_STRING);
+	self->_private->view  = gtk_tree_view_new_with_model (GTK_TREE_MODEL (self->_private->store));
+	gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (self->_private->view), FALSE);
+	gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (self->_private->view), -1,
+						     NULL, gtk_cell_renderer_text_new (),
+						     "text", 0,
+						     NULL);
+	g_signal_connect_swapped (self->_private->view, "row-activated",
+				  G_CALLBACK (quick_open_row_activated_cb), self);
+	gtk_widget_show (self->_private->view);
+	gtk_container_add (GTK_CONTAINER (scrolled),
+			   self->_private->view);
+}
+
+static void
+quick_open_finalize (GObject* object)
+{
+	SbQuickOpen* self = SB_QUICK_OPEN (object);
+
+	g_signal_handlers_disconnect_by_func (self->_private->index, quick_open_search, self);
+	g_object_unref (self->_private->index);
+	g_object_unref (self->_private->store);
+
+	G_OBJECT_CLASS (sb_quick_open_parent_class)->finalize (object);
+}
+
+static void
+sb_quick_open_class_init (SbQuickOpenClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = quick_open_finalize;
+
+	g_type_class_add_private (self_class, sizeof (SbQuickOpenPrivate));
+}
+
+GtkWidget*
+sb_quick_open_new (GtkWindow  * parent,
+		   SbFileIndex* index)
+{
+	SbQuickOpen* self;
+
+	g_return_val_if_fail (SB_IS_FILE_INDEX (index), NULL);
+
+	self = g_object_new (SB_TYPE_QUICK_OPEN, NULL);
+	gtk_window_set_transient_for (GTK_WINDOW (self), parent);
+
+	self->_private->index = g_object_ref (index);
+	/* the list may still be loading */
+	g_signal_connect_swapped (index, "ready",
+				  G_CALLBACK (quick_open_search), self);
+	quick_open_search (self);
+
+	return GTK_WIDGET (self);
+}
+
+/* the absolute path of the selected file, or NULL */
+gchar*
+sb_quick_open_get_path (SbQuickOpen* self)
+{
+	GtkTreeModel* model;
+	GtkTreeIter   iter;
+	gchar       * path;
+	gchar       * result;
+
+	g_return_val_if_fail (SB_IS_QUICK_OPEN (self), NULL);
+
+	if (!gtk_tree_selection_get_selected (gtk_tree_view_get_selection (GTK_TREE_VIEW (self->_private->view)),
+					      &model, &iter))
+	{
+		return NULL;
+	}
+
+	gtk_tree_model_get (model, &iter, 0, &path, -1);
+	result = g_build_filename (sb_repository_get_toplevel (sb_file_index_get_repository (self->_private->index)),
+				   path, NULL);
+	g_free (path);
+
+	return result;
+}
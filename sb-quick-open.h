@@ -0,0 +1,59 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_QUICK_OPEN_H
+#define SB_QUICK_OPEN_H
+
+#include <gtk/gtk.h>
+#include "sb-file-index.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbQuickOpen        SbQuickOpen;
+typedef struct _SbQuickOpenPrivate SbQuickOpenPrivate;
+typedef struct _SbQuickOpenClass   SbQuickOpenClass;
+
+#define SB_TYPE_QUICK_OPEN         (sb_quick_open_get_type ())
+#define SB_QUICK_OPEN(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_QUICK_OPEN, SbQuickOpen))
+#define SB_QUICK_OPEN_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_QUICK_OPEN, SbQuickOpenClass))
+#define SB_IS_QUICK_OPEN(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_QUICK_OPEN))
+#define SB_IS_QUICK_OPEN_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_QUICK_OPEN))
+#define SB_QUICK_OPEN_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_QUICK_OPEN, SbQuickOpenClass))
+
+GType      sb_quick_open_get_type (void);
+GtkWidget* sb_quick_open_new      (GtkWindow  * parent,
+				   SbFileIndex* index);
+gchar*     sb_quick_open_get_path (SbQuickOpen* self);
+
+struct _SbQuickOpen {
+	GtkDialog           base_instance;
+	SbQuickOpenPrivate* _private;
+};
+
+struct _SbQuickOpenClass {
+	GtkDialogClass      base_class;
+};
+
+G_END_DECLS
+
+#endif /* !SB_QUICK_OPEN_H */
@@ -23,8 +23,9 @@
 
 #include "sb-reference-label.h"
 
+#include "sb-annotations.h"
+
 struct _SbReferenceLabelPrivate {
-	GtkLabel   * label;
 	SbReference* reference;
 };
 
@@ -41,10 +42,6 @@ sb_reference_label_init (SbReferenceLabel* self)
 	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
 						      SB_TYPE_REFERENCE_LABEL,
 						      SbReferenceLabelPrivate);
-
-	self->_private->label = GTK_LABEL (gtk_label_new (""));
-	gtk_widget_show (GTK_WIDGET (self->_private->label));
-	gtk_container_add (GTK_CONTAINER (self), GTK_WIDGET (self->_private->label));
 }
 
 static void
@@ -77,51 +74,6 @@ label_get_property (GObject   * object,
 	}
 }
 
-static inline void
-set_color (SbReferenceLabel* self,
-	   GdkColor        * color)
-{
-	GdkColor colors[] = { // tango colors
-		{0, 0xfcfc, 0xe9e9, 0x4f4f}, // butter
-		{0, 0xfcfc, 0xafaf, 0x3e3e}, // orange
-		{0, 0xe9e9, 0xb9b9, 0x6e6e}, // chocolate
-		{0, 0x8a8a, 0xe2e2, 0x3434}, // chameleon
-		{0, 0x7272, 0x9f9f, 0xcfcf}, // sky blue
-		{0, 0xadad, 0x7f7f, 0xa8a8}, // plum
-		{0, 0xefef, 0x2929, 0x2929}, // scarlet red
-		{0, 0xeeee, 0xeeee, 0xecec}  // aluminium
-	};
-
-	gchar const* name = sb_revision_get_name (sb_reference_get_revision (self->_private->reference));
-	guint        hash = name ? g_str_hash (name) : 0;
-
-	*color = colors[hash & 0x7];
-}
-
-static inline void
-update_background (SbReferenceLabel* self)
-{
-	GdkColor  color = {0, 0xeeee, 0xeeee, 0xeeee}; // aluminium
-	set_color (self, &color);
-	gtk_widget_modify_bg (GTK_WIDGET (self),
-			      GTK_STATE_NORMAL,
-			      &color);
-}
-
-static inline void
-update_tooltip (SbReferenceLabel* self)
-{
-	SbRevision* rev = sb_reference_get_revision (self->_private->reference);
-	GString* tooltip = g_string_new ("");
-	g_string_append_printf (tooltip, "%.7s:%s\n\n%s",
-				sb_revision_get_name (rev),
-				sb_reference_get_filename (self->_private->reference),
-				sb_revision_get_summary (rev));
-	gtk_widget_set_tooltip_text (GTK_WIDGET (self),
-				     tooltip->str);
-	g_string_free (tooltip, TRUE);
-}
-
 static void
 label_set_property (GObject     * object,
 		    guint         prop_id,
@@ -136,12 +88,6 @@ label_set_property (GObject     * object,
 		// FIXME: drop the cast once depending on glib 2.14
 		self->_private->reference = SB_REFERENCE (g_value_dup_object (value));
 		g_object_notify (object, "reference");
-
-		g_object_set (self->_private->label,
-			      "label", sb_revision_get_name (sb_reference_get_revision (self->_private->reference)),
-			      NULL);
-		update_background (self);
-		update_tooltip (self);
 		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -149,15 +95,39 @@ label_set_property (GObject     * object,
 	}
 }
 
+/* the annotations share one layout between all hunks of a revision */
+static gboolean
+label_expose_event (GtkWidget     * widget,
+		    GdkEventExpose* event)
+{
+	SbReferenceLabel* self   = SB_REFERENCE_LABEL (widget);
+	GtkWidget       * parent = gtk_widget_get_parent (widget);
+
+	GTK_WIDGET_CLASS (sb_reference_label_parent_class)->expose_event (widget, event);
+
+	if (GTK_WIDGET_DRAWABLE (widget) && SB_IS_ANNOTATIONS (parent)) {
+		gdk_draw_layout (widget->window,
+				 widget->style->fg_gc[GTK_WIDGET_STATE (widget)],
+				 0, 0,
+				 sb_annotations_get_layout (SB_ANNOTATIONS (parent),
+							    sb_reference_get_revision (self->_private->reference)));
+	}
+
+	return FALSE;
+}
+
 static void
 sb_reference_label_class_init (SbReferenceLabelClass* self_class)
 {
-	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+	GObjectClass  * object_class = G_OBJECT_CLASS (self_class);
+	GtkWidgetClass* widget_class = GTK_WIDGET_CLASS (self_class);
 
 	object_class->finalize     = label_finalize;
 	object_class->get_property = label_get_property;
 	object_class->set_property = label_set_property;
 
+	widget_class->expose_event = label_expose_event;
+
 	g_object_class_install_property (object_class, PROP_REFERENCE,
 					 g_param_spec_object ("reference", "reference", "reference",
 							      SB_TYPE_REFERENCE, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
@@ -181,3 +151,13 @@ sb_reference_label_get_reference (SbReferenceLabel const* self)
 	return self->_private->reference;
 }
 
+void
+sb_reference_label_set_color (SbReferenceLabel* self,
+			      GdkColor const  * color)
+{
+	g_return_if_fail (SB_IS_REFERENCE_LABEL (self));
+
+	gtk_widget_modify_bg (GTK_WIDGET (self),
+			      GTK_STATE_NORMAL,
+			      color);
+}
@@ -39,6 +39,8 @@ typedef struct _SbReferenceLabelClass   SbReferenceLabelClass;
 
 GtkWidget*   sb_reference_label_new           (SbReference           * reference);
 SbReference* sb_reference_label_get_reference (SbReferenceLabel const* self);
+void         sb_reference_label_set_color     (SbReferenceLabel      * self,
+					       GdkColor const        * color);
 
 struct _SbReferenceLabel {
 	GtkEventBox              base_instance;
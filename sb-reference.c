@@ -28,6 +28,11 @@ struct _SbReferencePrivate {
 	gchar*      filename;
 	guint       current_start;
 	guint       current_end;
+	guint       original_start;
+
+	/* the revision and file this hunk came from; NULL for root commits */
+	SbRevision* previous;
+	gchar*      previous_filename;
 };
 
 enum {
@@ -54,6 +59,10 @@ reference_finalize (GObject* object)
 
 	g_object_unref (self->_private->revision);
 	g_free (self->_private->filename);
+	if (self->_private->previous) {
+		g_object_unref (self->_private->previous);
+	}
+	g_free (self->_private->previous_filename);
 
 	G_OBJECT_CLASS (sb_reference_parent_class)->finalize (object);
 }
@@ -196,3 +205,57 @@ sb_reference_set_filename (SbReference* self,
 	// g_object_notify (G_OBJECT (self), "filename");
 }
 
+guint
+sb_reference_get_original_start (SbReference const* self)
+{
+	g_return_val_if_fail (SB_IS_REFERENCE (self), 0);
+
+	return self->_private->original_start;
+}
+
+void
+sb_reference_set_original_start (SbReference* self,
+				 guint        original_start)
+{
+	g_return_if_fail (SB_IS_REFERENCE (self));
+
+	self->_private->original_start = original_start;
+}
+
+SbRevision*
+sb_reference_get_previous (SbReference const* self)
+{
+	g_return_val_if_fail (SB_IS_REFERENCE (self), NULL);
+
+	return self->_private->previous;
+}
+
+gchar const*
+sb_reference_get_previous_filename (SbReference const* self)
+{
+	g_return_val_if_fail (SB_IS_REFERENCE (self), NULL);
+
+	return self->_private->previous_filename;
+}
+
+void
+sb_reference_set_previous (SbReference* self,
+			   SbRevision * previous,
+			   gchar const* filename)
+{
+	g_return_if_fail (SB_IS_REFERENCE (self));
+	g_return_if_fail (!previous || SB_IS_REVISION (previous));
+
+	if (previous) {
+		g_object_ref (previous);
+	}
+	if (self->_private->previous) {
+		g_object_unref (self->_private->previous);
+	}
+	self->_private->previous = previous;
+
+	if (self->_private->previous_filename != filename) {
+		g_free (self->_private->previous_filename);
+		self->_private->previous_filename = g_strdup (filename);
+	}
+}
@@ -36,16 +36,24 @@ typedef struct _SbReferenceClass   SbReferenceClass;
 #define SB_REFERENCE(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_REFERENCE, SbReference))
 #define SB_IS_REFERENCE(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_REFERENCE))
 
-GType        sb_reference_get_type	    (void);
-SbReference* sb_reference_new		    (SbRevision       * revision,
-					     guint              current_start,
-					     guint              current_end);
-guint        sb_reference_get_current_start (SbReference const* self);
-guint        sb_reference_get_current_end   (SbReference const* self);
-gchar const* sb_reference_get_filename      (SbReference const* self);
-SbRevision*  sb_reference_get_revision      (SbReference const* self);
-void         sb_reference_set_filename      (SbReference      * self,
-					     gchar const      * filename);
+GType        sb_reference_get_type              (void);
+SbReference* sb_reference_new                   (SbRevision       * revision,
+						 guint              current_start,
+						 guint              current_end);
+guint        sb_reference_get_current_start     (SbReference const* self);
+guint        sb_reference_get_current_end       (SbReference const* self);
+gchar const* sb_reference_get_filename          (SbReference const* self);
+SbRevision*  sb_reference_get_revision          (SbReference const* self);
+void         sb_reference_set_filename          (SbReference      * self,
+						 gchar const      * filename);
+guint        sb_reference_get_original_start    (SbReference const* self);
+void         sb_reference_set_original_start    (SbReference      * self,
+						 guint              original_start);
+SbRevision*  sb_reference_get_previous          (SbReference const* self);
+gchar const* sb_reference_get_previous_filename (SbReference const* self);
+void         sb_reference_set_previous          (SbReference      * self,
+						 SbRevision       * previous,
+						 gchar const      * filename);
 
 struct _SbReference {
 	GObject             base_instance;
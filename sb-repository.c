@@ -0,0 +1,816 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-repository.h"
+
+#include <errno.h>
+#include <string.h>
+#include <gio/gio.h>
+
+#include "sb-git.h"
+#include "sb-settings.h"
+
+/* A registry of the repositories we've seen.
+ *
+ * For each folder, the repository is found once (without starting git);
+ * the location of the git directory, the worktree root, the commit HEAD
+ * points to and the repository configuration are cached and shared by
+ * everyone. The cached HEAD and configuration are dropped when
+ * .git/HEAD, the refs or the config file change; "changed" is emitted
+ * then.
+ *
+ * A new repository gets its commit-graph checked; a missing or outdated
+ * one is written at indexing priority (see sb-commit-graph.c). An outdated
+ * graph only gets a new layer for the new commits ("--split"), and only
+ * once for each state of the packs: the time of the newest pack the graph
+ * was last written for is kept in the cache folder of the user. The blame
+ * times of each file are kept from before and after that, so the gain
+ * can be shown.
+ */
+
+#define GRAPH_STAMP_FILE "graph"
+
+/* in the cache folder of the user, one folder per git directory */
+#define CACHE_FOLDER "source-browser"
+
+struct _SbRepositoryPrivate {
+	gchar          * toplevel;
+	gchar          * git_dir;
+	gchar          * common_dir;
+
+	/* lazily filled; NULL means "read again" */
+	gchar          * head;
+	gchar          * head_ref;
+	gboolean         head_valid;
+	GHashTable     * config;
+
+	SbCatFile      * cat_file;
+	SbRevisionTable* revisions;
+
+	GList          * monitors;
+
+	SbCommitGraphState graph_state;
+	SbJob          * graph_writer;
+	/* path => gdouble* seconds of git blame */
+	GHashTable     * blame_before;
+	GHashTable     * blame_after;
+};
+
+enum {
+	CHANGED,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+/* git dir => SbRepository */
+static GHashTable* repositories = NULL;
+/* folder => SbRepository (not referenced); NULL for "not in a repository" */
+static GHashTable* folders = NULL;
+
+G_DEFINE_TYPE (SbRepository, sb_repository, G_TYPE_OBJECT);
+
+static void
+sb_repository_init (SbRepository* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_REPOSITORY,
+						      SbRepositoryPrivate);
+
+	self->_private->blame_before = g_hash_table_new_full (g_str_hash, g_str_equal,
+							      g_free,     g_free);
+	self->_private->blame_after  = g_hash_table_new_full (g_str_hash, g_str_equal,
+							      g_free,     g_free);
+}
+
+static void
+repository_invalidate (SbRepository* self)
+{
+	g_free (self->_private->head);
+	self->_private->head = NULL;
+	g_free (self->_private->head_ref);
+	self->_private->head_ref = NULL;
+	self->_private->head_valid = FALSE;
+
+	if (self->_private->config) {
+		g_hash_table_destroy (self->_private->config);
+		self->_private->config = NULL;
+	}
+}
+
+static gchar*
+repository_get_objects_dir (SbRepository const* self)
+{
+	return g_build_filename (self->_private->common_dir, "objects", NULL);
+}
+
+static void
+repository_check_graph (SbRepository* self)
+{
+	gchar* objects = repository_get_objects_dir (self);
+
+	self->_private->graph_state = sb_commit_graph_check (objects);
+
+	g_free (objects);
+}
+
+/* the time of the newest pack when the graph was last written */
+static time_t
+repository_read_graph_stamp (SbRepository const* self)
+{
+	gchar * path     = sb_repository_get_cache_file (self, GRAPH_STAMP_FILE);
+	gchar * contents = NULL;
+	time_t  result   = 0;
+
+	if (g_file_get_contents (path, &contents, NULL, NULL)) {
+		result = g_ascii_strtoll (contents, NULL, 10);
+	}
+
+	g_free (contents);
+	g_free (path);
+
+	return result;
+}
+
+static void
+repository_write_graph_stamp (SbRepository const* self,
+			      time_t              pack_time)
+{
+	gchar * path     = sb_repository_get_cache_file (self, GRAPH_STAMP_FILE);
+	gchar * contents = g_strdup_printf ("%" G_GINT64_FORMAT "\n", (gint64)pack_time);
+	GError* error    = NULL;
+
+	if (!g_file_set_contents (path, contents, -1, &error)) {
+		g_message ("couldn't remember the commit-graph state: %s", error->message);
+		g_error_free (error);
+	}
+
+	g_free (contents);
+	g_free (path);
+}
+
+static void
+repository_graph_written_cb (SbRepository* self,
+			     SbJob       * job)
+{
+	if (sb_job_get_exit_status (job)) {
+		g_message ("couldn't write the commit-graph of %s", self->_private->toplevel);
+	} else {
+		gchar* objects = repository_get_objects_dir (self);
+
+		repository_write_graph_stamp (self, sb_commit_graph_pack_time (objects));
+		g_free (objects);
+	}
+
+	g_object_unref (self->_private->graph_writer);
+	self->_private->graph_writer = NULL;
+
+	repository_check_graph (self);
+}
+
+/* the gain is largest on the repositories where blame is slowest, so
+ * don't wait for the user to ask */
+static void
+repository_warm_up (SbRepository* self)
+{
+	GError* error = NULL;
+	gchar * objects;
+	time_t  pack_time;
+
+	repository_check_graph (self);
+
+	if (self->_private->graph_state == SB_COMMIT_GRAPH_OK ||
+	    !sb_settings_get_write_commit_graph ())
+	{
+		return;
+	}
+
+	objects   = repository_get_objects_dir (self);
+	pack_time = sb_commit_graph_pack_time (objects);
+	g_free (objects);
+
+	if (self->_private->graph_state == SB_COMMIT_GRAPH_STALE &&
+	    pack_time == repository_read_graph_stamp (self))
+	{
+		/* written for these packs already; git had nothing to add */
+		return;
+	}
+
+	/* the layers without filters get replaced once, after that only
+	 * the new commits get a layer of their own */
+	/* stopped, it would hold the lock of the commit-graph chain */
+	self->_private->graph_writer = sb_git_job_new (self->_private->toplevel, SB_JOB_NO_SUSPEND,
+						       "commit-graph", "write",
+						       "--reachable", "--changed-paths",
+						       self->_private->graph_state == SB_COMMIT_GRAPH_STALE ?
+						       "--split" : "--split=replace",
+						       NULL);
+	sb_job_set_priority (self->_private->graph_writer, SB_JOB_PRIORITY_INDEX);
+
+	if (!sb_job_start (self->_private->graph_writer, &error)) {
+		g_message ("couldn't write the commit-graph: %s", error->message);
+		g_error_free (error);
+		g_object_unref (self->_private->graph_writer);
+		self->_private->graph_writer = NULL;
+		return;
+	}
+
+	g_signal_connect_swapped (self->_private->graph_writer, "done",
+				  G_CALLBACK (repository_graph_written_cb), self);
+}
+
+static void
+repository_finalize (GObject* object)
+{
+	SbRepository* self = SB_REPOSITORY (object);
+	GList       * iter;
+
+	for (iter = self->_private->monitors; iter; iter = iter->next) {
+		g_file_monitor_cancel (iter->data);
+		g_object_unref (iter->data);
+	}
+	g_list_free (self->_private->monitors);
+
+	repository_invalidate (self);
+
+	if (self->_private->graph_writer) {
+		g_signal_handlers_disconnect_by_func (self->_private->graph_writer, repository_graph_written_cb, self);
+		/* let git finish; it writes under a lock file */
+		g_object_unref (self->_private->graph_writer);
+	}
+	g_hash_table_destroy (self->_private->blame_before);
+	g_hash_table_destroy (self->_private->blame_after);
+
+	if (self->_private->cat_file) {
+		g_object_unref (self->_private->cat_file);
+	}
+
+	if (self->_private->revisions) {
+		sb_revision_table_free (self->_private->revisions);
+	}
+
+	g_free (self->_private->toplevel);
+	g_free (self->_private->git_dir);
+	g_free (self->_private->common_dir);
+
+	G_OBJECT_CLASS (sb_repository_parent_class)->finalize (object);
+}
+
+static void
+sb_repository_class_init (SbRepositoryClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = repository_finalize;
+
+	signals[CHANGED] = g_signal_new ("changed",
+					 SB_TYPE_REPOSITORY,
+					 G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbRepositoryClass, changed),
+					 NULL, NULL,
+					 g_cclosure_marshal_VOID__VOID,
+					 G_TYPE_NONE, 0);
+
+	g_type_class_add_private (self_class, sizeof (SbRepositoryPrivate));
+}
+
+static gchar*
+read_first_line (gchar const* path)
+{
+	gchar* contents = NULL;
+	gchar* newline;
+
+	if (!g_file_get_contents (path, &contents, NULL, NULL)) {
+		return NULL;
+	}
+
+	newline = strchr (contents, '\n');
+	if (newline) {
+		*newline = '\0';
+	}
+
+	return contents;
+}
+
+/* resolves a symbolic ref to a commit; loose refs win over packed ones */
+static gchar*
+repository_resolve_ref (SbRepository* self,
+			gchar const * ref)
+{
+	gchar* path   = g_build_filename (self->_private->common_dir, ref, NULL);
+	gchar* result = read_first_line (path);
+	gchar* packed;
+
+	g_free (path);
+
+	if (result) {
+		return result;
+	}
+
+	path = g_build_filename (self->_private->common_dir, "packed-refs", NULL);
+	if (g_file_get_contents (path, &packed, NULL, NULL)) {
+		gchar** lines = g_strsplit (packed, "\n", -1);
+		gchar** line;
+
+		for (line = lines; *line && !result; line++) {
+			/* "<sha1> <ref>" */
+			gchar* space = strchr (*line, ' ');
+
+			if (**line != '#' && **line != '^' && space && !strcmp (space + 1, ref)) {
+				result = g_strndup (*line, space - *line);
+			}
+		}
+
+		g_strfreev (lines);
+		g_free (packed);
+	}
+	g_free (path);
+
+	return result;
+}
+
+static void
+repository_read_head (SbRepository* self)
+{
+	gchar* path = g_build_filename (self->_private->git_dir, "HEAD", NULL);
+	gchar* head = read_first_line (path);
+
+	g_free (path);
+
+	self->_private->head_valid = TRUE;
+
+	if (!head) {
+		return;
+	}
+
+	if (g_str_has_prefix (head, "ref: ")) {
+		self->_private->head_ref = g_strdup (head + strlen ("ref: "));
+		/* NULL for an unborn branch */
+		self->_private->head     = repository_resolve_ref (self, self->_private->head_ref);
+		g_free (head);
+	} else {
+		/* detached */
+		self->_private->head = head;
+	}
+}
+
+/* a small subset of git-config(1): sections, subsections and simple values */
+static void
+repository_read_config (SbRepository* self)
+{
+	gchar * path = g_build_filename (self->_private->common_dir, "config", NULL);
+	gchar * contents = NULL;
+	gchar** lines;
+	gchar** line;
+	gchar * section = NULL;
+
+	self->_private->config = g_hash_table_new_full (g_str_hash, g_str_equal,
+							g_free,     g_free);
+
+	if (!g_file_get_contents (path, &contents, NULL, NULL)) {
+		g_free (path);
+		return;
+	}
+	g_free (path);
+
+	lines = g_strsplit (contents, "\n", -1);
+	for (line = lines; *line; line++) {
+		gchar* text = g_strstrip (*line);
+		gchar* equals;
+		gchar* key;
+		gchar* value;
+
+		if (!*text || *text == '#' || *text == ';') {
+			continue;
+		}
+
+		if (*text == '[') {
+			gchar* end = strchr (text, ']');
+			gchar* quote;
+
+			if (!end) {
+				continue;
+			}
+			*end = '\0';
+			text++;
+
+			g_free (section);
+			quote = strchr (text, '"');
+			if (quote) {
+				/* [section "subsection"]: only the section name is case insensitive */
+				gchar* name = g_strndup (text, quote - text);
+				gchar* sub  = g_strndup (quote + 1, strcspn (quote + 1, "\""));
+				gchar* down = g_ascii_strdown (g_strstrip (name), -1);
+				section = g_strdup_printf ("%s.%s", down, sub);
+				g_free (down);
+				g_free (name);
+				g_free (sub);
+			} else {
+				section = g_ascii_strdown (g_strstrip (text), -1);
+			}
+			continue;
+		}
+
+		if (!section) {
+			continue;
+		}
+
+		equals = strchr (text, '=');
+		if (equals) {
+			*equals = '\0';
+			value = g_strstrip (equals + 1);
+		} else {
+			/* "key" alone means "key = true" */
+			value = "true";
+		}
+
+		if (*value == '"' && value[strlen (value) - 1] == '"' && strlen (value) > 1) {
+			value[strlen (value) - 1] = '\0';
+			value++;
+		}
+
+		key = g_ascii_strdown (g_strstrip (text), -1);
+		g_hash_table_insert (self->_private->config,
+				     g_strdup_printf ("%s.%s", section, key),
+				     g_strdup (value));
+		g_free (key);
+	}
+
+	g_free (section);
+	g_strfreev (lines);
+	g_free (contents);
+}
+
+static void
+monitor_changed_cb (GFileMonitor     * monitor,
+		    GFile            * file,
+		    GFile            * other,
+		    GFileMonitorEvent  event,
+		    SbRepository     * self)
+{
+	switch (event) {
+	case G_FILE_MONITOR_EVENT_CHANGED:
+	case G_FILE_MONITOR_EVENT_CREATED:
+	case G_FILE_MONITOR_EVENT_DELETED:
+		repository_invalidate (self);
+		g_signal_emit (self, signals[CHANGED], 0);
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+repository_watch (SbRepository* self,
+		  gchar const * folder,
+		  gchar const * name,
+		  gboolean      directory)
+{
+	gchar       * path = g_build_filename (folder, name, NULL);
+	GFile       * file = g_file_new_for_path (path);
+	GFileMonitor* monitor;
+
+	if (directory) {
+		monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, NULL);
+	} else {
+		monitor = g_file_monitor_file (file, G_FILE_MONITOR_NONE, NULL, NULL);
+	}
+
+	if (monitor) {
+		g_signal_connect (monitor, "changed",
+				  G_CALLBACK (monitor_changed_cb), self);
+		self->_private->monitors = g_list_prepend (self->_private->monitors, monitor);
+	}
+
+	g_object_unref (file);
+	g_free (path);
+}
+
+static SbRepository*
+repository_new (gchar const* toplevel,
+		gchar const* git_dir)
+{
+	SbRepository* self = g_object_new (SB_TYPE_REPOSITORY, NULL);
+	gchar       * path;
+	gchar       * common_dir;
+
+	self->_private->toplevel = g_strdup (toplevel);
+	self->_private->git_dir  = g_strdup (git_dir);
+
+	/* linked worktrees share the refs and the config with the main one */
+	path = g_build_filename (git_dir, "commondir", NULL);
+	common_dir = read_first_line (path);
+	if (common_dir && !g_path_is_absolute (common_dir)) {
+		gchar* absolute = g_build_filename (git_dir, common_dir, NULL);
+		g_free (common_dir);
+		common_dir = absolute;
+	}
+	self->_private->common_dir = common_dir ? common_dir : g_strdup (git_dir);
+	g_free (path);
+
+	repository_watch (self, self->_private->git_dir,    "HEAD",        FALSE);
+	/* git appends to it on every commit, checkout and reset, also of
+	 * branches in folders of "refs/heads" that aren't watched */
+	repository_watch (self, self->_private->git_dir,    "logs/HEAD",   FALSE);
+	repository_watch (self, self->_private->common_dir, "packed-refs", FALSE);
+	repository_watch (self, self->_private->common_dir, "config",      FALSE);
+	repository_watch (self, self->_private->common_dir, "refs/heads",  TRUE);
+
+	return self;
+}
+
+/* returns the git dir for a toplevel with a ".git" entry */
+static gchar*
+find_git_dir (gchar const* toplevel)
+{
+	gchar* dot_git = g_build_filename (toplevel, ".git", NULL);
+	gchar* link;
+
+	if (g_file_test (dot_git, G_FILE_TEST_IS_DIR)) {
+		return dot_git;
+	}
+
+	/* worktrees and submodules have a "gitdir: <path>" file instead */
+	link = read_first_line (dot_git);
+	g_free (dot_git);
+
+	if (!link || !g_str_has_prefix (link, "gitdir: ")) {
+		g_free (link);
+		return NULL;
+	}
+
+	if (g_path_is_absolute (link + strlen ("gitdir: "))) {
+		dot_git = g_strdup (link + strlen ("gitdir: "));
+	} else {
+		dot_git = g_build_filename (toplevel, link + strlen ("gitdir: "), NULL);
+	}
+	g_free (link);
+
+	return dot_git;
+}
+
+SbRepository*
+sb_repository_lookup (gchar const* folder)
+{
+	SbRepository* self = NULL;
+	gchar       * iter;
+
+	g_return_val_if_fail (folder && g_path_is_absolute (folder), NULL);
+
+	if (G_UNLIKELY (!repositories)) {
+		repositories = g_hash_table_new_full (g_str_hash, g_str_equal,
+						      g_free,     g_object_unref);
+		folders      = g_hash_table_new_full (g_str_hash, g_str_equal,
+						      g_free,     NULL);
+	}
+
+	if (g_hash_table_lookup_extended (folders, folder, NULL, (gpointer*)&self)) {
+		return self;
+	}
+
+	for (iter = g_strdup (folder); iter && !self; ) {
+		gchar* git_dir = find_git_dir (iter);
+		gchar* parent;
+
+		if (git_dir) {
+			self = g_hash_table_lookup (repositories, git_dir);
+
+			if (!self) {
+				self = repository_new (iter, git_dir);
+				g_hash_table_insert (repositories, g_strdup (git_dir), self);
+				repository_warm_up (self);
+			}
+
+			g_free (git_dir);
+			break;
+		}
+
+		parent = g_path_get_dirname (iter);
+		if (!strcmp (parent, iter)) {
+			/* hit the root */
+			g_free (parent);
+			parent = NULL;
+		}
+		g_free (iter);
+		iter = parent;
+	}
+	g_free (iter);
+
+	g_hash_table_insert (folders, g_strdup (folder), self);
+
+	return self;
+}
+
+gchar const*
+sb_repository_get_toplevel (SbRepository const* self)
+{
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), NULL);
+
+	return self->_private->toplevel;
+}
+
+gchar const*
+sb_repository_get_git_dir (SbRepository const* self)
+{
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), NULL);
+
+	return self->_private->git_dir;
+}
+
+gchar const*
+sb_repository_get_common_dir (SbRepository const* self)
+{
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), NULL);
+
+	return self->_private->common_dir;
+}
+
+/* a file of ours about the repository; it's kept out of the repository,
+ * which might be read-only or shared with others */
+gchar*
+sb_repository_get_cache_file (SbRepository const* self,
+			      gchar const       * name)
+{
+	gchar* key;
+	gchar* folder;
+	gchar* result;
+
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), NULL);
+	g_return_val_if_fail (name, NULL);
+
+	/* linked worktrees have a git directory (and a HEAD) of their own */
+	key    = g_compute_checksum_for_string (G_CHECKSUM_SHA1, self->_private->git_dir, -1);
+	folder = g_build_filename (g_get_user_cache_dir (), CACHE_FOLDER, key, NULL);
+	if (g_mkdir_with_parents (folder, 0700)) {
+		g_message ("couldn't create %s: %s", folder, g_strerror (errno));
+	}
+	result = g_build_filename (folder, name, NULL);
+
+	g_free (folder);
+	g_free (key);
+
+	return result;
+}
+
+gchar const*
+sb_repository_get_head (SbRepository* self)
+{
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), NULL);
+
+	if (!self->_private->head_valid) {
+		repository_read_head (self);
+	}
+
+	return self->_private->head;
+}
+
+gchar const*
+sb_repository_get_head_ref (SbRepository* self)
+{
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), NULL);
+
+	if (!self->_private->head_valid) {
+		repository_read_head (self);
+	}
+
+	return self->_private->head_ref;
+}
+
+gchar const*
+sb_repository_get_config (SbRepository* self,
+			  gchar const * key)
+{
+	gchar      * lower;
+	gchar const* result;
+
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), NULL);
+	g_return_val_if_fail (key, NULL);
+
+	if (!self->_private->config) {
+		repository_read_config (self);
+	}
+
+	result = g_hash_table_lookup (self->_private->config, key);
+	if (!result) {
+		lower  = g_ascii_strdown (key, -1);
+		result = g_hash_table_lookup (self->_private->config, lower);
+		g_free (lower);
+	}
+
+	return result;
+}
+
+gchar const*
+sb_repository_get_relative_path (SbRepository const* self,
+				 gchar const       * path)
+{
+	gsize length;
+
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), NULL);
+	g_return_val_if_fail (path, NULL);
+
+	length = strlen (self->_private->toplevel);
+	if (strncmp (path, self->_private->toplevel, length)) {
+		return NULL;
+	}
+
+	for (path += length; *path == G_DIR_SEPARATOR; path++) {
+		;
+	}
+
+	return path;
+}
+
+SbCatFile*
+sb_repository_get_cat_file (SbRepository* self)
+{
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), NULL);
+
+	if (!self->_private->cat_file) {
+		self->_private->cat_file = sb_cat_file_new (self->_private->toplevel);
+	}
+
+	return self->_private->cat_file;
+}
+
+SbCommitGraphState
+sb_repository_get_commit_graph (SbRepository const* self)
+{
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), SB_COMMIT_GRAPH_MISSING);
+
+	return self->_private->graph_state;
+}
+
+/* the time the full blame of path took; sorted by the graph in use */
+void
+sb_repository_add_blame_time (SbRepository* self,
+			      gchar const * path,
+			      gdouble       seconds)
+{
+	gdouble* value;
+
+	g_return_if_fail (SB_IS_REPOSITORY (self));
+	g_return_if_fail (path);
+
+	value  = g_new (gdouble, 1);
+	*value = seconds;
+	g_hash_table_insert (self->_private->graph_state == SB_COMMIT_GRAPH_OK ?
+			     self->_private->blame_after : self->_private->blame_before,
+			     g_strdup (path), value);
+}
+
+/* TRUE if path got blamed both before and after the commit-graph was written */
+gboolean
+sb_repository_get_blame_times (SbRepository* self,
+			       gchar const * path,
+			       gdouble     * before,
+			       gdouble     * after)
+{
+	gdouble const* first;
+	gdouble const* last;
+
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), FALSE);
+	g_return_val_if_fail (path && before && after, FALSE);
+
+	first = g_hash_table_lookup (self->_private->blame_before, path);
+	last  = g_hash_table_lookup (self->_private->blame_after,  path);
+	if (!first || !last) {
+		return FALSE;
+	}
+
+	*before = *first;
+	*after  = *last;
+
+	return TRUE;
+}
+
+SbRevisionTable*
+sb_repository_get_revisions (SbRepository* self)
+{
+	g_return_val_if_fail (SB_IS_REPOSITORY (self), NULL);
+
+	if (!self->_private->revisions) {
+		self->_private->revisions = sb_revision_table_new ();
+	}
+
+	return self->_private->revisions;
+}
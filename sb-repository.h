@@ -0,0 +1,82 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_REPOSITORY_H
+#define SB_REPOSITORY_H
+
+#include "sb-cat-file.h"
+#include "sb-commit-graph.h"
+#include "sb-revision-table.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbRepository        SbRepository;
+typedef struct _SbRepositoryPrivate SbRepositoryPrivate;
+typedef struct _SbRepositoryClass   SbRepositoryClass;
+
+#define SB_TYPE_REPOSITORY         (sb_repository_get_type ())
+#define SB_REPOSITORY(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_REPOSITORY, SbRepository))
+#define SB_REPOSITORY_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_REPOSITORY, SbRepositoryClass))
+#define SB_IS_REPOSITORY(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_REPOSITORY))
+#define SB_IS_REPOSITORY_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_REPOSITORY))
+#define SB_REPOSITORY_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_REPOSITORY, SbRepositoryClass))
+
+GType            sb_repository_get_type          (void);
+SbRepository*    sb_repository_lookup            (gchar const       * folder);
+gchar const*     sb_repository_get_toplevel      (SbRepository const* self);
+gchar const*     sb_repository_get_git_dir       (SbRepository const* self);
+gchar const*     sb_repository_get_common_dir    (SbRepository const* self);
+gchar*           sb_repository_get_cache_file    (SbRepository const* self,
+						  gchar const       * name);
+gchar const*     sb_repository_get_head          (SbRepository      * self);
+gchar const*     sb_repository_get_head_ref      (SbRepository      * self);
+gchar const*     sb_repository_get_config        (SbRepository      * self,
+						  gchar const       * key);
+gchar const*     sb_repository_get_relative_path (SbRepository const* self,
+						  gchar const       * path);
+SbCatFile*       sb_repository_get_cat_file      (SbRepository      * self);
+SbRevisionTable* sb_repository_get_revisions     (SbRepository      * self);
+SbCommitGraphState sb_repository_get_commit_graph (SbRepository const* self);
+void             sb_repository_add_blame_time    (SbRepository      * self,
+						  gchar const       * path,
+						  gdouble             seconds);
+gboolean         sb_repository_get_blame_times   (SbRepository      * self,
+						  gchar const       * path,
+						  gdouble           * before,
+						  gdouble           * after);
+
+struct _SbRepository {
+	GObject              base_instance;
+	SbRepositoryPrivate* _private;
+};
+
+struct _SbRepositoryClass {
+	GObjectClass         base_class;
+
+	/* signals */
+	void (*changed) (SbRepository* self);
+};
+
+G_END_DECLS
+
+#endif /* !SB_REPOSITORY_H */
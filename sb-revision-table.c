@@ -0,0 +1,329 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-revision-table.h"
+
+/* The metadata of all revisions of a repository, stored column by column
+ * and indexed by a small integer id that is handed out when a revision
+ * name is interned. Author names are dictionary encoded, so comparing
+ * or grouping by author is an integer comparison.
+ *
+ * The SbRevision objects are only created on demand, as handles for the
+ * widgets that need one.
+ */
+
+struct _SbRevisionTable {
+	/* revisions */
+	GStringChunk* strings;
+	GHashTable  * ids;             /* name => id + 1 */
+	GPtrArray   * names;
+	GArray      * authors;         /* guint */
+	GArray      * author_times;    /* gint64 */
+	GArray      * committer_times; /* gint64 */
+	GArray      * previous;        /* guint */
+	GPtrArray   * revisions;       /* SbRevision, created lazily */
+
+	/* authors */
+	GHashTable  * author_ids;      /* name => id + 1 */
+	GPtrArray   * author_names;
+};
+
+SbRevisionTable*
+sb_revision_table_new (void)
+{
+	SbRevisionTable* self = g_slice_new (SbRevisionTable);
+
+	self->strings         = g_string_chunk_new (4096);
+	self->ids             = g_hash_table_new (g_str_hash, g_str_equal);
+	self->names           = g_ptr_array_new ();
+	self->authors         = g_array_new (FALSE, FALSE, sizeof (guint));
+	self->author_times    = g_array_new (FALSE, FALSE, sizeof (gint64));
+	self->committer_times = g_array_new (FALSE, FALSE, sizeof (gint64));
+	self->previous        = g_array_new (FALSE, FALSE, sizeof (guint));
+	self->revisions       = g_ptr_array_new ();
+
+	self->author_ids      = g_hash_table_new (g_str_hash, g_str_equal);
+	self->author_names    = g_ptr_array_new ();
+
+	return self;
+}
+
+void
+sb_revision_table_free (SbRevisionTable* self)
+{
+	guint i;
+
+	g_return_if_fail (self);
+
+	for (i = 0; i < self->revisions->len; i++) {
+		SbRevision* revision = g_ptr_array_index (self->revisions, i);
+
+		if (revision) {
+			/* the references might keep them alive */
+			sb_revision_detach (revision);
+			g_object_unref (revision);
+		}
+	}
+
+	g_ptr_array_free     (self->revisions, TRUE);
+	g_array_free         (self->previous, TRUE);
+	g_array_free         (self->committer_times, TRUE);
+	g_array_free         (self->author_times, TRUE);
+	g_array_free         (self->authors, TRUE);
+	g_ptr_array_free     (self->names, TRUE);
+	g_hash_table_destroy (self->ids);
+	g_ptr_array_free     (self->author_names, TRUE);
+	g_hash_table_destroy (self->author_ids);
+	g_string_chunk_free  (self->strings);
+
+	g_slice_free (SbRevisionTable, self);
+}
+
+guint
+sb_revision_table_intern (SbRevisionTable* self,
+			  gchar const    * name)
+{
+	gpointer  id;
+	gchar   * copy;
+	guint     none   = SB_REVISION_NONE;
+	gint64    zero   = 0;
+
+	g_return_val_if_fail (self, SB_REVISION_NONE);
+	g_return_val_if_fail (name, SB_REVISION_NONE);
+
+	id = g_hash_table_lookup (self->ids, name);
+	if (G_LIKELY (id)) {
+		return GPOINTER_TO_UINT (id) - 1;
+	}
+
+	copy = g_string_chunk_insert (self->strings, name);
+	g_hash_table_insert (self->ids, copy, GUINT_TO_POINTER (self->names->len + 1));
+
+	g_ptr_array_add     (self->names, copy);
+	g_array_append_val  (self->authors, none);
+	g_array_append_val  (self->author_times, zero);
+	g_array_append_val  (self->committer_times, zero);
+	g_array_append_val  (self->previous, none);
+	g_ptr_array_add     (self->revisions, NULL);
+
+	return self->names->len - 1;
+}
+
+guint
+sb_revision_table_lookup (SbRevisionTable const* self,
+			  gchar const          * name)
+{
+	g_return_val_if_fail (self, SB_REVISION_NONE);
+	g_return_val_if_fail (name, SB_REVISION_NONE);
+
+	return GPOINTER_TO_UINT (g_hash_table_lookup (self->ids, name)) - 1;
+}
+
+guint
+sb_revision_table_get_n_revisions (SbRevisionTable const* self)
+{
+	g_return_val_if_fail (self, 0);
+
+	return self->names->len;
+}
+
+gchar const*
+sb_revision_table_get_name (SbRevisionTable const* self,
+			    guint                  id)
+{
+	g_return_val_if_fail (self, NULL);
+	g_return_val_if_fail (id < self->names->len, NULL);
+
+	return g_ptr_array_index (self->names, id);
+}
+
+SbRevision*
+sb_revision_table_get_revision (SbRevisionTable* self,
+				guint            id)
+{
+	SbRevision* revision;
+
+	g_return_val_if_fail (self, NULL);
+	g_return_val_if_fail (id < self->names->len, NULL);
+
+	revision = g_ptr_array_index (self->revisions, id);
+	if (!revision) {
+		revision = sb_revision_new_for_table (self, id);
+		g_ptr_array_index (self->revisions, id) = revision;
+	}
+
+	return revision;
+}
+
+guint
+sb_revision_table_intern_author (SbRevisionTable* self,
+				 gchar const    * author)
+{
+	gpointer id;
+	gchar  * copy;
+
+	g_return_val_if_fail (self, SB_REVISION_NONE);
+	g_return_val_if_fail (author, SB_REVISION_NONE);
+
+	id = g_hash_table_lookup (self->author_ids, author);
+	if (G_LIKELY (id)) {
+		return GPOINTER_TO_UINT (id) - 1;
+	}
+
+	copy = g_string_chunk_insert (self->strings, author);
+	g_ptr_array_add (self->author_names, copy);
+	g_hash_table_insert (self->author_ids, copy, GUINT_TO_POINTER (self->author_names->len));
+
+	return self->author_names->len - 1;
+}
+
+guint
+sb_revision_table_lookup_author (SbRevisionTable const* self,
+				 gchar const          * author)
+{
+	g_return_val_if_fail (self, SB_REVISION_NONE);
+	g_return_val_if_fail (author, SB_REVISION_NONE);
+
+	return GPOINTER_TO_UINT (g_hash_table_lookup (self->author_ids, author)) - 1;
+}
+
+guint
+sb_revision_table_get_n_authors (SbRevisionTable const* self)
+{
+	g_return_val_if_fail (self, 0);
+
+	return self->author_names->len;
+}
+
+gchar const*
+sb_revision_table_get_author_name (SbRevisionTable const* self,
+				   guint                  author)
+{
+	g_return_val_if_fail (self, NULL);
+
+	if (author >= self->author_names->len) {
+		return NULL;
+	}
+
+	return g_ptr_array_index (self->author_names, author);
+}
+
+guint
+sb_revision_table_get_author (SbRevisionTable const* self,
+			      guint                  id)
+{
+	g_return_val_if_fail (self, SB_REVISION_NONE);
+	g_return_val_if_fail (id < self->names->len, SB_REVISION_NONE);
+
+	return g_array_index (self->authors, guint, id);
+}
+
+void
+sb_revision_table_set_author (SbRevisionTable* self,
+			      guint            id,
+			      gchar const    * author)
+{
+	g_return_if_fail (self);
+	g_return_if_fail (id < self->names->len);
+
+	g_array_index (self->authors, guint, id) = sb_revision_table_intern_author (self, author);
+}
+
+gint64
+sb_revision_table_get_author_time (SbRevisionTable const* self,
+				   guint                  id)
+{
+	g_return_val_if_fail (self, 0);
+	g_return_val_if_fail (id < self->names->len, 0);
+
+	return g_array_index (self->author_times, gint64, id);
+}
+
+void
+sb_revision_table_set_author_time (SbRevisionTable* self,
+				   guint            id,
+				   gint64           time)
+{
+	g_return_if_fail (self);
+	g_return_if_fail (id < self->names->len);
+
+	g_array_index (self->author_times, gint64, id) = time;
+}
+
+gint64
+sb_revision_table_get_committer_time (SbRevisionTable const* self,
+				      guint                  id)
+{
+	g_return_val_if_fail (self, 0);
+	g_return_val_if_fail (id < self->names->len, 0);
+
+	return g_array_index (self->committer_times, gint64, id);
+}
+
+void
+sb_revision_table_set_committer_time (SbRevisionTable* self,
+				      guint            id,
+				      gint64           time)
+{
+	g_return_if_fail (self);
+	g_return_if_fail (id < self->names->len);
+
+	g_array_index (self->committer_times, gint64, id) = time;
+}
+
+guint
+sb_revision_table_get_previous (SbRevisionTable const* self,
+				guint                  id)
+{
+	g_return_val_if_fail (self, SB_REVISION_NONE);
+	g_return_val_if_fail (id < self->names->len, SB_REVISION_NONE);
+
+	return g_array_index (self->previous, guint, id);
+}
+
+void
+sb_revision_table_set_previous (SbRevisionTable* self,
+				guint            id,
+				guint            previous)
+{
+	g_return_if_fail (self);
+	g_return_if_fail (id < self->names->len);
+
+	g_array_index (self->previous, guint, id) = previous;
+}
+
+guint const*
+sb_revision_table_get_authors (SbRevisionTable const* self)
+{
+	g_return_val_if_fail (self, NULL);
+
+	return (guint const*)self->authors->data;
+}
+
+gint64 const*
+sb_revision_table_get_author_times (SbRevisionTable const* self)
+{
+	g_return_val_if_fail (self, NULL);
+
+	return (gint64 const*)self->author_times->data;
+}
@@ -0,0 +1,80 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_REVISION_TABLE_H
+#define SB_REVISION_TABLE_H
+
+#include "sb-revision.h"
+
+G_BEGIN_DECLS
+
+#define SB_REVISION_NONE G_MAXUINT
+
+SbRevisionTable* sb_revision_table_new                (void);
+void             sb_revision_table_free               (SbRevisionTable      * self);
+guint            sb_revision_table_intern             (SbRevisionTable      * self,
+						       gchar const          * name);
+guint            sb_revision_table_lookup             (SbRevisionTable const* self,
+						       gchar const          * name);
+guint            sb_revision_table_get_n_revisions    (SbRevisionTable const* self);
+gchar const*     sb_revision_table_get_name           (SbRevisionTable const* self,
+						       guint                  id);
+SbRevision*      sb_revision_table_get_revision       (SbRevisionTable      * self,
+						       guint                  id);
+
+guint            sb_revision_table_intern_author      (SbRevisionTable      * self,
+						       gchar const          * author);
+guint            sb_revision_table_lookup_author      (SbRevisionTable const* self,
+						       gchar const          * author);
+guint            sb_revision_table_get_n_authors      (SbRevisionTable const* self);
+gchar const*     sb_revision_table_get_author_name    (SbRevisionTable const* self,
+						       guint                  author);
+
+guint            sb_revision_table_get_author         (SbRevisionTable const* self,
+						       guint                  id);
+void             sb_revision_table_set_author         (SbRevisionTable      * self,
+						       guint                  id,
+						       gchar const          * author);
+gint64           sb_revision_table_get_author_time    (SbRevisionTable const* self,
+						       guint                  id);
+void             sb_revision_table_set_author_time    (SbRevisionTable      * self,
+						       guint                  id,
+						       gint64                 time);
+gint64           sb_revision_table_get_committer_time (SbRevisionTable const* self,
+						       guint                  id);
+void             sb_revision_table_set_committer_time (SbRevisionTable      * self,
+						       guint                  id,
+						       gint64                 time);
+guint            sb_revision_table_get_previous       (SbRevisionTable const* self,
+						       guint                  id);
+void             sb_revision_table_set_previous       (SbRevisionTable      * self,
+						       guint                  id,
+						       guint                  previous);
+
+/* the columns, for scanning all revisions at once */
+guint const*     sb_revision_table_get_authors        (SbRevisionTable const* self);
+gint64 const*    sb_revision_table_get_author_times   (SbRevisionTable const* self);
+
+G_END_DECLS
+
+#endif /* !SB_REVISION_TABLE_H */
@@ -23,16 +23,28 @@
 
 #include "sb-revision.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "sb-comparable.h"
+#include "sb-revision-table.h"
 
 struct _SbRevisionPrivate {
-	gchar* name;
-	gchar* summary;
+	gchar          * name;
+	gchar          * summary;
+	gchar          * message;
+
+	/* author and dates live in the table */
+	SbRevisionTable* table;
+	guint            id;
 };
 
 enum {
 	PROP_0,
-	PROP_NAME
+	PROP_NAME,
+	PROP_SUMMARY,
+	PROP_AUTHOR,
+	PROP_MESSAGE
 };
 
 static void implement_comparable (SbComparableIface* iface);
@@ -45,6 +57,8 @@ sb_revision_init (SbRevision* self)
 	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
 						      SB_TYPE_REVISION,
 						      SbRevisionPrivate);
+
+	self->_private->id = SB_REVISION_NONE;
 }
 
 static void
@@ -54,6 +68,7 @@ revision_finalize (GObject* object)
 
 	g_free (self->_private->name);
 	g_free (self->_private->summary);
+	g_free (self->_private->message);
 
 	G_OBJECT_CLASS (sb_revision_parent_class)->finalize (object);
 }
@@ -70,6 +85,15 @@ revision_get_property (GObject   * object,
 	case PROP_NAME:
 		g_value_set_string (value, sb_revision_get_name (self));
 		break;
+	case PROP_SUMMARY:
+		g_value_set_string (value, sb_revision_get_summary (self));
+		break;
+	case PROP_AUTHOR:
+		g_value_set_string (value, sb_revision_get_author (self));
+		break;
+	case PROP_MESSAGE:
+		g_value_set_string (value, sb_revision_get_message (self));
+		break;
 	default:
 		G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
 		break;
@@ -108,6 +132,18 @@ sb_revision_class_init (SbRevisionClass* self_class)
 					 PROP_NAME,
 					 g_param_spec_string ("name", "name", "name",
 							      NULL, G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY));
+	g_object_class_install_property (object_class,
+					 PROP_SUMMARY,
+					 g_param_spec_string ("summary", "summary", "summary",
+							      NULL, G_PARAM_READABLE));
+	g_object_class_install_property (object_class,
+					 PROP_AUTHOR,
+					 g_param_spec_string ("author", "author", "author",
+							      NULL, G_PARAM_READABLE));
+	g_object_class_install_property (object_class,
+					 PROP_MESSAGE,
+					 g_param_spec_string ("message", "message", "message",
+							      NULL, G_PARAM_READABLE));
 
 	g_type_class_add_private (self_class, sizeof (SbRevisionPrivate));
 }
@@ -120,6 +156,47 @@ sb_revision_new (gchar const* name)
 			     NULL);
 }
 
+SbRevision*
+sb_revision_new_for_table (SbRevisionTable* table,
+			   guint            id)
+{
+	SbRevision* self;
+
+	g_return_val_if_fail (table, NULL);
+
+	self = sb_revision_new (sb_revision_table_get_name (table, id));
+	self->_private->table = table;
+	self->_private->id    = id;
+
+	return self;
+}
+
+SbRevisionTable*
+sb_revision_get_table (SbRevision const* self)
+{
+	g_return_val_if_fail (SB_IS_REVISION (self), NULL);
+
+	return self->_private->table;
+}
+
+guint
+sb_revision_get_id (SbRevision const* self)
+{
+	g_return_val_if_fail (SB_IS_REVISION (self), SB_REVISION_NONE);
+
+	return self->_private->id;
+}
+
+/* called by the table when it goes away before its revisions */
+void
+sb_revision_detach (SbRevision* self)
+{
+	g_return_if_fail (SB_IS_REVISION (self));
+
+	self->_private->table = NULL;
+	self->_private->id    = SB_REVISION_NONE;
+}
+
 gchar const*
 sb_revision_get_name (SbRevision const* self)
 {
@@ -149,8 +226,129 @@ sb_revision_set_summary (SbRevision * self,
 	g_free (self->_private->summary);
 	self->_private->summary = g_strdup (summary);
 
-	// FIXME: make a GObject property
-	// g_object_notify (G_OBJECT (self), "summary");
+	g_object_notify (G_OBJECT (self), "summary");
+}
+
+gchar const*
+sb_revision_get_author (SbRevision const* self)
+{
+	g_return_val_if_fail (SB_IS_REVISION (self), NULL);
+
+	if (!self->_private->table) {
+		return NULL;
+	}
+
+	return sb_revision_table_get_author_name (self->_private->table,
+						  sb_revision_table_get_author (self->_private->table,
+										self->_private->id));
+}
+
+gint64
+sb_revision_get_author_time (SbRevision const* self)
+{
+	g_return_val_if_fail (SB_IS_REVISION (self), 0);
+
+	if (!self->_private->table) {
+		return 0;
+	}
+
+	return sb_revision_table_get_author_time (self->_private->table,
+						  self->_private->id);
+}
+
+gchar const*
+sb_revision_get_message (SbRevision const* self)
+{
+	g_return_val_if_fail (SB_IS_REVISION (self), NULL);
+
+	return self->_private->message;
+}
+
+gboolean
+sb_revision_has_details (SbRevision const* self)
+{
+	g_return_val_if_fail (SB_IS_REVISION (self), FALSE);
+
+	return self->_private->message != NULL;
+}
+
+/* "Name <mail> 1234567890 +0100" */
+static void
+revision_parse_person (SbRevision * self,
+		       gchar const* person,
+		       gchar const* end,
+		       gboolean     author)
+{
+	gchar const* mail = memchr (person, '<', end - person);
+	gchar const* mail_end;
+	gint64       time = 0;
+
+	if (!mail || !self->_private->table) {
+		return;
+	}
+
+	mail_end = memchr (mail, '>', end - mail);
+	if (mail_end) {
+		time = g_ascii_strtoll (mail_end + 1, NULL, 10);
+	}
+
+	if (author) {
+		gchar* name = g_strndup (person, mail - person);
+
+		sb_revision_table_set_author      (self->_private->table, self->_private->id, g_strchomp (name));
+		sb_revision_table_set_author_time (self->_private->table, self->_private->id, time);
+		g_free (name);
+	} else {
+		sb_revision_table_set_committer_time (self->_private->table, self->_private->id, time);
+	}
+}
+
+void
+sb_revision_load_commit (SbRevision * self,
+			 gchar const* contents,
+			 gsize        length)
+{
+	gchar const* end = contents + length;
+	gchar const* line;
+
+	g_return_if_fail (SB_IS_REVISION (self));
+	g_return_if_fail (contents);
+
+	/* headers up to the first empty line, then the message */
+	for (line = contents; line < end; ) {
+		gchar const* eol = memchr (line, '\n', end - line);
+
+		if (!eol) {
+			eol = end;
+		}
+
+		if (eol == line) {
+			line++;
+			break;
+		}
+
+		if (eol - line > 7 && !strncmp (line, "author ", 7)) {
+			revision_parse_person (self, line + 7, eol, TRUE);
+		} else if (eol - line > 10 && !strncmp (line, "committer ", 10)) {
+			revision_parse_person (self, line + 10, eol, FALSE);
+		}
+
+		line = eol + 1;
+	}
+
+	g_free (self->_private->message);
+	self->_private->message = line < end ? g_strndup (line, end - line) : g_strdup ("");
+	g_strchomp (self->_private->message);
+
+	if (!self->_private->summary) {
+		gchar* summary = g_strndup (self->_private->message,
+					    strcspn (self->_private->message, "\n"));
+		sb_revision_set_summary (self, summary);
+		g_free (summary);
+	}
+
+	g_object_notify (G_OBJECT (self), "author");
+	g_object_notify (G_OBJECT (self), "message");
 }
 
 /* SbComparableIface */
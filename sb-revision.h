@@ -31,17 +31,30 @@ G_BEGIN_DECLS
 typedef struct _SbRevision        SbRevision;
 typedef struct _SbRevisionPrivate SbRevisionPrivate;
 typedef struct _SbRevisionClass   SbRevisionClass;
+typedef struct _SbRevisionTable   SbRevisionTable;
 
 #define SB_TYPE_REVISION         (sb_revision_get_type ())
 #define SB_REVISION(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_REVISION, SbRevision))
 #define SB_IS_REVISION(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_REVISION))
 
-GType        sb_revision_get_type    (void);
-SbRevision*  sb_revision_new         (gchar const     * name);
-gchar const* sb_revision_get_name    (SbRevision const* self);
-gchar const* sb_revision_get_summary (SbRevision const* self);
-void         sb_revision_set_summary (SbRevision      * self,
-				      gchar const     * summary);
+GType            sb_revision_get_type        (void);
+SbRevision*      sb_revision_new             (gchar const     * name);
+SbRevision*      sb_revision_new_for_table   (SbRevisionTable * table,
+					      guint             id);
+SbRevisionTable* sb_revision_get_table       (SbRevision const* self);
+guint            sb_revision_get_id          (SbRevision const* self);
+void             sb_revision_detach          (SbRevision      * self);
+gchar const*     sb_revision_get_name        (SbRevision const* self);
+gchar const*     sb_revision_get_summary     (SbRevision const* self);
+void             sb_revision_set_summary     (SbRevision      * self,
+					      gchar const     * summary);
+gchar const*     sb_revision_get_author      (SbRevision const* self);
+gint64           sb_revision_get_author_time (SbRevision const* self);
+gchar const*     sb_revision_get_message     (SbRevision const* self);
+gboolean         sb_revision_has_details     (SbRevision const* self);
+void             sb_revision_load_commit     (SbRevision      * self,
+					      gchar const     * contents,
+					      gsize             length);
 
 struct _SbRevision {
 	GObject            base_instance;
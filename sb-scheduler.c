@@ -0,0 +1,234 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-scheduler.h"
+
+#include <string.h>
+#include <unistd.h>
+
+/* Decides when the jobs get their processes. At most one process per
+ * core runs at a time; the others wait in one queue per priority, and
+ * the most important waiting job goes first.
+ *
+ * A job for the visible file doesn't wait for prefetching or indexing:
+ * one of those gets stopped (SIGSTOP) for it and continues when a slot
+ * is free again, ahead of the queued jobs of its priority. Nothing gets
+ * lost that way, while a cancelled blame would have to start over.
+ *
+ * Co-processes (jobs with SB_JOB_PIPE_STDIN) don't go through here.
+ */
+
+static struct {
+	guint            limit;
+	GQueue         * queued[SB_JOB_N_PRIORITIES];
+	GList          * running;
+	GList          * suspended;
+	SbSchedulerStats stats;
+} scheduler = {0};
+
+static void scheduler_job_done_cb (SbJob   * job,
+				   gpointer  unused);
+
+static void
+scheduler_ensure (void)
+{
+	glong cores;
+	guint i;
+
+	if (G_LIKELY (scheduler.limit)) {
+		return;
+	}
+
+	cores = sysconf (_SC_NPROCESSORS_ONLN);
+	scheduler.limit = cores > 0 ? cores : 1;
+	scheduler.stats.limit = scheduler.limit;
+
+	for (i = 0; i < SB_JOB_N_PRIORITIES; i++) {
+		scheduler.queued[i] = g_queue_new ();
+	}
+}
+
+static gboolean
+scheduler_spawn (SbJob  * job,
+		 GError **error)
+{
+	SbJobPriority priority = sb_job_get_priority (job);
+
+	if (!sb_job_spawn (job, error)) {
+		/* the job finishes on its own; nothing to keep track of */
+		return FALSE;
+	}
+
+	scheduler.running = g_list_prepend (scheduler.running, job);
+	scheduler.stats.running[priority]++;
+	scheduler.stats.spawned[priority]++;
+	scheduler.stats.total_wait[priority] += sb_job_get_wait (job);
+	scheduler.stats.max_wait[priority]    = MAX (scheduler.stats.max_wait[priority],
+						     sb_job_get_wait (job));
+
+	return TRUE;
+}
+
+/* the least important running job below @priority that may be stopped, or
+ * NULL */
+static SbJob*
+scheduler_find_victim (SbJobPriority priority)
+{
+	SbJob* result = NULL;
+	GList* iter;
+
+	for (iter = scheduler.running; iter; iter = iter->next) {
+		SbJobPriority candidate = sb_job_get_priority (iter->data);
+
+		if (candidate >= SB_JOB_PRIORITY_PREFETCH && candidate > priority &&
+		    sb_job_can_suspend (iter->data) &&
+		    (!result || candidate > sb_job_get_priority (result)))
+		{
+			result = iter->data;
+		}
+	}
+
+	return result;
+}
+
+static void
+scheduler_suspend (SbJob* job)
+{
+	SbJobPriority priority = sb_job_get_priority (job);
+
+	sb_job_suspend (job);
+	scheduler.running   = g_list_remove (scheduler.running, job);
+	scheduler.suspended = g_list_prepend (scheduler.suspended, job);
+	scheduler.stats.running[priority]--;
+	scheduler.stats.suspended[priority]++;
+}
+
+/* fill the free slots */
+static void
+scheduler_run (void)
+{
+	while (g_list_length (scheduler.running) < scheduler.limit) {
+		SbJobPriority priority;
+		SbJob       * next = NULL;
+		GList       * iter;
+		GError      * error = NULL;
+
+		for (priority = 0; priority < SB_JOB_N_PRIORITIES && !next; priority++) {
+			/* the stopped ones have done some work already */
+			for (iter = scheduler.suspended; iter; iter = iter->next) {
+				if (sb_job_get_priority (iter->data) == priority) {
+					next = iter->data;
+					break;
+				}
+			}
+
+			if (next) {
+				scheduler.suspended = g_list_remove (scheduler.suspended, next);
+				scheduler.running   = g_list_prepend (scheduler.running, next);
+				scheduler.stats.suspended[priority]--;
+				scheduler.stats.running[priority]++;
+				sb_job_resume (next);
+			} else if ((next = g_queue_pop_head (scheduler.queued[priority]))) {
+				scheduler.stats.queued[priority]--;
+				if (!scheduler_spawn (next, &error)) {
+					g_warning ("%s", error->message);
+					g_error_free (error);
+				}
+			}
+		}
+
+		if (!next) {
+			break;
+		}
+	}
+}
+
+/* starts @job as soon as there's room for it; the job emits "done"
+ * either way (also if it couldn't be started later on) */
+gboolean
+sb_scheduler_submit (SbJob  * job,
+		     GError **error)
+{
+	SbJobPriority priority;
+
+	g_return_val_if_fail (SB_IS_JOB (job), FALSE);
+
+	scheduler_ensure ();
+
+	priority = sb_job_get_priority (job);
+	g_signal_connect (g_object_ref (job), "done",
+			  G_CALLBACK (scheduler_job_done_cb), NULL);
+
+	if (g_list_length (scheduler.running) >= scheduler.limit && priority == SB_JOB_PRIORITY_VISIBLE) {
+		SbJob* victim = scheduler_find_victim (priority);
+
+		if (victim) {
+			scheduler_suspend (victim);
+		}
+	}
+
+	if (g_list_length (scheduler.running) < scheduler.limit) {
+		return scheduler_spawn (job, error);
+	}
+
+	g_queue_push_tail (scheduler.queued[priority], job);
+	scheduler.stats.queued[priority]++;
+
+	return TRUE;
+}
+
+static void
+scheduler_job_done_cb (SbJob   * job,
+		       gpointer  unused)
+{
+	SbJobPriority priority = sb_job_get_priority (job);
+	GList       * link;
+
+	if ((link = g_list_find (scheduler.running, job))) {
+		scheduler.running = g_list_delete_link (scheduler.running, link);
+		scheduler.stats.running[priority]--;
+	} else if ((link = g_list_find (scheduler.suspended, job))) {
+		scheduler.suspended = g_list_delete_link (scheduler.suspended, link);
+		scheduler.stats.suspended[priority]--;
+	} else if ((link = g_queue_find (scheduler.queued[priority], job))) {
+		/* cancelled while waiting */
+		g_queue_delete_link (scheduler.queued[priority], link);
+		scheduler.stats.queued[priority]--;
+	}
+
+	g_signal_handlers_disconnect_by_func (job, scheduler_job_done_cb, NULL);
+	g_object_unref (job);
+
+	scheduler_run ();
+}
+
+/* the queue depths and waiting times, for tuning */
+void
+sb_scheduler_get_stats (SbSchedulerStats* stats)
+{
+	g_return_if_fail (stats);
+
+	scheduler_ensure ();
+
+	memcpy (stats, &scheduler.stats, sizeof (SbSchedulerStats));
+}
@@ -0,0 +1,49 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_SCHEDULER_H
+#define SB_SCHEDULER_H
+
+#include "sb-job.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbSchedulerStats SbSchedulerStats;
+
+struct _SbSchedulerStats {
+	guint   limit;                           /* processes at once */
+	guint   queued[SB_JOB_N_PRIORITIES];
+	guint   running[SB_JOB_N_PRIORITIES];
+	guint   suspended[SB_JOB_N_PRIORITIES];
+	guint   spawned[SB_JOB_N_PRIORITIES];    /* since the start */
+	gdouble total_wait[SB_JOB_N_PRIORITIES]; /* seconds, of the spawned jobs */
+	gdouble max_wait[SB_JOB_N_PRIORITIES];
+};
+
+gboolean sb_scheduler_submit    (SbJob           * job,
+				 GError         ** error);
+void     sb_scheduler_get_stats (SbSchedulerStats* stats);
+
+G_END_DECLS
+
+#endif /* !SB_SCHEDULER_H */
@@ -23,41 +23,376 @@
 
 #include "sb-settings.h"
 
+#include <string.h>
+#include <gio/gio.h>
 #include <gconf/gconf-client.h>
 
-static GConfClient*
-get_client (void)
+/* All keys are read once into a snapshot and kept up to date by change
+ * notifications, so reading a setting never talks to the GConf daemon.
+ *
+ * Instead of GConf, a key file can be used (e.g. for headless use); it's
+ * picked either by sb_settings_use_key_file() or by pointing the
+ * SOURCE_BROWSER_SETTINGS environment variable to it.
+ */
+
+#define GCONF_DIR      "/apps/source-browser"
+#define KEY_FILE_GROUP "source-browser"
+
+typedef struct {
+	gchar const * name;
+	SbSettingsKey key;
+	gboolean      default_value;
+} BoolKey;
+
+static BoolKey const bool_keys[] = {
+	{"follow-copies",      SB_SETTINGS_FOLLOW_COPIES,      TRUE},
+	{"follow-moves",       SB_SETTINGS_FOLLOW_MOVES,       TRUE},
+	{"ignore-whitespaces", SB_SETTINGS_IGNORE_WHITESPACES, TRUE},
+	{"color-by-age",       SB_SETTINGS_COLOR_BY_AGE,       FALSE},
+	{"tint-lines",         SB_SETTINGS_TINT_LINES,         FALSE},
+	{"write-commit-graph", SB_SETTINGS_WRITE_COMMIT_GRAPH, TRUE},
+	{"show-churn",         SB_SETTINGS_SHOW_CHURN,         FALSE}
+};
+
+typedef struct {
+	guint            id;
+	SbSettingsNotify callback;
+	gpointer         user_data;
+} Listener;
+
+static struct {
+	gboolean      loaded;
+	guint         flags;
+
+	GConfClient * client;
+
+	gchar       * key_file_path;
+	GFileMonitor* key_file_monitor;
+
+	GList       * listeners;
+	guint         last_listener;
+} settings = {FALSE};
+
+static guint
+get_defaults (void)
+{
+	guint flags = 0;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (bool_keys); i++) {
+		if (bool_keys[i].default_value) {
+			flags |= bool_keys[i].key;
+		}
+	}
+
+	return flags;
+}
+
+static void
+settings_update (guint flags)
 {
-	static GConfClient* client = NULL;
+	guint  changed = flags ^ settings.flags;
+	GList* listeners;
+	GList* iter;
 
-	if (G_UNLIKELY (!client)) {
-		client = gconf_client_get_default ();
+	settings.flags = flags;
+
+	if (!changed) {
+		return;
 	}
 
-	return client;
+	/* copy the list, a listener might remove itself */
+	listeners = g_list_copy (settings.listeners);
+	for (iter = listeners; iter; iter = iter->next) {
+		Listener* listener = iter->data;
+
+		if (g_list_find (settings.listeners, listener)) {
+			listener->callback (changed, listener->user_data);
+		}
+	}
+	g_list_free (listeners);
+}
+
+/* GConf backend */
+static void
+gconf_notify_cb (GConfClient* client,
+		 guint        connection,
+		 GConfEntry * entry,
+		 gpointer     unused)
+{
+	gchar const* name  = gconf_entry_get_key (entry);
+	GConfValue * value = gconf_entry_get_value (entry);
+	guint        flags = settings.flags;
+	guint        i;
+
+	if (!g_str_has_prefix (name, GCONF_DIR "/")) {
+		return;
+	}
+	name += strlen (GCONF_DIR "/");
+
+	for (i = 0; i < G_N_ELEMENTS (bool_keys); i++) {
+		gboolean enabled;
+
+		if (strcmp (name, bool_keys[i].name)) {
+			continue;
+		}
+
+		if (value && value->type == GCONF_VALUE_BOOL) {
+			enabled = gconf_value_get_bool (value);
+		} else {
+			/* unset */
+			enabled = bool_keys[i].default_value;
+		}
+
+		if (enabled) {
+			flags |= bool_keys[i].key;
+		} else {
+			flags &= ~bool_keys[i].key;
+		}
+	}
+
+	settings_update (flags);
+}
+
+static guint
+gconf_load (void)
+{
+	guint flags = get_defaults ();
+	guint i;
+
+	if (!settings.client) {
+		settings.client = gconf_client_get_default ();
+		gconf_client_add_dir (settings.client,
+				      GCONF_DIR,
+				      GCONF_CLIENT_PRELOAD_ONELEVEL,
+				      NULL);
+		gconf_client_notify_add (settings.client,
+					 GCONF_DIR,
+					 gconf_notify_cb,
+					 NULL, NULL,
+					 NULL);
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (bool_keys); i++) {
+		gchar     * key   = g_strdup_printf ("%s/%s", GCONF_DIR, bool_keys[i].name);
+		GConfValue* value = gconf_client_get (settings.client, key, NULL);
+
+		if (value && value->type == GCONF_VALUE_BOOL) {
+			if (gconf_value_get_bool (value)) {
+				flags |= bool_keys[i].key;
+			} else {
+				flags &= ~bool_keys[i].key;
+			}
+		}
+
+		if (value) {
+			gconf_value_free (value);
+		}
+		g_free (key);
+	}
+
+	return flags;
+}
+
+/* key file backend */
+static guint
+key_file_load (void)
+{
+	GKeyFile* key_file = g_key_file_new ();
+	guint     flags    = get_defaults ();
+	guint     i;
+
+	if (!g_key_file_load_from_file (key_file, settings.key_file_path, G_KEY_FILE_NONE, NULL)) {
+		/* a missing file just means "use the defaults" */
+		g_key_file_free (key_file);
+		return flags;
+	}
+
+	for (i = 0; i < G_N_ELEMENTS (bool_keys); i++) {
+		GError * error   = NULL;
+		gboolean enabled = g_key_file_get_boolean (key_file,
+							   KEY_FILE_GROUP,
+							   bool_keys[i].name,
+							   &error);
+
+		if (error) {
+			g_error_free (error);
+			continue;
+		}
+
+		if (enabled) {
+			flags |= bool_keys[i].key;
+		} else {
+			flags &= ~bool_keys[i].key;
+		}
+	}
+
+	g_key_file_free (key_file);
+
+	return flags;
+}
+
+static void
+key_file_changed_cb (GFileMonitor    * monitor,
+		     GFile           * file,
+		     GFile           * other,
+		     GFileMonitorEvent event,
+		     gpointer          unused)
+{
+	switch (event) {
+	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+	case G_FILE_MONITOR_EVENT_CREATED:
+	case G_FILE_MONITOR_EVENT_DELETED:
+		settings_update (key_file_load ());
+		break;
+	default:
+		break;
+	}
+}
+
+static void
+key_file_watch (void)
+{
+	GFile* file = g_file_new_for_path (settings.key_file_path);
+
+	settings.key_file_monitor = g_file_monitor_file (file,
+							 G_FILE_MONITOR_NONE,
+							 NULL,
+							 NULL);
+	if (settings.key_file_monitor) {
+		g_signal_connect (settings.key_file_monitor, "changed",
+				  G_CALLBACK (key_file_changed_cb), NULL);
+	}
+
+	g_object_unref (file);
+}
+
+static inline void
+settings_ensure (void)
+{
+	if (G_LIKELY (settings.loaded)) {
+		return;
+	}
+
+	settings.loaded = TRUE;
+
+	if (!settings.key_file_path && g_getenv ("SOURCE_BROWSER_SETTINGS")) {
+		settings.key_file_path = g_strdup (g_getenv ("SOURCE_BROWSER_SETTINGS"));
+	}
+
+	if (settings.key_file_path) {
+		key_file_watch ();
+		settings.flags = key_file_load ();
+	} else {
+		settings.flags = gconf_load ();
+	}
+}
+
+void
+sb_settings_use_key_file (gchar const* path)
+{
+	g_return_if_fail (path);
+
+	if (settings.key_file_monitor) {
+		g_file_monitor_cancel (settings.key_file_monitor);
+		g_object_unref (settings.key_file_monitor);
+		settings.key_file_monitor = NULL;
+	}
+
+	g_free (settings.key_file_path);
+	settings.key_file_path = g_strdup (path);
+
+	if (settings.loaded) {
+		/* switching backends at runtime: tell everyone what's different */
+		key_file_watch ();
+		settings_update (key_file_load ());
+	}
+}
+
+guint
+sb_settings_get_flags (void)
+{
+	settings_ensure ();
+
+	return settings.flags;
 }
 
 gboolean
 sb_settings_get_follow_copies (void)
 {
-	return gconf_client_get_bool (get_client (),
-				      "/apps/source-browser/follow-copies",
-				      NULL);
+	return (sb_settings_get_flags () & SB_SETTINGS_FOLLOW_COPIES) != 0;
 }
 
 gboolean
 sb_settings_get_follow_moves (void)
 {
-	return gconf_client_get_bool (get_client (),
-				      "/apps/source-browser/follow-moves",
-				      NULL);
+	return (sb_settings_get_flags () & SB_SETTINGS_FOLLOW_MOVES) != 0;
 }
 
 gboolean
 sb_settings_get_ignore_whitespaces (void)
 {
-	return gconf_client_get_bool (get_client (),
-				      "/apps/source-browser/ignore-whitespaces",
-				      NULL);
+	return (sb_settings_get_flags () & SB_SETTINGS_IGNORE_WHITESPACES) != 0;
+}
+
+gboolean
+sb_settings_get_color_by_age (void)
+{
+	return (sb_settings_get_flags () & SB_SETTINGS_COLOR_BY_AGE) != 0;
+}
+
+gboolean
+sb_settings_get_tint_lines (void)
+{
+	return (sb_settings_get_flags () & SB_SETTINGS_TINT_LINES) != 0;
+}
+
+gboolean
+sb_settings_get_write_commit_graph (void)
+{
+	return (sb_settings_get_flags () & SB_SETTINGS_WRITE_COMMIT_GRAPH) != 0;
+}
+
+gboolean
+sb_settings_get_show_churn (void)
+{
+	return (sb_settings_get_flags () & SB_SETTINGS_SHOW_CHURN) != 0;
 }
 
+guint
+sb_settings_notify_add (SbSettingsNotify callback,
+			gpointer         user_data)
+{
+	Listener* listener;
+
+	g_return_val_if_fail (callback, 0);
+
+	settings_ensure ();
+
+	listener = g_slice_new (Listener);
+	listener->id        = ++settings.last_listener;
+	listener->callback  = callback;
+	listener->user_data = user_data;
+
+	settings.listeners = g_list_prepend (settings.listeners, listener);
+
+	return listener->id;
+}
+
+void
+sb_settings_notify_remove (guint id)
+{
+	GList* iter;
+
+	for (iter = settings.listeners; iter; iter = iter->next) {
+		Listener* listener = iter->data;
+
+		if (listener->id == id) {
+			settings.listeners = g_list_delete_link (settings.listeners, iter);
+			g_slice_free (Listener, listener);
+			return;
+		}
+	}
+
+	g_warning ("%s: no listener with id %u", G_STRFUNC, id);
+}
@@ -28,9 +28,35 @@
 
 G_BEGIN_DECLS
 
+typedef enum {
+	SB_SETTINGS_FOLLOW_COPIES      = 1 << 0,
+	SB_SETTINGS_FOLLOW_MOVES       = 1 << 1,
+	SB_SETTINGS_IGNORE_WHITESPACES = 1 << 2,
+	SB_SETTINGS_COLOR_BY_AGE       = 1 << 3,
+	SB_SETTINGS_TINT_LINES         = 1 << 4,
+	SB_SETTINGS_WRITE_COMMIT_GRAPH = 1 << 5,
+	SB_SETTINGS_SHOW_CHURN         = 1 << 6
+} SbSettingsKey;
+
+/* the keys which change the output of git-blame */
+#define SB_SETTINGS_BLAME_KEYS (SB_SETTINGS_FOLLOW_COPIES | SB_SETTINGS_FOLLOW_MOVES | SB_SETTINGS_IGNORE_WHITESPACES)
+
+typedef void (*SbSettingsNotify) (SbSettingsKey changed,
+				  gpointer      user_data);
+
+void      sb_settings_use_key_file           (gchar const     * path);
+guint     sb_settings_get_flags              (void);
 gboolean  sb_settings_get_follow_copies      (void);
 gboolean  sb_settings_get_follow_moves       (void);
 gboolean  sb_settings_get_ignore_whitespaces (void);
+gboolean  sb_settings_get_color_by_age       (void);
+gboolean  sb_settings_get_tint_lines         (void);
+gboolean  sb_settings_get_write_commit_graph (void);
+gboolean  sb_settings_get_show_churn         (void);
+
+guint     sb_settings_notify_add             (SbSettingsNotify  callback,
+					      gpointer          user_data);
+void      sb_settings_notify_remove          (guint             id);
 
 G_END_DECLS
 
@@ -0,0 +1,342 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-trend-chart.h"
+
+#include <string.h>
+#include <glib/gi18n.h>
+
+/* The samples of an SbTrend as a stacked area chart: time from left to
+ * right, one band per author with the lines they own. The MAX_AUTHORS
+ * authors with the most lines over all samples get a color each, the
+ * others share the gray band at the top. The names are listed above the
+ * chart and the dates of the first and the last sample below it.
+ */
+
+#define MAX_AUTHORS 7
+#define PADDING     4
+#define SWATCH      10
+
+static GdkColor const band_colors[] = {
+	{0, 0xfcfc, 0xe9e9, 0x4f4f}, // butter
+	{0, 0xfcfc, 0xafaf, 0x3e3e}, // orange
+	{0, 0xe9e9, 0xb9b9, 0x6e6e}, // chocolate
+	{0, 0x8a8a, 0xe2e2, 0x3434}, // chameleon
+	{0, 0x7272, 0x9f9f, 0xcfcf}, // sky blue
+	{0, 0xadad, 0x7f7f, 0xa8a8}, // plum
+	{0, 0xefef, 0x2929, 0x2929}, // scarlet red
+	{0, 0xbaba, 0xbdbd, 0xb6b6}  // aluminium, for the others
+};
+
+struct _SbTrendChartPrivate {
+	SbTrend* trend;
+};
+
+G_DEFINE_TYPE (SbTrendChart, sb_trend_chart, GTK_TYPE_DRAWING_AREA);
+
+static void
+sb_trend_chart_init (SbTrendChart* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_TREND_CHART,
+						      SbTrendChartPrivate);
+
+	gtk_widget_set_size_request (GTK_WIDGET (self), -1, 150);
+}
+
+static void
+trend_chart_finalize (GObject* object)
+{
+	SbTrendChart* self = SB_TREND_CHART (object);
+
+	g_signal_handlers_disconnect_by_func (self->_private->trend, gtk_widget_queue_draw, self);
+	g_object_unref (self->_private->trend);
+
+	G_OBJECT_CLASS (sb_trend_chart_parent_class)->finalize (object);
+}
+
+/* the lines of @author in @sample; the others for SB_REVISION_NONE */
+static guint
+trend_chart_get_lines (SbTrendChart* self,
+		       guint         sample,
+		       guint         author,
+		       guint const * top,
+		       guint         n_top)
+{
+	SbContributor* contributor = sb_trend_get_sample (self->_private->trend, sample);
+	guint const  * lines;
+	guint          n_authors;
+	guint          result;
+	guint          i;
+
+	lines = sb_contributor_get_author_lines (contributor, &n_authors);
+
+	if (author != SB_REVISION_NONE) {
+		return author < n_authors ? lines[author] : 0;
+	}
+
+	result = sb_contributor_get_n_lines (contributor);
+	for (i = 0; i < n_top; i++) {
+		result -= top[i] < n_authors ? lines[top[i]] : 0;
+	}
+
+	return result;
+}
+
+/* the authors with the most lines over all samples, the most first */
+static guint
+trend_chart_find_top (SbTrendChart    * self,
+		      SbRevisionTable** revisions,
+		      guint           * top)
+{
+	GArray* totals = g_array_new (FALSE, TRUE, sizeof (guint));
+	guint   n_top = 0;
+	guint   sample;
+	guint   i;
+
+	*revisions = NULL;
+
+	for (sample = 0; sample < sb_trend_get_n_samples (self->_private->trend); sample++) {
+		SbContributor* contributor = sb_trend_get_sample (self->_private->trend, sample);
+		guint const  * lines;
+		guint          n_authors;
+
+		if (!*revisions) {
+			*revisions = sb_contributor_get_revisions (contributor);
+		}
+
+		lines = sb_contributor_get_author_lines (contributor, &n_authors);
+		if (n_authors > totals->len) {
+			g_array_set_size (totals, n_authors);
+		}
+		for (i = 0; i < n_authors; i++) {
+			g_array_index (totals, guint, i) += lines[i];
+		}
+	}
+
+	/* few authors: a selection is fast enough */
+	for (n_top = 0; n_top < MAX_AUTHORS; n_top++) {
+		guint best = SB_REVISION_NONE;
+
+		for (i = 0; i < totals->len; i++) {
+			if (g_array_index (totals, guint, i) &&
+			    (best == SB_REVISION_NONE || g_array_index (totals, guint, i) > g_array_index (totals, guint, best)))
+			{
+				best = i;
+			}
+		}
+
+		if (best == SB_REVISION_NONE) {
+			break;
+		}
+
+		top[n_top] = best;
+		g_array_index (totals, guint, best) = 0;
+	}
+
+	g_array_free (totals, TRUE);
+
+	return n_top;
+}
+
+static void
+trend_chart_draw_legend (SbTrendChart   * self,
+			 cairo_t        * cr,
+			 SbRevisionTable* revisions,
+			 guint const    * top,
+			 guint            n_top,
+			 gint           * height)
+{
+	GtkWidget  * widget = GTK_WIDGET (self);
+	PangoLayout* layout = gtk_widget_create_pango_layout (widget, NULL);
+	gint         x      = PADDING;
+	guint        i;
+
+	*height = 0;
+
+	for (i = 0; i <= n_top; i++) {
+		gint width;
+		gint text_height;
+
+		pango_layout_set_text (layout,
+				       i < n_top ? sb_revision_table_get_author_name (revisions, top[i]) : _("Others"),
+				       -1);
+		pango_layout_get_pixel_size (layout, &width, &text_height);
+
+		gdk_cairo_set_source_color (cr, &band_colors[MIN (i, G_N_ELEMENTS (band_colors) - 1)]);
+		cairo_rectangle (cr, x, PADDING + (text_height - SWATCH) / 2, SWATCH, SWATCH);
+		cairo_fill (cr);
+		x += SWATCH + PADDING;
+
+		gdk_draw_layout (widget->window, widget->style->text_gc[GTK_WIDGET_STATE (widget)],
+				 x, PADDING, layout);
+		x += width + 3 * PADDING;
+
+		*height = MAX (*height, text_height + 2 * PADDING);
+	}
+
+	g_object_unref (layout);
+}
+
+static void
+trend_chart_draw_dates (SbTrendChart* self,
+			gint          bottom)
+{
+	GtkWidget  * widget = GTK_WIDGET (self);
+	PangoLayout* layout = gtk_widget_create_pango_layout (widget, NULL);
+	guint        n_samples = sb_trend_get_n_samples (self->_private->trend);
+	guint        samples[2] = {0, n_samples - 1};
+	guint        i;
+
+	for (i = 0; i < G_N_ELEMENTS (samples); i++) {
+		GDate date;
+		gchar text[32];
+		gint  width;
+		gint  height;
+
+		g_date_clear (&date, 1);
+		g_date_set_time_t (&date, sb_trend_get_sample_time (self->_private->trend, samples[i]));
+		g_date_strftime (text, sizeof (text), "%x", &date);
+
+		pango_layout_set_text (layout, text, -1);
+		pango_layout_get_pixel_size (layout, &width, &height);
+		gdk_draw_layout (widget->window, widget->style->text_gc[GTK_WIDGET_STATE (widget)],
+				 i ? widget->allocation.width - width - PADDING : PADDING,
+				 bottom + PADDING,
+				 layout);
+	}
+
+	g_object_unref (layout);
+}
+
+static gboolean
+trend_chart_expose_event (GtkWidget     * widget,
+			  GdkEventExpose* event)
+{
+	SbTrendChart   * self      = SB_TREND_CHART (widget);
+	guint            n_samples = sb_trend_get_n_samples (self->_private->trend);
+	SbRevisionTable* revisions;
+	guint            top[MAX_AUTHORS + 1];
+	guint            n_top;
+	guint          * below;    /* the stacked lines per sample */
+	guint            max_lines = 0;
+	gint             legend;
+	gint             date_height;
+	PangoLayout    * layout;
+	gdouble          chart_top;
+	gdouble          chart_height;
+	gdouble          step;
+	cairo_t        * cr;
+	guint            band;
+	guint            i;
+
+	if (n_samples < 2) {
+		return FALSE;
+	}
+
+	n_top = trend_chart_find_top (self, &revisions, top);
+	if (!revisions) {
+		return FALSE;
+	}
+	/* the others last */
+	top[n_top] = SB_REVISION_NONE;
+
+	for (i = 0; i < n_samples; i++) {
+		max_lines = MAX (max_lines, sb_contributor_get_n_lines (sb_trend_get_sample (self->_private->trend, i)));
+	}
+	if (!max_lines) {
+		return FALSE;
+	}
+
+	cr = gdk_cairo_create (widget->window);
+	gdk_cairo_rectangle (cr, &event->area);
+	cairo_clip (cr);
+
+	trend_chart_draw_legend (self, cr, revisions, top, n_top, &legend);
+
+	/* one line of text for the dates */
+	layout = gtk_widget_create_pango_layout (widget, "0");
+	pango_layout_get_pixel_size (layout, NULL, &date_height);
+	g_object_unref (layout);
+
+	chart_top    = legend;
+	chart_height = widget->allocation.height - legend - date_height - 2 * PADDING;
+	step         = (gdouble)(widget->allocation.width - 2 * PADDING) / (n_samples - 1);
+
+	below = g_new0 (guint, n_samples);
+	for (band = 0; band <= n_top; band++) {
+		/* the upper edge from left to right, the lower one back */
+		for (i = 0; i < n_samples; i++) {
+			guint lines = below[i] + trend_chart_get_lines (self, i, top[band], top, n_top);
+
+			cairo_line_to (cr,
+				       PADDING + i * step,
+				       chart_top + chart_height * (1.0 - (gdouble)lines / max_lines));
+		}
+		for (i = n_samples; i > 0; i--) {
+			cairo_line_to (cr,
+				       PADDING + (i - 1) * step,
+				       chart_top + chart_height * (1.0 - (gdouble)below[i - 1] / max_lines));
+			below[i - 1] += trend_chart_get_lines (self, i - 1, top[band], top, n_top);
+		}
+		cairo_close_path (cr);
+
+		gdk_cairo_set_source_color (cr, &band_colors[MIN (band, G_N_ELEMENTS (band_colors) - 1)]);
+		cairo_fill (cr);
+	}
+	g_free (below);
+
+	cairo_destroy (cr);
+
+	trend_chart_draw_dates (self, chart_top + chart_height);
+
+	return FALSE;
+}
+
+static void
+sb_trend_chart_class_init (SbTrendChartClass* self_class)
+{
+	GObjectClass  * object_class = G_OBJECT_CLASS (self_class);
+	GtkWidgetClass* widget_class = GTK_WIDGET_CLASS (self_class);
+
+	object_class->finalize     = trend_chart_finalize;
+
+	widget_class->expose_event = trend_chart_expose_event;
+
+	g_type_class_add_private (self_class, sizeof (SbTrendChartPrivate));
+}
+
+GtkWidget*
+sb_trend_chart_new (SbTrend* trend)
+{
+	SbTrendChart* self;
+
+	g_return_val_if_fail (SB_IS_TREND (trend), NULL);
+
+	self = g_object_new (SB_TYPE_TREND_CHART, NULL);
+	self->_private->trend = g_object_ref (trend);
+	g_signal_connect_swapped (trend, "changed",
+				  G_CALLBACK (gtk_widget_queue_draw), self);
+
+	return GTK_WIDGET (self);
+}
@@ -0,0 +1,57 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_TREND_CHART_H
+#define SB_TREND_CHART_H
+
+#include <gtk/gtk.h>
+#include "sb-trend.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbTrendChart        SbTrendChart;
+typedef struct _SbTrendChartPrivate SbTrendChartPrivate;
+typedef struct _SbTrendChartClass   SbTrendChartClass;
+
+#define SB_TYPE_TREND_CHART         (sb_trend_chart_get_type ())
+#define SB_TREND_CHART(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_TREND_CHART, SbTrendChart))
+#define SB_TREND_CHART_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_TREND_CHART, SbTrendChartClass))
+#define SB_IS_TREND_CHART(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_TREND_CHART))
+#define SB_IS_TREND_CHART_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_TREND_CHART))
+#define SB_TREND_CHART_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_TREND_CHART, SbTrendChartClass))
+
+GType      sb_trend_chart_get_type (void);
+GtkWidget* sb_trend_chart_new      (SbTrend* trend);
+
+struct _SbTrendChart {
+	GtkDrawingArea       base_instance;
+	SbTrendChartPrivate* _private;
+};
+
+struct _SbTrendChartClass {
+	GtkDrawingAreaClass  base_class;
+};
+
+G_END_DECLS
+
+#endif /* !SB_TREND_CHART_H */
@@ -0,0 +1,672 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#include "sb-trend.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "sb-git.h"
+#include "sb-scheduler.h"
+
+/* Ownership over time: the lines per author of a folder at a few points
+ * in time, without blaming every commit.
+ *
+ * "git rev-list --first-parent" finds the commits touching the folder
+ * in the time range (plus the last one before it). Each of the
+ * n_samples points in time uses the newest commit it has seen.
+ * "git ls-tree" lists the files of that commit, and each file gets
+ * blamed at that commit.
+ * A blame is keyed by its blob and path, so a file that didn't change
+ * between two samples is blamed once and counted in both. The blames
+ * run at indexing priority, as many at once as the scheduler allows.
+ * The cost grows with the samples and the changed files, not with the
+ * number of commits.
+ *
+ * Every sample is an SbContributor without a scan of its own.
+ */
+
+#define CHANGED_DELAY 250
+#define MAX_SIZE      (1 << 20)  /* bytes, as in the contributor scan */
+
+typedef struct {
+	gint64         time;
+	gchar        * commit;       /* NULL if the folder didn't exist yet */
+	SbContributor* contributor;
+} Sample;
+
+typedef struct {
+	SbTrend        * trend;
+	gchar          * path;       /* absolute */
+	gchar          * commit;
+	SbHistoryLoader* loader;     /* NULL until started */
+	GArray         * waiting;    /* of guint sample indices; NULL when done */
+} Blame;
+
+typedef struct {
+	gint64 time;
+	gchar* commit;
+} Commit;
+
+typedef enum {
+	PHASE_RANGE,     /* the commits in the time range */
+	PHASE_BASELINE,  /* the newest one before the range */
+	PHASE_TREES,     /* the files of each sample */
+	PHASE_DONE
+} Phase;
+
+struct _SbTrendPrivate {
+	gchar      * folder;
+	guint        flags;
+	gint64       since;
+	gint64       until;
+
+	GArray     * samples;   /* of Sample */
+	GArray     * commits;   /* of Commit, the newest first */
+
+	SbJob      * listing;   /* rev-list or ls-tree */
+	Phase        phase;
+	guint        listed;    /* the sample whose files are listed */
+
+	GHashTable * blames;    /* "blob:path" => Blame */
+	GQueue     * pending;   /* of Blame */
+	GList      * running;   /* of Blame */
+	guint        changed_timeout;
+};
+
+enum {
+	CHANGED,
+	DONE,
+	N_SIGNALS
+};
+
+static guint signals[N_SIGNALS] = {0};
+
+G_DEFINE_TYPE (SbTrend, sb_trend, G_TYPE_OBJECT);
+
+static void trend_list      (SbTrend* self);
+static void listing_done_cb (SbTrend* self,
+			     SbJob  * job);
+
+static void
+blame_free (gpointer data)
+{
+	Blame* blame = data;
+
+	if (blame->loader) {
+		g_signal_handlers_disconnect_matched (blame->loader, G_SIGNAL_MATCH_DATA,
+						      0, 0, NULL, NULL, blame);
+		sb_history_loader_cancel (blame->loader);
+		g_object_unref (blame->loader);
+	}
+	if (blame->waiting) {
+		g_array_free (blame->waiting, TRUE);
+	}
+	g_free (blame->path);
+	g_free (blame->commit);
+	g_slice_free (Blame, blame);
+}
+
+static void
+sb_trend_init (SbTrend* self)
+{
+	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
+						      SB_TYPE_TREND,
+						      SbTrendPrivate);
+
+	self->_private->samples = g_array_new (FALSE, TRUE, sizeof (Sample));
+	self->_private->commits = g_array_new (FALSE, TRUE, sizeof (Commit));
+	self->_private->blames  = g_hash_table_new_full (g_str_hash, g_str_equal,
+							 g_free,     blame_free);
+	self->_private->pending = g_queue_new ();
+}
+
+static void
+trend_clear (SbTrend* self)
+{
+	guint i;
+
+	for (i = 0; i < self->_private->samples->len; i++) {
+		Sample* sample = &g_array_index (self->_private->samples, Sample, i);
+
+		g_free (sample->commit);
+		g_object_unref (sample->contributor);
+	}
+	g_array_set_size (self->_private->samples, 0);
+
+	for (i = 0; i < self->_private->commits->len; i++) {
+		g_free (g_array_index (self->_private->commits, Commit, i).commit);
+	}
+	g_array_set_size (self->_private->commits, 0);
+
+	self->_private->phase  = PHASE_DONE;
+	self->_private->listed = 0;
+}
+
+static void
+trend_finalize (GObject* object)
+{
+	SbTrend* self = SB_TREND (object);
+
+	sb_trend_cancel (self);
+	trend_clear (self);
+
+	g_array_free (self->_private->samples, TRUE);
+	g_array_free (self->_private->commits, TRUE);
+	g_hash_table_destroy (self->_private->blames);
+	g_queue_free (self->_private->pending);
+	g_free (self->_private->folder);
+
+	G_OBJECT_CLASS (sb_trend_parent_class)->finalize (object);
+}
+
+static void
+sb_trend_class_init (SbTrendClass* self_class)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (self_class);
+
+	object_class->finalize = trend_finalize;
+
+	signals[CHANGED] = g_signal_new ("changed",
+					 SB_TYPE_TREND,
+					 G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbTrendClass, changed),
+					 NULL, NULL,
+					 g_cclosure_marshal_VOID__VOID,
+					 G_TYPE_NONE, 0);
+	signals[DONE]    = g_signal_new ("done",
+					 SB_TYPE_TREND,
+					 G_SIGNAL_RUN_LAST, G_STRUCT_OFFSET (SbTrendClass, done),
+					 NULL, NULL,
+					 g_cclosure_marshal_VOID__VOID,
+					 G_TYPE_NONE, 0);
+
+	g_type_class_add_private (self_class, sizeof (SbTrendPrivate));
+}
+
+SbTrend*
+sb_trend_new (void)
+{
+	return g_object_new (SB_TYPE_TREND, NULL);
+}
+
+static gboolean
+trend_changed_cb (gpointer data)
+{
+	SbTrend* self = SB_TREND (data);
+
+	self->_private->changed_timeout = 0;
+	g_signal_emit (self, signals[CHANGED], 0);
+
+	return FALSE;
+}
+
+static void
+trend_queue_changed (SbTrend* self)
+{
+	if (!self->_private->changed_timeout) {
+		self->_private->changed_timeout = g_timeout_add (CHANGED_DELAY, trend_changed_cb, self);
+	}
+}
+
+static void
+trend_finish (SbTrend* self)
+{
+	if (self->_private->changed_timeout) {
+		g_source_remove (self->_private->changed_timeout);
+		self->_private->changed_timeout = 0;
+	}
+
+	g_signal_emit (self, signals[CHANGED], 0);
+	g_signal_emit (self, signals[DONE],    0);
+}
+
+static void trend_run (SbTrend* self);
+
+static void
+loader_done_cb (SbHistoryLoader* loader,
+		Blame          * blame)
+{
+	SbTrend* self = blame->trend;
+	guint    i;
+
+	self->_private->running = g_list_remove (self->_private->running, blame);
+
+	if (sb_history_loader_get_references (loader)) {
+		for (i = 0; i < blame->waiting->len; i++) {
+			Sample* sample = &g_array_index (self->_private->samples, Sample,
+							 g_array_index (blame->waiting, guint, i));
+
+			sb_contributor_add_loader (sample->contributor, loader);
+		}
+		trend_queue_changed (self);
+	}
+
+	/* later samples with the same blob get counted right away */
+	g_signal_handlers_disconnect_by_func (loader, loader_done_cb, blame);
+	g_array_free (blame->waiting, TRUE);
+	blame->waiting = NULL;
+
+	trend_run (self);
+
+	if (sb_trend_is_done (self)) {
+		trend_finish (self);
+	}
+}
+
+static void
+trend_run (SbTrend* self)
+{
+	SbSchedulerStats stats;
+
+	sb_scheduler_get_stats (&stats);
+
+	while (g_list_length (self->_private->running) < stats.limit) {
+		Blame* blame = g_queue_pop_head (self->_private->pending);
+
+		if (!blame) {
+			break;
+		}
+
+		blame->loader = sb_history_loader_new (blame->path, self->_private->flags);
+		sb_history_loader_set_revision (blame->loader, blame->commit);
+		sb_history_loader_set_background (blame->loader, TRUE);
+		sb_history_loader_set_priority (blame->loader, SB_JOB_PRIORITY_INDEX);
+		if (!sb_history_loader_start (blame->loader, NULL)) {
+			g_array_free (blame->waiting, TRUE);
+			blame->waiting = NULL;
+			continue;
+		}
+
+		g_signal_connect (blame->loader, "done",
+				  G_CALLBACK (loader_done_cb), blame);
+		self->_private->running = g_list_prepend (self->_private->running, blame);
+	}
+}
+
+static void
+trend_stop_listing (SbTrend* self)
+{
+	if (!self->_private->listing) {
+		return;
+	}
+
+	g_signal_handlers_disconnect_matched (sb_job_get_reader (self->_private->listing), G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	g_signal_handlers_disconnect_matched (self->_private->listing, G_SIGNAL_MATCH_DATA,
+					      0, 0, NULL, NULL, self);
+	sb_job_cancel (self->_private->listing);
+	g_object_unref (self->_private->listing);
+	self->_private->listing = NULL;
+}
+
+/* "<mode> <type> <object> <size>\t<path>" */
+static void
+tree_read_lines_cb (SbAsyncReader    * reader,
+		    SbLineBatch const* batch,
+		    SbTrend          * self)
+{
+	guint   sample  = self->_private->listed;
+	Sample* current = &g_array_index (self->_private->samples, Sample, sample);
+	guint   i;
+
+	for (i = 0; i < batch->n_lines; i++) {
+		gchar ** fields;
+		gchar  * tab = strchr (batch->lines[i], '\t');
+		gchar  * key;
+		Blame  * blame;
+
+		if (!tab || tab[1] == '"') {
+			// FIXME: unquote the names with control characters
+			continue;
+		}
+		*tab = '\0';
+
+		fields = g_strsplit_set (batch->lines[i], " ", -1);
+		/* the size is right-aligned: skip the empty fields */
+		if (g_strv_length (fields) < 4 || strcmp (fields[1], "blob") ||
+		    strtoul (fields[g_strv_length (fields) - 1], NULL, 10) > MAX_SIZE)
+		{
+			g_strfreev (fields);
+			continue;
+		}
+
+		key   = g_strdup_printf ("%s:%s", fields[2], tab + 1);
+		blame = g_hash_table_lookup (self->_private->blames, key);
+		g_strfreev (fields);
+
+		if (!blame) {
+			blame          = g_slice_new0 (Blame);
+			blame->trend   = self;
+			blame->path    = g_build_filename (self->_private->folder, tab + 1, NULL);
+			blame->commit  = g_strdup (current->commit);
+			blame->waiting = g_array_new (FALSE, FALSE, sizeof (guint));
+			g_hash_table_insert (self->_private->blames, key, blame);
+			g_queue_push_tail (self->_private->pending, blame);
+		} else {
+			g_free (key);
+		}
+
+		if (blame->waiting) {
+			g_array_append_val (blame->waiting, sample);
+		} else if (blame->loader && sb_history_loader_get_references (blame->loader)) {
+			sb_contributor_add_loader (current->contributor, blame->loader);
+			trend_queue_changed (self);
+		}
+	}
+
+	trend_run (self);
+}
+
+/* "<timestamp> <commit>" */
+static void
+commits_read_lines_cb (SbAsyncReader    * reader,
+		       SbLineBatch const* batch,
+		       SbTrend          * self)
+{
+	guint i;
+
+	for (i = 0; i < batch->n_lines; i++) {
+		gchar* space = strchr (batch->lines[i], ' ');
+		Commit commit;
+
+		if (!space) {
+			continue;
+		}
+
+		commit.time   = g_ascii_strtoll (batch->lines[i], NULL, 10);
+		commit.commit = g_strdup (space + 1);
+		g_array_append_val (self->_private->commits, commit);
+	}
+}
+
+static gint
+compare_commits (gconstpointer a,
+		 gconstpointer b)
+{
+	gint64 time_a = ((Commit const*)a)->time;
+	gint64 time_b = ((Commit const*)b)->time;
+
+	/* the newest first */
+	return time_a < time_b ? 1 : time_a > time_b ? -1 : 0;
+}
+
+/* the newest commit at each point in time */
+static void
+trend_pick_commits (SbTrend* self)
+{
+	guint i;
+
+	g_array_sort (self->_private->commits, compare_commits);
+
+	for (i = 0; i < self->_private->samples->len; i++) {
+		Sample* sample = &g_array_index (self->_private->samples, Sample, i);
+		guint   j;
+
+		for (j = 0; j < self->_private->commits->len; j++) {
+			Commit const* commit = &g_array_index (self->_private->commits, Commit, j);
+
+			if (commit->time <= sample->time) {
+				sample->commit = g_strdup (commit->commit);
+				break;
+			}
+		}
+	}
+}
+
+/* runs git @command in the folder; NULL terminated */
+static gboolean
+trend_start_listing (SbTrend    * self,
+		     GCallback    read_lines,
+		     gchar const* command,
+		     ...)
+{
+	GPtrArray  * arguments = g_ptr_array_new ();
+	gchar const* argument;
+	GError     * error = NULL;
+	va_list      argv;
+
+	/* the paths unquoted unless really strange, like the ownership scan */
+	g_ptr_array_add (arguments, "-c");
+	g_ptr_array_add (arguments, "core.quotePath=false");
+	g_ptr_array_add (arguments, (gpointer)command);
+	va_start (argv, command);
+	while ((argument = va_arg (argv, gchar const*))) {
+		g_ptr_array_add (arguments, (gpointer)argument);
+	}
+	va_end (argv);
+	g_ptr_array_add (arguments, NULL);
+
+	self->_private->listing = sb_git_job_newv (self->_private->folder, 0,
+						   (gchar const* const*)arguments->pdata);
+	g_ptr_array_free (arguments, TRUE);
+
+	sb_job_set_priority (self->_private->listing, SB_JOB_PRIORITY_INDEX);
+	if (!sb_job_start (self->_private->listing, &error)) {
+		g_warning ("couldn't run git %s: %s", command, error->message);
+		g_error_free (error);
+		g_object_unref (self->_private->listing);
+		self->_private->listing = NULL;
+		return FALSE;
+	}
+
+	g_signal_connect (sb_job_get_reader (self->_private->listing), "read-lines",
+			  read_lines, self);
+	g_signal_connect_swapped (self->_private->listing, "done",
+				  G_CALLBACK (listing_done_cb), self);
+
+	return TRUE;
+}
+
+/* starts the listing of the current phase */
+static void
+trend_list (SbTrend* self)
+{
+	gboolean started = FALSE;
+	gchar  * age;
+
+	switch (self->_private->phase) {
+	case PHASE_RANGE:
+		age = g_strdup_printf ("--max-age=%" G_GINT64_FORMAT, self->_private->since);
+		started = trend_start_listing (self, G_CALLBACK (commits_read_lines_cb),
+					       "rev-list", "--first-parent", "--timestamp",
+					       age, "HEAD", "--", ".", NULL);
+		g_free (age);
+		break;
+	case PHASE_BASELINE:
+		/* the state of the folder at the start of the range */
+		age = g_strdup_printf ("--min-age=%" G_GINT64_FORMAT, self->_private->since);
+		started = trend_start_listing (self, G_CALLBACK (commits_read_lines_cb),
+					       "rev-list", "-1", "--first-parent", "--timestamp",
+					       age, "HEAD", "--", ".", NULL);
+		g_free (age);
+		break;
+	case PHASE_TREES:
+		/* samples without a commit stay empty */
+		while (self->_private->listed < self->_private->samples->len &&
+		       !g_array_index (self->_private->samples, Sample, self->_private->listed).commit)
+		{
+			self->_private->listed++;
+		}
+
+		if (self->_private->listed < self->_private->samples->len) {
+			started = trend_start_listing (self, G_CALLBACK (tree_read_lines_cb),
+						       "ls-tree", "-r", "-l",
+						       g_array_index (self->_private->samples, Sample,
+								      self->_private->listed).commit,
+						       "--", ".", NULL);
+		}
+		break;
+	case PHASE_DONE:
+		break;
+	}
+
+	if (!started) {
+		self->_private->phase = PHASE_DONE;
+
+		if (sb_trend_is_done (self)) {
+			trend_finish (self);
+		}
+	}
+}
+
+static void
+listing_done_cb (SbTrend* self,
+		 SbJob  * job)
+{
+	trend_stop_listing (self);
+
+	switch (self->_private->phase) {
+	case PHASE_RANGE:
+		self->_private->phase = PHASE_BASELINE;
+		break;
+	case PHASE_BASELINE:
+		trend_pick_commits (self);
+		self->_private->phase  = PHASE_TREES;
+		self->_private->listed = 0;
+		break;
+	case PHASE_TREES:
+		self->_private->listed++;
+		break;
+	case PHASE_DONE:
+		g_assert_not_reached ();
+	}
+
+	trend_list (self);
+}
+
+/* samples the ownership of everything below @folder at @n_samples points
+ * in time, evenly spread from @since to @until (in seconds since the
+ * epoch); flags are the SbSettingsKeys for git blame */
+gboolean
+sb_trend_start (SbTrend    * self,
+		gchar const* folder,
+		gint64       since,
+		gint64       until,
+		guint        n_samples,
+		guint        flags,
+		GError    ** error)
+{
+	guint i;
+
+	g_return_val_if_fail (SB_IS_TREND (self), FALSE);
+	g_return_val_if_fail (folder && g_path_is_absolute (folder), FALSE);
+	g_return_val_if_fail (since < until && n_samples > 0, FALSE);
+
+	sb_trend_cancel (self);
+	trend_clear (self);
+
+	g_free (self->_private->folder);
+	self->_private->folder = g_strdup (folder);
+	self->_private->flags  = flags;
+	self->_private->since  = since;
+	self->_private->until  = until;
+
+	/* the last one at @until */
+	for (i = 0; i < n_samples; i++) {
+		Sample sample = {0};
+
+		sample.time        = since + (until - since) * (i + 1) / n_samples;
+		sample.contributor = sb_contributor_new ();
+		g_array_append_val (self->_private->samples, sample);
+	}
+
+	self->_private->phase = PHASE_RANGE;
+	trend_list (self);
+
+	if (self->_private->phase == PHASE_DONE) {
+		g_set_error (error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED,
+			     "couldn't run git rev-list in %s", folder);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+void
+sb_trend_cancel (SbTrend* self)
+{
+	g_return_if_fail (SB_IS_TREND (self));
+
+	trend_stop_listing (self);
+	self->_private->phase = PHASE_DONE;
+
+	/* the finished blames go as well: the next start samples other
+	 * commits */
+	g_queue_clear (self->_private->pending);
+	g_list_free (self->_private->running);
+	self->_private->running = NULL;
+	g_hash_table_remove_all (self->_private->blames);
+
+	if (self->_private->changed_timeout) {
+		g_source_remove (self->_private->changed_timeout);
+		self->_private->changed_timeout = 0;
+	}
+}
+
+gboolean
+sb_trend_is_done (SbTrend const* self)
+{
+	g_return_val_if_fail (SB_IS_TREND (self), FALSE);
+
+	return self->_private->phase == PHASE_DONE && !self->_private->running &&
+	       g_queue_is_empty (self->_private->pending);
+}
+
+guint
+sb_trend_get_n_samples (SbTrend const* self)
+{
+	g_return_val_if_fail (SB_IS_TREND (self), 0);
+
+	return self->_private->samples->len;
+}
+
+gint64
+sb_trend_get_sample_time (SbTrend const* self,
+			  guint          sample)
+{
+	g_return_val_if_fail (SB_IS_TREND (self), 0);
+	g_return_val_if_fail (sample < self->_private->samples->len, 0);
+
+	return g_array_index (self->_private->samples, Sample, sample).time;
+}
+
+/* NULL if the folder didn't exist at that time */
+gchar const*
+sb_trend_get_sample_commit (SbTrend const* self,
+			    guint          sample)
+{
+	g_return_val_if_fail (SB_IS_TREND (self), NULL);
+	g_return_val_if_fail (sample < self->_private->samples->len, NULL);
+
+	return g_array_index (self->_private->samples, Sample, sample).commit;
+}
+
+SbContributor*
+sb_trend_get_sample (SbTrend const* self,
+		     guint          sample)
+{
+	g_return_val_if_fail (SB_IS_TREND (self), NULL);
+	g_return_val_if_fail (sample < self->_private->samples->len, NULL);
+
+	return g_array_index (self->_private->samples, Sample, sample).contributor;
+}
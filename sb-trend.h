@@ -0,0 +1,76 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <sven@imendio.com>
+ *
+ * Copyright (C) 2008  Sven Herzberg
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307
+ * USA
+ */
+
+#ifndef SB_TREND_H
+#define SB_TREND_H
+
+#include "sb-contributor.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SbTrend        SbTrend;
+typedef struct _SbTrendPrivate SbTrendPrivate;
+typedef struct _SbTrendClass   SbTrendClass;
+
+#define SB_TYPE_TREND         (sb_trend_get_type ())
+#define SB_TREND(i)           (G_TYPE_CHECK_INSTANCE_CAST ((i), SB_TYPE_TREND, SbTrend))
+#define SB_TREND_CLASS(c)     (G_TYPE_CHECK_CLASS_CAST ((c), SB_TYPE_TREND, SbTrendClass))
+#define SB_IS_TREND(i)        (G_TYPE_CHECK_INSTANCE_TYPE ((i), SB_TYPE_TREND))
+#define SB_IS_TREND_CLASS(c)  (G_TYPE_CHECK_CLASS_TYPE ((c), SB_TYPE_TREND))
+#define SB_TREND_GET_CLASS(i) (G_TYPE_INSTANCE_GET_CLASS ((i), SB_TYPE_TREND, SbTrendClass))
+
+GType          sb_trend_get_type          (void);
+SbTrend*       sb_trend_new               (void);
+gboolean       sb_trend_start             (SbTrend      * self,
+					   gchar const  * folder,
+					   gint64         since,
+					   gint64         until,
+					   guint          n_samples,
+					   guint          flags,
+					   GError      ** error);
+void           sb_trend_cancel            (SbTrend      * self);
+gboolean       sb_trend_is_done           (SbTrend const* self);
+guint          sb_trend_get_n_samples     (SbTrend const* self);
+gint64         sb_trend_get_sample_time   (SbTrend const* self,
+					   guint          sample);
+gchar const*   sb_trend_get_sample_commit (SbTrend const* self,
+					   guint          sample);
+SbContributor* sb_trend_get_sample        (SbTrend const* self,
+					   guint          sample);
+
+struct _SbTrend {
+	GObject         base_instance;
+	SbTrendPrivate* _private;
+};
+
+struct _SbTrendClass {
+	GObjectClass    base_class;
+
+	/* signals */
+	void (*changed) (SbTrend* self);
+	void (*done)    (SbTrend* self);
+};
+
+G_END_DECLS
+
+#endif /* !SB_TREND_H */
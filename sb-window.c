@@ -24,14 +24,51 @@
 #include "sb-window.h"
 
 #include "sb-display.h"
+#include "sb-file-history.h"
+#include "sb-folder-view.h"
+#include "sb-ownership-view.h"
 #include "sb-progress.h"
+#include "sb-quick-open.h"
+#include "sb-settings.h"
 #include "sb-statusbar.h"
+#include "sb-trend-chart.h"
+#include <time.h>
+#include <gdk/gdkkeysyms.h>
 #include <glib/gi18n.h>
 
+/* the ownership trend: a sample per two months */
+#define TREND_SAMPLES 12
+#define TREND_RANGE   (2 * 365 * 24 * 60 * 60)
+
 struct _SbWindowPrivate {
 	GtkWidget* chooser;
+	GtkWidget* back;
 	GtkWidget* progress;
 	GtkWidget* status;
+
+	/* the revisions of the shown file, the working copy last */
+	GtkWidget    * slider;
+	GtkWidget    * slider_box;
+	GtkWidget    * slider_label;
+	SbFileHistory* file_history;
+	gchar        * file;      /* the working copy the history belongs to */
+	gboolean       syncing;   /* the slider follows the display */
+
+	/* the folder of the shown file, with the last commits */
+	GtkWidget    * files;
+	GtkWidget    * folder_view;
+	gchar        * browsed;   /* the folder last put into the view */
+
+	/* who owns the folder of the shown file */
+	GtkWidget    * ownership;
+	SbContributor* contributor;
+	gchar        * folder;
+	gchar        * scanned;   /* the folder of the last scan */
+
+	/* and how that changed */
+	GtkWidget    * history;
+	SbTrend      * trend;
+	gchar        * sampled;   /* the folder of the last trend */
 #ifdef HAVE_PLATFORM_OSX
 	GtkWidget* quit_item;
 #endif
@@ -49,6 +86,219 @@ chooser_selection_changed_cb (GtkFileChooser* chooser,
 	g_free (path);
 }
 
+static void
+window_update_slider_label (SbWindow* self,
+			    guint     index)
+{
+	SbFileHistory* history = self->_private->file_history;
+	gchar        * text;
+
+	if (index < sb_file_history_get_n_revisions (history)) {
+		time_t    time = sb_file_history_get_time (history, index);
+		struct tm tm;
+		gchar     date[32];
+
+		strftime (date, sizeof (date), "%Y-%m-%d", localtime_r (&time, &tm));
+		text = g_strdup_printf ("%s %.8s", date, sb_file_history_get_revision (history, index));
+	} else {
+		text = g_strdup (_("Working Copy"));
+	}
+
+	gtk_label_set_text (GTK_LABEL (self->_private->slider_label), text);
+	g_free (text);
+}
+
+/* moves the slider to the revision shown, e.g. after going back */
+static void
+window_sync_slider (SbWindow * self,
+		    SbDisplay* display)
+{
+	SbFileHistory* history  = self->_private->file_history;
+	gchar const  * revision = sb_display_get_revision (display);
+	guint          n_revisions;
+	guint          index;
+
+	if (!history || !sb_file_history_is_done (history)) {
+		return;
+	}
+
+	n_revisions = sb_file_history_get_n_revisions (history);
+	for (index = 0; revision && index < n_revisions; index++) {
+		if (!g_strcmp0 (revision, sb_file_history_get_revision (history, index))) {
+			break;
+		}
+	}
+	if (index >= n_revisions && revision) {
+		/* drilled down to a revision that didn't touch the file */
+		return;
+	}
+
+	self->_private->syncing = TRUE;
+	gtk_range_set_value (GTK_RANGE (self->_private->slider), index);
+	self->_private->syncing = FALSE;
+	window_update_slider_label (self, index);
+}
+
+/* which revision is shown, and whether there's a way back */
+static void
+window_update_location (SbWindow * self,
+			SbDisplay* display)
+{
+	GtkStatusbar* statusbar = GTK_STATUSBAR (self->_private->status);
+	guint         context   = gtk_statusbar_get_context_id (statusbar, "revision");
+
+	gtk_widget_set_sensitive (self->_private->back, sb_display_can_go_back (display));
+	window_sync_slider (self, display);
+
+	gtk_statusbar_pop (statusbar, context);
+	if (sb_display_get_revision (display)) {
+		gchar* message = g_strdup_printf (_("Showing revision %.8s"), sb_display_get_revision (display));
+		gtk_statusbar_push (statusbar, context, message);
+		g_free (message);
+	}
+}
+
+static void
+slider_value_changed_cb (GtkRange* range,
+			 SbWindow* self)
+{
+	SbFileHistory* history = self->_private->file_history;
+	SbDisplay    * display = SB_DISPLAY (sb_window_get_display (GTK_WIDGET (self)));
+	guint          index   = (guint) (gtk_range_get_value (range) + 0.5);
+	guint          n_revisions;
+
+	if (self->_private->syncing || !history || !sb_file_history_is_done (history)) {
+		return;
+	}
+
+	n_revisions = sb_file_history_get_n_revisions (history);
+
+	if (index < n_revisions && sb_display_has_edits (display)) {
+		GtkStatusbar* statusbar = GTK_STATUSBAR (self->_private->status);
+		guint         context   = gtk_statusbar_get_context_id (statusbar, "edits");
+
+		/* a past revision would replace the edits */
+		window_sync_slider (self, display);
+		gtk_statusbar_pop (statusbar, context);
+		gtk_statusbar_push (statusbar, context, _("The edits would get lost; the working copy stays"));
+		return;
+	}
+
+	window_update_slider_label (self, index);
+
+	if (index < n_revisions) {
+		if (g_strcmp0 (sb_display_get_revision (display), sb_file_history_get_revision (history, index))) {
+			sb_display_load_revision (display,
+						  sb_file_history_get_path (history, index),
+						  sb_file_history_get_revision (history, index),
+						  0);
+		}
+	} else if (sb_display_get_revision (display)) {
+		GError* error = NULL;
+
+		sb_display_load_path (display, self->_private->file, &error);
+		if (error) {
+			// FIXME: open popup
+			g_warning ("%s", error->message);
+			g_error_free (error);
+		}
+	}
+
+	/* the next step is likely to go either way */
+	if (index > 0) {
+		sb_display_prefetch_revision (display,
+					      sb_file_history_get_path (history, index - 1),
+					      sb_file_history_get_revision (history, index - 1));
+	}
+	if (index + 1 < n_revisions) {
+		sb_display_prefetch_revision (display,
+					      sb_file_history_get_path (history, index + 1),
+					      sb_file_history_get_revision (history, index + 1));
+	}
+}
+
+static void
+file_history_done_cb (SbFileHistory* history,
+		      SbWindow     * self)
+{
+	guint n_revisions = sb_file_history_get_n_revisions (history);
+
+	if (!n_revisions) {
+		gtk_widget_hide (self->_private->slider_box);
+		return;
+	}
+
+	self->_private->syncing = TRUE;
+	gtk_range_set_range (GTK_RANGE (self->_private->slider), 0, n_revisions);
+	gtk_range_set_value (GTK_RANGE (self->_private->slider), n_revisions);
+	self->_private->syncing = FALSE;
+	window_update_slider_label (self, n_revisions);
+	gtk_widget_show (self->_private->slider_box);
+
+	/* the first step back */
+	sb_display_prefetch_revision (SB_DISPLAY (sb_window_get_display (GTK_WIDGET (self))),
+				      sb_file_history_get_path (history, n_revisions - 1),
+				      sb_file_history_get_revision (history, n_revisions - 1));
+}
+
+static void
+window_stop_file_history (SbWindow* self)
+{
+	if (!self->_private->file_history) {
+		return;
+	}
+
+	g_signal_handlers_disconnect_by_func (self->_private->file_history,
+					      file_history_done_cb, self);
+	sb_file_history_cancel (self->_private->file_history);
+	g_object_unref (self->_private->file_history);
+	self->_private->file_history = NULL;
+}
+
+static void
+window_load_file_history (SbWindow* self)
+{
+	GError* error = NULL;
+
+	window_stop_file_history (self);
+	gtk_widget_hide (self->_private->slider_box);
+
+	self->_private->file_history = sb_file_history_new (self->_private->file);
+	g_signal_connect (self->_private->file_history, "done",
+			  G_CALLBACK (file_history_done_cb), self);
+	if (!sb_file_history_start (self->_private->file_history, &error)) {
+		// FIXME: report the error to the user
+		g_warning ("%s", error->message);
+		g_error_free (error);
+		window_stop_file_history (self);
+	}
+}
+
+/* the view stays where the user went until another file gets opened */
+static void
+window_update_files (SbWindow* self)
+{
+	SbFolderView* view = SB_FOLDER_VIEW (self->_private->folder_view);
+
+	if (!gtk_expander_get_expanded (GTK_EXPANDER (self->_private->files)) ||
+	    !self->_private->folder)
+	{
+		return;
+	}
+
+	if (!g_strcmp0 (self->_private->folder, self->_private->browsed)) {
+		/* the last commits change with HEAD; nothing happens if they
+		 * are current */
+		sb_folder_view_set_folder (view, sb_folder_view_get_folder (view));
+		return;
+	}
+
+	g_free (self->_private->browsed);
+	self->_private->browsed = g_strdup (self->_private->folder);
+
+	sb_folder_view_set_folder (view, self->_private->folder);
+}
+
 static void
 display_load_started_cb (SbDisplay* display,
 			 GtkWidget* window)
@@ -59,6 +309,8 @@ display_load_started_cb (SbDisplay* display,
 
 	// FIXME: this is a bug in GtkTextView (it doesn't swallow the trailing \n)
 	sb_progress_set_status (SB_PROGRESS (sb_window_get_status (window)), 1);
+
+	window_update_location (SB_WINDOW (window), display);
 }
 
 static void
@@ -74,7 +326,132 @@ static void
 display_load_done_cb (SbDisplay* display,
 		      SbWindow * self)
 {
+	GtkStatusbar* statusbar = GTK_STATUSBAR (self->_private->status);
+	guint         context   = gtk_statusbar_get_context_id (statusbar, "blame-times");
+	gdouble       before;
+	gdouble       after;
+
 	gtk_widget_hide (sb_window_get_status (GTK_WIDGET (self)));
+
+	gtk_statusbar_pop (statusbar, context);
+	if (sb_display_get_blame_times (display, &before, &after)) {
+		gchar* message = g_strdup_printf (_("Annotated in %.2fs (%.2fs without the commit-graph)"),
+						  after, before);
+		gtk_statusbar_push (statusbar, context, message);
+		g_free (message);
+	}
+
+	/* e.g. after a commit */
+	window_update_files (self);
+}
+
+static void
+display_file_changed_cb (SbDisplay* display,
+			 SbWindow * self)
+{
+	GtkStatusbar* statusbar = GTK_STATUSBAR (self->_private->status);
+	guint         context   = gtk_statusbar_get_context_id (statusbar, "file-changed");
+
+	gtk_statusbar_pop (statusbar, context);
+	gtk_statusbar_push (statusbar, context, _("The file changed on disk; the edits are kept"));
+}
+
+/* scans only while the panel is open, and each folder only once */
+static void
+window_update_ownership (SbWindow* self)
+{
+	GError* error = NULL;
+
+	if (!gtk_expander_get_expanded (GTK_EXPANDER (self->_private->ownership)) ||
+	    !self->_private->folder ||
+	    !g_strcmp0 (self->_private->folder, self->_private->scanned))
+	{
+		return;
+	}
+
+	g_free (self->_private->scanned);
+	self->_private->scanned = g_strdup (self->_private->folder);
+
+	/* copy and move detection would take hours for a whole tree */
+	if (!sb_contributor_scan (self->_private->contributor,
+				  self->_private->folder,
+				  sb_settings_get_flags () & SB_SETTINGS_IGNORE_WHITESPACES,
+				  &error))
+	{
+		g_warning ("couldn't list the files of %s: %s", self->_private->folder, error->message);
+		g_error_free (error);
+	}
+}
+
+static void
+window_update_trend (SbWindow* self)
+{
+	GError* error = NULL;
+	gint64  now   = time (NULL);
+
+	if (!gtk_expander_get_expanded (GTK_EXPANDER (self->_private->history)) ||
+	    !self->_private->folder ||
+	    !g_strcmp0 (self->_private->folder, self->_private->sampled))
+	{
+		return;
+	}
+
+	g_free (self->_private->sampled);
+	self->_private->sampled = g_strdup (self->_private->folder);
+
+	if (!sb_trend_start (self->_private->trend,
+			     self->_private->folder,
+			     now - TREND_RANGE, now,
+			     TREND_SAMPLES,
+			     sb_settings_get_flags () & SB_SETTINGS_IGNORE_WHITESPACES,
+			     &error))
+	{
+		g_warning ("couldn't sample the history of %s: %s", self->_private->folder, error->message);
+		g_error_free (error);
+	}
+}
+
+static void
+author_activated_cb (SbOwnershipView* view,
+		     gchar const    * author,
+		     GtkWidget      * window)
+{
+	sb_display_highlight_author (SB_DISPLAY (sb_window_get_display (window)), author, FALSE);
+}
+
+/* the files of the repository of the shown file, or of the one we were
+ * started in */
+static void
+window_quick_open (SbWindow* self)
+{
+	SbRepository* repository;
+	GtkWidget   * dialog;
+	gchar       * folder = self->_private->folder ? g_strdup (self->_private->folder) : g_get_current_dir ();
+
+	repository = sb_repository_lookup (folder);
+	g_free (folder);
+	if (!repository) {
+		return;
+	}
+
+	dialog = sb_quick_open_new (GTK_WINDOW (self), sb_file_index_lookup (repository));
+	if (gtk_dialog_run (GTK_DIALOG (dialog)) == GTK_RESPONSE_ACCEPT) {
+		gchar* path = sb_quick_open_get_path (SB_QUICK_OPEN (dialog));
+
+		if (path) {
+			sb_window_open (GTK_WIDGET (self), path);
+		}
+		g_free (path);
+	}
+	gtk_widget_destroy (dialog);
+}
+
+static void
+file_activated_cb (SbFolderView* view,
+		   gchar const * path,
+		   GtkWidget   * window)
+{
+	sb_window_open (window, path);
 }
 
 static void
@@ -84,6 +461,10 @@ sb_window_init (SbWindow* self)
 	GtkWidget* vbox   = gtk_vbox_new (FALSE, 6);
 	GtkWidget* display;
 	GtkWidget* scrolled;
+	GtkWidget* view;
+	GtkWidget* hbox;
+	GtkWidget* button;
+	GtkAccelGroup* accels = gtk_accel_group_new ();
 
 	self->_private = G_TYPE_INSTANCE_GET_PRIVATE (self,
 						      SB_TYPE_WINDOW,
@@ -105,8 +486,36 @@ sb_window_init (SbWindow* self)
 	g_signal_connect (self->_private->chooser, "selection-changed",
 			  G_CALLBACK (chooser_selection_changed_cb), result);
 	gtk_widget_show    (self->_private->chooser);
+
+	gtk_window_add_accel_group (GTK_WINDOW (result), accels);
+	button = gtk_button_new_with_mnemonic (_("_Quick Open..."));
+	gtk_widget_add_accelerator (button, "clicked", accels,
+				    GDK_p, GDK_CONTROL_MASK, GTK_ACCEL_VISIBLE);
+	g_signal_connect_swapped (button, "clicked",
+				  G_CALLBACK (window_quick_open), self);
+	gtk_widget_show (button);
+	g_object_unref (accels);
+
+	self->_private->back = gtk_button_new_from_stock (GTK_STOCK_GO_BACK);
+	gtk_widget_set_sensitive (self->_private->back, FALSE);
+	gtk_widget_show (self->_private->back);
+
+	hbox = gtk_hbox_new (FALSE, 6);
+	gtk_box_pack_start (GTK_BOX (hbox),
+			    self->_private->back,
+			    FALSE,
+			    FALSE,
+			    0);
+	gtk_box_pack_start_defaults (GTK_BOX (hbox),
+				     self->_private->chooser);
+	gtk_box_pack_start (GTK_BOX (hbox),
+			    button,
+			    FALSE,
+			    FALSE,
+			    0);
+	gtk_widget_show    (hbox);
 	gtk_box_pack_start (GTK_BOX (vbox),
-			    self->_private->chooser,
+			    hbox,
 			    FALSE,
 			    FALSE,
 			    0);
@@ -123,9 +532,104 @@ sb_window_init (SbWindow* self)
 			   G_CALLBACK (display_load_progress_cb), result);
 	g_signal_connect  (display, "load-done",
 			   G_CALLBACK (display_load_done_cb), result);
+	g_signal_connect  (display, "file-changed",
+			   G_CALLBACK (display_file_changed_cb), result);
 	gtk_widget_show   (display);
 	gtk_container_add (GTK_CONTAINER (scrolled),
 			   display);
+	g_signal_connect_swapped (self->_private->back, "clicked",
+				  G_CALLBACK (sb_display_go_back), display);
+
+	self->_private->slider = gtk_hscale_new (NULL);
+	gtk_scale_set_draw_value (GTK_SCALE (self->_private->slider), FALSE);
+	gtk_range_set_increments (GTK_RANGE (self->_private->slider), 1, 1);
+	g_signal_connect (self->_private->slider, "value-changed",
+			  G_CALLBACK (slider_value_changed_cb), self);
+	gtk_widget_show (self->_private->slider);
+
+	self->_private->slider_label = gtk_label_new (NULL);
+	gtk_widget_show (self->_private->slider_label);
+
+	self->_private->slider_box = gtk_hbox_new (FALSE, 6);
+	gtk_box_pack_start_defaults (GTK_BOX (self->_private->slider_box),
+				     self->_private->slider);
+	gtk_box_pack_start (GTK_BOX (self->_private->slider_box),
+			    self->_private->slider_label,
+			    FALSE,
+			    FALSE,
+			    0);
+	gtk_box_pack_start (GTK_BOX (vbox),
+			    self->_private->slider_box,
+			    FALSE,
+			    FALSE,
+			    0);
+
+	self->_private->files = gtk_expander_new (_("Files"));
+	g_signal_connect_swapped (self->_private->files, "notify::expanded",
+				  G_CALLBACK (window_update_files), self);
+	gtk_widget_show (self->_private->files);
+	gtk_box_pack_start (GTK_BOX (vbox),
+			    self->_private->files,
+			    FALSE,
+			    FALSE,
+			    0);
+
+	scrolled = gtk_scrolled_window_new (NULL, NULL);
+	gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled),
+					GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+	gtk_widget_set_size_request (scrolled, -1, 150);
+	gtk_widget_show (scrolled);
+	gtk_container_add (GTK_CONTAINER (self->_private->files),
+			   scrolled);
+
+	self->_private->folder_view = sb_folder_view_new ();
+	g_signal_connect (self->_private->folder_view, "file-activated",
+			  G_CALLBACK (file_activated_cb), result);
+	gtk_widget_show (self->_private->folder_view);
+	gtk_container_add (GTK_CONTAINER (scrolled),
+			   self->_private->folder_view);
+
+	self->_private->contributor = sb_contributor_new ();
+	self->_private->ownership   = gtk_expander_new (_("Ownership"));
+	g_signal_connect_swapped (self->_private->ownership, "notify::expanded",
+				  G_CALLBACK (window_update_ownership), self);
+	gtk_widget_show (self->_private->ownership);
+	gtk_box_pack_start (GTK_BOX (vbox),
+			    self->_private->ownership,
+			    FALSE,
+			    FALSE,
+			    0);
+
+	scrolled = gtk_scrolled_window_new (NULL, NULL);
+	gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled),
+					GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+	gtk_widget_set_size_request (scrolled, -1, 150);
+	gtk_widget_show (scrolled);
+	gtk_container_add (GTK_CONTAINER (self->_private->ownership),
+			   scrolled);
+
+	view = sb_ownership_view_new (self->_private->contributor);
+	g_signal_connect (view, "author-activated",
+			  G_CALLBACK (author_activated_cb), result);
+	gtk_widget_show (view);
+	gtk_container_add (GTK_CONTAINER (scrolled),
+			   view);
+
+	self->_private->trend   = sb_trend_new ();
+	self->_private->history = gtk_expander_new (_("Ownership over Time"));
+	g_signal_connect_swapped (self->_private->history, "notify::expanded",
+				  G_CALLBACK (window_update_trend), self);
+	gtk_widget_show (self->_private->history);
+	gtk_box_pack_start (GTK_BOX (vbox),
+			    self->_private->history,
+			    FALSE,
+			    FALSE,
+			    0);
+
+	view = sb_trend_chart_new (self->_private->trend);
+	gtk_widget_show (view);
+	gtk_container_add (GTK_CONTAINER (self->_private->history),
+			   view);
 
 	self->_private->status = sb_status_bar_new ();
 	gtk_widget_show (self->_private->status);
@@ -161,9 +665,32 @@ sb_window_init (SbWindow* self)
 static void
 window_destroy (GtkObject* object)
 {
-#ifdef HAVE_PLATFORM_OSX
 	SbWindow* self = SB_WINDOW (object);
 
+	if (self->_private->contributor) {
+		sb_contributor_cancel (self->_private->contributor);
+		g_object_unref (self->_private->contributor);
+		self->_private->contributor = NULL;
+	}
+	window_stop_file_history (self);
+	g_free (self->_private->file);
+	self->_private->file = NULL;
+	g_free (self->_private->folder);
+	self->_private->folder = NULL;
+	g_free (self->_private->browsed);
+	self->_private->browsed = NULL;
+	g_free (self->_private->scanned);
+	self->_private->scanned = NULL;
+
+	if (self->_private->trend) {
+		sb_trend_cancel (self->_private->trend);
+		g_object_unref (self->_private->trend);
+		self->_private->trend = NULL;
+	}
+	g_free (self->_private->sampled);
+	self->_private->sampled = NULL;
+
+#ifdef HAVE_PLATFORM_OSX
 	if (self->_private->quit_item) {
 		gtk_widget_destroy (self->_private->quit_item);
 		self->_private->quit_item = NULL;
@@ -252,6 +779,9 @@ sb_window_open (GtkWidget  * window,
 	}
 #endif
 
+	gtk_statusbar_pop (GTK_STATUSBAR (SB_WINDOW (window)->_private->status),
+			   gtk_statusbar_get_context_id (GTK_STATUSBAR (SB_WINDOW (window)->_private->status),
+							 "file-changed"));
 	sb_display_load_path (SB_DISPLAY (sb_window_get_display (window)),
 			      path,
 			      &error);
@@ -262,5 +792,17 @@ sb_window_open (GtkWidget  * window,
 		g_error_free (error);
 		return;
 	}
+
+	if (g_strcmp0 (SB_WINDOW (window)->_private->file, path)) {
+		g_free (SB_WINDOW (window)->_private->file);
+		SB_WINDOW (window)->_private->file = g_strdup (path);
+		window_load_file_history (SB_WINDOW (window));
+	}
+
+	g_free (SB_WINDOW (window)->_private->folder);
+	SB_WINDOW (window)->_private->folder = g_path_get_dirname (path);
+	window_update_files (SB_WINDOW (window));
+	window_update_ownership (SB_WINDOW (window));
+	window_update_trend (SB_WINDOW (window));
 }
 
@@ -23,39 +23,229 @@
  * if advised of the possibility of such damage.
  */
 
-#include <glib.h>
+#include "sb-async-reader.h"
 
-static GMainLoop* loop = NULL;
-static int wrote_messages = 0;
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* Stress test for SbAsyncReader: a child process writes lots of lines in
+ * randomly sized chunks (with some very long and some empty lines and a
+ * missing newline at the end) while the reader has to deliver exactly
+ * these lines without ever blocking the main loop. The consumer pauses
+ * the reader every now and then to exercise the flow control.
+ */
+
+#define N_LINES 200000
+
+typedef struct {
+	GMainLoop    * loop;
+	SbAsyncReader* reader;
+	GRand        * rand;
+	guint          next_line;
+	guint          pauses;
+	guint          ticks;
+	guint          ticks_during_load;
+	gboolean       done;
+	gchar        * expected;
+} Test;
+
+static gsize
+line_length (guint line)
+{
+	if (line % 17 == 0) {
+		return 0;
+	} else if (line % 5000 == 1) {
+		/* longer than the read buffer */
+		return 100000 + line % 1000;
+	}
+
+	return (line * 7919) % 200;
+}
+
+static void
+line_fill (guint  line,
+	   gchar* buffer,
+	   gsize  length)
+{
+	gsize i;
+
+	for (i = 0; i < length; i++) {
+		buffer[i] = 'a' + (line + i) % 26;
+	}
+}
+
+static void
+write_all (gint         fd,
+	   gchar const* buffer,
+	   gsize        length)
+{
+	while (length) {
+		gssize written = write (fd, buffer, length);
+
+		if (written < 0) {
+			g_assert (errno == EINTR);
+			continue;
+		}
+
+		buffer += written;
+		length -= written;
+	}
+}
+
+static void
+writer_run (gint fd)
+{
+	GString* chunk = g_string_new ("");
+	GRand  * rand  = g_rand_new_with_seed (42);
+	gsize    flush = 1;
+	guint    line;
+
+	for (line = 0; line < N_LINES; line++) {
+		gsize length = line_length (line);
+
+		g_string_set_size (chunk, chunk->len + length);
+		line_fill (line, chunk->str + chunk->len - length, length);
+		if (line < N_LINES - 1) {
+			/* the last line doesn't have a newline */
+			g_string_append_c (chunk, '\n');
+		}
+
+		if (chunk->len >= flush) {
+			write_all (fd, chunk->str, chunk->len);
+			g_string_truncate (chunk, 0);
+			flush = g_rand_int_range (rand, 1, 16384);
+		}
+
+		if (line % 10000 == 0) {
+			/* let the reader run dry */
+			g_usleep (10000);
+		}
+	}
+
+	write_all (fd, chunk->str, chunk->len);
+
+	g_string_free (chunk, TRUE);
+	g_rand_free (rand);
+}
 
 static gboolean
-idle_cb (gpointer unused)
+resume_cb (gpointer data)
 {
-	wrote_messages++;
+	Test* test = data;
 
-	if (wrote_messages < 20) {
-		return TRUE;
-	} else {
-		g_main_loop_quit (loop);
-		return FALSE;
+	sb_async_reader_resume (test->reader);
+
+	return FALSE;
+}
+
+static void
+read_lines_cb (SbAsyncReader    * reader,
+	       SbLineBatch const* batch,
+	       Test             * test)
+{
+	guint i;
+
+	g_assert (!test->done);
+
+	for (i = 0; i < batch->n_lines; i++, test->next_line++) {
+		gsize length = line_length (test->next_line);
+
+		g_assert (test->next_line < N_LINES);
+		g_assert_cmpuint (batch->lengths[i], ==, length);
+		g_assert (batch->lines[i][length] == '\0');
+
+		line_fill (test->next_line, test->expected, length);
+		g_assert (!memcmp (batch->lines[i], test->expected, length));
 	}
+
+	test->ticks_during_load = test->ticks;
+
+	if (g_rand_int_range (test->rand, 0, 20) == 0) {
+		/* a slow consumer */
+		test->pauses++;
+		sb_async_reader_pause (reader);
+		g_assert (sb_async_reader_is_paused (reader));
+		g_timeout_add (1, resume_cb, test);
+	}
+}
+
+static void
+done_cb (SbAsyncReader* reader,
+	 Test         * test)
+{
+	test->done = TRUE;
+	g_main_loop_quit (test->loop);
+}
+
+static gboolean
+tick_cb (gpointer data)
+{
+	Test* test = data;
+
+	test->ticks++;
+
+	return TRUE;
 }
 
 int
 main (int   argc,
       char**argv)
 {
-	guint      idle_handler;
+	Test   test = {NULL};
+	gint   fds[2];
+	gint   status;
+	gint   result;
+	pid_t  pid;
+	guint  ticker;
+
+	g_type_init ();
 
-	loop = g_main_loop_new (NULL, FALSE);
-	idle_handler = g_idle_add_full (G_MAXINT,
-					idle_cb,
-					NULL,
-					NULL);
+	result = pipe (fds);
+	g_assert_cmpint (result, ==, 0);
+
+	pid = fork ();
+	g_assert (pid >= 0);
+	if (!pid) {
+		close (fds[0]);
+		writer_run (fds[1]);
+		close (fds[1]);
+		_exit (0);
+	}
+	close (fds[1]);
 
-	g_main_loop_run   (loop);
-	g_main_loop_unref (loop);
+	test.loop     = g_main_loop_new (NULL, FALSE);
+	test.rand     = g_rand_new_with_seed (23);
+	test.expected = g_malloc (line_length (1) + 1000);
+	test.reader   = sb_async_reader_new (fds[0]);
+	g_signal_connect (test.reader, "read-lines",
+			  G_CALLBACK (read_lines_cb), &test);
+	g_signal_connect (test.reader, "done",
+			  G_CALLBACK (done_cb), &test);
+
+	/* proves that the main loop keeps running while we're waiting for data */
+	ticker = g_timeout_add (1, tick_cb, &test);
+
+	g_main_loop_run (test.loop);
+
+	g_source_remove (ticker);
+
+	g_assert (test.done);
+	g_assert (sb_async_reader_is_done (test.reader));
+	g_assert_cmpuint (test.next_line, ==, N_LINES);
+	g_assert_cmpuint (sb_async_reader_get_n_lines (test.reader), ==, N_LINES);
+	g_assert_cmpuint (test.pauses, >, 0);
+	g_assert_cmpuint (test.ticks_during_load, >, 0);
+
+	result = waitpid (pid, &status, 0);
+	g_assert_cmpint (result, ==, pid);
+	g_assert (WIFEXITED (status) && WEXITSTATUS (status) == 0);
+
+	g_object_unref  (test.reader);
+	g_main_loop_unref (test.loop);
+	g_rand_free     (test.rand);
+	g_free          (test.expected);
 
 	return 0;
 }
-
@@ -0,0 +1,178 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <herzi@gnome-de.org>
+ *
+ * Copyright (C) 2007  Sven Herzberg
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+
+#include "sb-hunk.h"
+
+/* Checks the parsing of the hunk headers of "git diff -U0" and the mapping
+ * of new lines to old ones against diffs made up line by line, where each
+ * new line knows where it came from.
+ */
+
+#define N_LINES 100
+#define N_DIFFS 2000
+
+typedef struct {
+	GArray* hunks;    /* of SbHunk */
+	guint   n_lines;  /* on the new side */
+	/* the old line of each new one, 1-based; a hunk adds at most three
+	 * lines after at least one unchanged line */
+	guint   expected[4 * N_LINES + 4];
+} Diff;
+
+static void
+test_parse (gchar const* line,
+	    guint        old_start,
+	    guint        old_count,
+	    guint        new_start,
+	    guint        new_count)
+{
+	SbHunk hunk;
+
+	g_assert (sb_hunk_parse (line, &hunk));
+	g_assert_cmpuint (hunk.old_start, ==, old_start);
+	g_assert_cmpuint (hunk.old_count, ==, old_count);
+	g_assert_cmpuint (hunk.new_start, ==, new_start);
+	g_assert_cmpuint (hunk.new_count, ==, new_count);
+}
+
+/* @old_count old lines after @old (the last line before the hunk) become
+ * @new_count new lines */
+static void
+diff_add_hunk (Diff * diff,
+	       guint  old,
+	       guint  old_count,
+	       guint  new_count)
+{
+	SbHunk hunk;
+	guint  i;
+
+	/* an empty side names the line before it, like git does */
+	hunk.old_start = old + (old_count ? 1 : 0);
+	hunk.old_count = old_count;
+	hunk.new_start = diff->n_lines + (new_count ? 1 : 0);
+	hunk.new_count = new_count;
+	g_array_append_val (diff->hunks, hunk);
+
+	for (i = 0; i < new_count; i++) {
+		/* changed lines keep their offset, added ones go to the last
+		 * replaced line or the one they were added after */
+		diff->expected[++diff->n_lines] = MAX (i < old_count ? old + 1 + i :
+						       old_count ? old + old_count : old,
+						       1);
+	}
+}
+
+static void
+diff_check (Diff const* diff)
+{
+	guint line;
+
+	for (line = 1; line <= diff->n_lines; line++) {
+		g_assert_cmpuint (sb_hunk_map_to_old ((SbHunk const*)diff->hunks->data, diff->hunks->len, line),
+				  ==, diff->expected[line]);
+	}
+}
+
+int
+main (int   argc,
+      char**argv)
+{
+	SbHunk hunk;
+	Diff   diff;
+	GRand* rand;
+	guint  i;
+
+	/* omitted counts are 1 */
+	test_parse ("@@ -12,3 +14,5 @@", 12, 3, 14, 5);
+	test_parse ("@@ -12 +14 @@", 12, 1, 14, 1);
+	test_parse ("@@ -12 +14,2 @@", 12, 1, 14, 2);
+	test_parse ("@@ -12,2 +14 @@ static void", 12, 2, 14, 1);
+	/* additions and deletions name the line before them */
+	test_parse ("@@ -7,0 +8,2 @@", 7, 0, 8, 2);
+	test_parse ("@@ -8,2 +7,0 @@", 8, 2, 7, 0);
+	test_parse ("@@ -0,0 +1,3 @@", 0, 0, 1, 3);
+	test_parse ("@@ -1,3 +0,0 @@", 1, 3, 0, 0);
+
+	g_assert (!sb_hunk_parse ("", &hunk));
+	g_assert (!sb_hunk_parse ("diff --git a/x b/x", &hunk));
+	g_assert (!sb_hunk_parse ("@@@ -1,2 -1,2 +1,3 @@@", &hunk));
+	g_assert (!sb_hunk_parse ("@@ -12,3 14,5 @@", &hunk));
+
+	/* a deletion comes after its start line */
+	g_assert (sb_hunk_parse ("@@ -8,2 +7,0 @@", &hunk));
+	g_assert_cmpuint (sb_hunk_get_last (&hunk), ==, 7);
+	g_assert (sb_hunk_parse ("@@ -7,0 +8,2 @@", &hunk));
+	g_assert_cmpuint (sb_hunk_get_last (&hunk), ==, 9);
+
+	diff.hunks = g_array_new (FALSE, FALSE, sizeof (SbHunk));
+
+	/* lines added at the start have no line before them */
+	diff.n_lines = 0;
+	diff_add_hunk (&diff, 0, 0, 2);
+	diff.expected[++diff.n_lines] = 1;
+	diff_check (&diff);
+
+	/* lines deleted at the start */
+	g_array_set_size (diff.hunks, 0);
+	diff.n_lines = 0;
+	diff_add_hunk (&diff, 0, 2, 0);
+	diff.expected[++diff.n_lines] = 3;
+	diff_check (&diff);
+
+	/* no hunks */
+	g_assert_cmpuint (sb_hunk_map_to_old (NULL, 0, 5), ==, 5);
+
+	/* random diffs: unchanged runs, then a hunk; with -U0, only the first
+	 * hunk may come without unchanged lines before it */
+	rand = g_rand_new_with_seed (42);
+	for (i = 0; i < N_DIFFS; i++) {
+		guint old = 0;
+
+		g_array_set_size (diff.hunks, 0);
+		diff.n_lines = 0;
+
+		while (old < N_LINES) {
+			guint n_same    = g_rand_int_range (rand, old || diff.n_lines ? 1 : 0, 6);
+			guint old_count = g_rand_int_range (rand, 0, 4);
+			guint new_count = g_rand_int_range (rand, 0, 4);
+
+			for (; n_same && old < N_LINES; n_same--) {
+				diff.expected[++diff.n_lines] = ++old;
+			}
+
+			old_count = MIN (old_count, N_LINES - old);
+			if (old_count || new_count) {
+				diff_add_hunk (&diff, old, old_count, new_count);
+				old += old_count;
+			}
+		}
+		diff_check (&diff);
+	}
+	g_rand_free (rand);
+
+	g_array_free (diff.hunks, TRUE);
+
+	return 0;
+}
@@ -0,0 +1,164 @@
+/* This file is part of source browser
+ *
+ * AUTHORS
+ *     Sven Herzberg  <herzi@gnome-de.org>
+ *
+ * Copyright (C) 2007  Sven Herzberg
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+
+#include "sb-line-map.h"
+
+/* Checks SbLineMap against a plain array that keeps the current line of
+ * every original line and gets updated line by line on each edit.
+ */
+
+#define N_LINES 100
+#define N_EDITS 5000
+
+typedef struct {
+	SbLineMap* map;
+	guint      lines[N_LINES + 1];   /* 1-based */
+} Test;
+
+static void
+test_insert (Test * test,
+	     guint  line,
+	     guint  n_lines)
+{
+	guint original;
+
+	sb_line_map_insert (test->map, line, n_lines);
+	for (original = 1; original <= N_LINES; original++) {
+		if (test->lines[original] > line) {
+			test->lines[original] += n_lines;
+		}
+	}
+}
+
+static void
+test_delete (Test * test,
+	     guint  line,
+	     guint  n_lines)
+{
+	guint original;
+
+	sb_line_map_delete (test->map, line, n_lines);
+	for (original = 1; original <= N_LINES; original++) {
+		if (test->lines[original] > line + n_lines) {
+			test->lines[original] -= n_lines;
+		} else if (test->lines[original] > line) {
+			test->lines[original] = line;
+		}
+	}
+}
+
+static void
+test_check (Test const* test)
+{
+	guint original;
+	guint line;
+
+	for (original = 1; original <= N_LINES; original++) {
+		g_assert_cmpuint (sb_line_map_get_line (test->map, original), ==, test->lines[original]);
+	}
+
+	/* the last original line at or before each line */
+	for (line = 0, original = 0; line <= test->lines[N_LINES] + 2; line++) {
+		while (original < N_LINES && test->lines[original + 1] <= line) {
+			original++;
+		}
+		g_assert_cmpuint (sb_line_map_get_original (test->map, line), ==, original);
+	}
+}
+
+static void
+test_reset (Test* test)
+{
+	guint original;
+
+	if (test->map) {
+		sb_line_map_free (test->map);
+	}
+
+	test->map = sb_line_map_new (N_LINES);
+	for (original = 0; original <= N_LINES; original++) {
+		test->lines[original] = original;
+	}
+}
+
+int
+main (int   argc,
+      char**argv)
+{
+	Test  test = {NULL};
+	GRand* rand;
+	guint  i;
+
+	/* a delete spanning inserted lines */
+	test_reset  (&test);
+	test_insert (&test, 10, 5);
+	test_check  (&test);
+	test_delete (&test, 8, 10);
+	test_check  (&test);
+	g_assert_cmpuint (sb_line_map_get_line (test.map, 11), ==, 8);
+	g_assert_cmpuint (sb_line_map_get_line (test.map, 14), ==, 9);
+
+	/* deletes at the end of the file */
+	test_reset  (&test);
+	test_delete (&test, N_LINES - 1, 1);
+	test_check  (&test);
+	test_delete (&test, N_LINES - 3, 5);
+	test_check  (&test);
+	test_insert (&test, N_LINES - 4, 3);
+	test_check  (&test);
+	test_delete (&test, N_LINES - 5, 10);
+	test_check  (&test);
+	g_assert_cmpuint (sb_line_map_get_line (test.map, N_LINES), ==, N_LINES - 5);
+
+	/* everything after the first line */
+	test_reset  (&test);
+	test_delete (&test, 1, N_LINES - 1);
+	test_check  (&test);
+
+	/* random edits, with the deletes often spanning earlier inserts */
+	test_reset (&test);
+	rand = g_rand_new_with_seed (42);
+	for (i = 0; i < N_EDITS; i++) {
+		guint n_current = test.lines[N_LINES] + 1;
+		guint line      = g_rand_int_range (rand, 1, n_current + 1);
+
+		if (g_rand_boolean (rand)) {
+			test_insert (&test, line, g_rand_int_range (rand, 1, 8));
+		} else if (line < n_current) {
+			test_delete (&test, line, g_rand_int_range (rand, 1, MIN (n_current - line, 12) + 1));
+		}
+		test_check (&test);
+
+		/* start over before the file shrinks to nothing */
+		if (test.lines[N_LINES] < N_LINES / 4) {
+			test_reset (&test);
+		}
+	}
+	g_rand_free (rand);
+
+	sb_line_map_free (test.map);
+
+	return 0;
+}